@@ -0,0 +1,80 @@
+/**
+ * Reports the memory that the helpers of a CommandList allocate when they are
+ * created: the UploadBuffer and the DynamicDescriptorHeap. The CommandList
+ * creates them the first time they are needed (see CommandList::GetUploadBuffer
+ * and CommandList::GetDynamicDescriptorHeap), before that it only pays for the
+ * std::unique_ptrs.
+ *
+ * The CommandList itself (and the ResourceStateTracker) can't be compiled
+ * without the Windows SDK, so the per command list totals are computed from
+ * the sizes of the helpers. The bytes are counted by replacing the global
+ * operator new, so they are the sizes of the libstdc++ containers on Linux.
+ */
+
+#include <DX12LibPCH.h>
+
+#include <Application.h>
+#include <DynamicDescriptorHeap.h>
+#include <UploadBuffer.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// The number of bytes that were allocated with operator new.
+static size_t gs_NumAllocatedBytes = 0;
+
+void* operator new(size_t size)
+{
+    gs_NumAllocatedBytes += size;
+
+    if (void* ptr = std::malloc(size))
+    {
+        return ptr;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+// Returns the number of bytes that are allocated with operator new to create
+// an object of type T (including the object itself).
+template<typename T, typename... Args>
+static size_t MeasureCreate(Args&&... args)
+{
+    size_t numAllocatedBytes = gs_NumAllocatedBytes;
+    auto object = std::make_unique<T>(std::forward<Args>(args)...);
+
+    return gs_NumAllocatedBytes - numAllocatedBytes;
+}
+
+int main()
+{
+    // Create the Application (and its fake device) first, so that it isn't counted.
+    Application::Get();
+
+    const size_t uploadBufferBytes = MeasureCreate<UploadBuffer>(_2MB);
+    const size_t dynamicDescriptorHeapBytes = MeasureCreate<DynamicDescriptorHeap>(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    printf("%-40s %10zu bytes (sizeof %zu)\n", "UploadBuffer", uploadBufferBytes, sizeof(UploadBuffer));
+    printf("%-40s %10zu bytes (sizeof %zu)\n", "DynamicDescriptorHeap", dynamicDescriptorHeapBytes, sizeof(DynamicDescriptorHeap));
+
+    // Before the helpers were created lazily, every command list created the
+    // upload buffer and a dynamic descriptor heap for each heap type.
+    printf("\nper command list, without the ResourceStateTracker:\n");
+    printf("%-40s %10zu bytes\n", "eager (all heap types)",
+        uploadBufferBytes + D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES * dynamicDescriptorHeapBytes);
+    printf("%-40s %10zu bytes\n", "lazy, copy or clear only", size_t(0));
+    printf("%-40s %10zu bytes\n", "lazy, draw or dispatch", uploadBufferBytes + dynamicDescriptorHeapBytes);
+
+    return 0;
+}
@@ -0,0 +1,242 @@
+/**
+ * Measures the throughput of allocating and freeing single CPU visible
+ * descriptors from multiple threads.
+ *
+ * The DescriptorAllocator (thread local magazines refilled from slab pages) is
+ * compared to a baseline that serializes all allocations on one allocator
+ * wide mutex, like the DescriptorAllocator did before the magazines were
+ * added. The baseline uses the same DescriptorAllocatorPage, so only the
+ * synchronization differs.
+ *
+ * Each thread allocates a batch of descriptors and then frees them. A fence
+ * thread plays the GPU: it signals the fake fence and releases the stale
+ * descriptors once per simulated frame.
+ */
+
+#include <DX12LibPCH.h>
+
+#include "FakeApplication.h"
+
+#include <Application.h>
+#include <DescriptorAllocator.h>
+#include <DescriptorAllocatorPage.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+// The number of descriptors that a thread allocates before it frees them.
+static const uint32_t BatchSize = 64;
+// The total number of descriptors that are allocated (and freed) by all threads.
+static const uint64_t NumDescriptorsPerRun = 8 * 1024 * 1024;
+// The time between two simulated frames.
+static const std::chrono::microseconds FrameTime(500);
+// The best run is reported.
+static const int NumRuns = 3;
+
+static const uint32_t NumDescriptorsPerHeap = 256;
+
+// Allocates single descriptors under one allocator wide mutex.
+class GlobalMutexDescriptorAllocator
+{
+public:
+    struct Allocation
+    {
+        DescriptorAllocatorPage* Page;
+        DescriptorAllocatorPage::OffsetType Offset;
+    };
+
+    Allocation Allocate()
+    {
+        std::lock_guard lock(m_AllocationMutex);
+
+        for (auto iter = m_AvailablePages.begin(); iter != m_AvailablePages.end();)
+        {
+            auto& page = m_Pages[*iter];
+
+            DescriptorAllocatorPage::OffsetType offset;
+            uint32_t numAllocated = page->AllocateSingleDescriptors(1, &offset);
+
+            if (page->NumFreeHandles() == 0)
+            {
+                iter = m_AvailablePages.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+
+            if (numAllocated == 1)
+            {
+                return { page.get(), offset };
+            }
+        }
+
+        m_Pages.push_back(std::make_unique<DescriptorAllocatorPage>(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, NumDescriptorsPerHeap));
+        m_AvailablePages.insert(m_Pages.size() - 1);
+
+        DescriptorAllocatorPage::OffsetType offset;
+        m_Pages.back()->AllocateSingleDescriptors(1, &offset);
+
+        return { m_Pages.back().get(), offset };
+    }
+
+    // Only takes the lock of the page.
+    void Free(const Allocation& allocation, const FenceTag& fenceTag)
+    {
+        allocation.Page->Free(allocation.Offset, 1, fenceTag);
+    }
+
+    void ReleaseStaleDescriptors(const FenceTag& completedFenceValues)
+    {
+        std::lock_guard lock(m_AllocationMutex);
+
+        for (size_t i = 0; i < m_Pages.size(); ++i)
+        {
+            m_Pages[i]->ReleaseStaleDescriptors(completedFenceValues);
+
+            if (m_Pages[i]->NumFreeHandles() > 0)
+            {
+                m_AvailablePages.insert(i);
+            }
+        }
+    }
+
+    size_t GetNumPages() const
+    {
+        return m_Pages.size();
+    }
+
+private:
+    std::vector< std::unique_ptr<DescriptorAllocatorPage> > m_Pages;
+    std::set<size_t> m_AvailablePages;
+    std::mutex m_AllocationMutex;
+};
+
+static void AllocateAndFree(DescriptorAllocator& allocator, uint64_t numBatches)
+{
+    std::vector<DescriptorAllocation> allocations(BatchSize);
+
+    for (uint64_t batch = 0; batch < numBatches; ++batch)
+    {
+        for (auto& allocation : allocations)
+        {
+            allocation = allocator.Allocate(1);
+        }
+
+        // Free the descriptors in the order they were allocated.
+        for (auto& allocation : allocations)
+        {
+            allocation = DescriptorAllocation();
+        }
+    }
+}
+
+static void AllocateAndFree(GlobalMutexDescriptorAllocator& allocator, uint64_t numBatches)
+{
+    std::vector<GlobalMutexDescriptorAllocator::Allocation> allocations(BatchSize);
+
+    for (uint64_t batch = 0; batch < numBatches; ++batch)
+    {
+        for (auto& allocation : allocations)
+        {
+            allocation = allocator.Allocate();
+        }
+
+        FenceTag fenceTag = Application::Get().GetNextFenceTag();
+        for (auto& allocation : allocations)
+        {
+            allocator.Free(allocation, fenceTag);
+        }
+    }
+}
+
+static void EndFrame(DescriptorAllocator& allocator)
+{
+    allocator.ReleaseStaleDescriptors(SignalFakeFence());
+    allocator.TrimIdlePages();
+}
+
+static void EndFrame(GlobalMutexDescriptorAllocator& allocator)
+{
+    allocator.ReleaseStaleDescriptors(SignalFakeFence());
+}
+
+// Returns the number of allocations (and frees) per second.
+template<typename Allocator>
+static double Run(Allocator& allocator, uint32_t numThreads)
+{
+    const uint64_t numBatchesPerThread = NumDescriptorsPerRun / BatchSize / numThreads;
+
+    std::atomic<bool> isDone = false;
+    std::thread fenceThread([&]()
+    {
+        while (!isDone)
+        {
+            std::this_thread::sleep_for(FrameTime);
+            EndFrame(allocator);
+        }
+    });
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < numThreads; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            AllocateAndFree(allocator, numBatchesPerThread);
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+
+    isDone = true;
+    fenceThread.join();
+
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+    return static_cast<double>(numBatchesPerThread * BatchSize * numThreads) / seconds;
+}
+
+int main()
+{
+    const uint32_t maxThreads = std::max(8u, std::thread::hardware_concurrency());
+
+    printf("hardware threads: %u\n\n", std::thread::hardware_concurrency());
+    printf("%8s %22s %22s %8s\n", "threads", "global mutex Mallocs/s", "magazines Mallocs/s", "speedup");
+
+    // The allocators are kept between runs, so only the first run creates pages.
+    GlobalMutexDescriptorAllocator globalMutexAllocator;
+    DescriptorAllocator magazineAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, NumDescriptorsPerHeap);
+
+    for (uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+    {
+        double globalMutexThroughput = 0.0;
+        double magazineThroughput = 0.0;
+
+        for (int run = 0; run < NumRuns; ++run)
+        {
+            globalMutexThroughput = std::max(globalMutexThroughput, Run(globalMutexAllocator, numThreads));
+            magazineThroughput = std::max(magazineThroughput, Run(magazineAllocator, numThreads));
+        }
+
+        printf("%8u %22.2f %22.2f %8.2f\n", numThreads, globalMutexThroughput * 1e-6, magazineThroughput * 1e-6,
+            magazineThroughput / globalMutexThroughput);
+    }
+
+    printf("\nglobal mutex pages: %zu\n", globalMutexAllocator.GetNumPages());
+
+    auto stats = magazineAllocator.GetStats();
+    printf("magazine allocator pages: %u\n", stats.NumPages);
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+/**
+ * Measures how much DescriptorAllocator::Compact reduces the fragmentation
+ * of the descriptor pages, using the DescriptorAllocatorStats.
+ *
+ * Two allocators receive the same sequence of range allocations and frees
+ * (random sizes, half of the ranges are freed). One of them is compacted once
+ * per frame within a budget, the other one is not. Afterwards both allocators
+ * allocate a number of large ranges and the pages that had to be created for
+ * them are counted.
+ */
+
+#include <DX12LibPCH.h>
+
+#include "FakeApplication.h"
+
+#include <Application.h>
+#include <DescriptorAllocator.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static const uint32_t NumDescriptorsPerHeap = 1024;
+// The number of descriptors that are allocated in ranges before half of the ranges are freed.
+static const uint32_t NumDescriptorsToAllocate = 64 * NumDescriptorsPerHeap;
+static const uint32_t MinRangeSize = 2;
+static const uint32_t MaxRangeSize = 32;
+// The maximum number of descriptors that are relocated per frame.
+static const uint32_t CompactionBudget = 1024;
+static const uint32_t NumFrames = 64;
+// The size and number of the ranges that are allocated after the frames.
+static const uint32_t LargeRangeSize = 256;
+static const uint32_t NumLargeRanges = 64;
+
+struct Fragmentation
+{
+    uint32_t NumPages;
+    uint32_t NumFreeHandles;
+    // The sum of the largest free blocks of the pages.
+    uint32_t NumLargestFreeBlockDescriptors;
+    // The number of free blocks that are smaller than LargeRangeSize.
+    uint32_t NumSmallFreeBlocks;
+};
+
+static Fragmentation GetFragmentation(DescriptorAllocator& allocator)
+{
+    DescriptorAllocatorStats stats = allocator.GetStats();
+
+    Fragmentation fragmentation = {};
+    for (const auto& page : stats.Pages)
+    {
+        if (page.IsSlab || page.IsRetired)
+            continue;
+
+        fragmentation.NumPages++;
+        fragmentation.NumFreeHandles += page.NumFreeHandles;
+        fragmentation.NumLargestFreeBlockDescriptors += page.LargestFreeBlock;
+
+        // Bucket i counts the free blocks with a size in [2^i, 2^(i+1)).
+        for (uint32_t i = 0; (2u << i) <= LargeRangeSize && i < NumFreeBlockHistogramBuckets; ++i)
+        {
+            fragmentation.NumSmallFreeBlocks += page.FreeBlockHistogram[i];
+        }
+    }
+
+    return fragmentation;
+}
+
+static void PrintFragmentation(const char* name, const Fragmentation& fragmentation)
+{
+    printf("%-22s %6u %10u %22u %18.1f%% %18u\n", name, fragmentation.NumPages, fragmentation.NumFreeHandles,
+        fragmentation.NumLargestFreeBlockDescriptors,
+        100.0 * (fragmentation.NumFreeHandles - fragmentation.NumLargestFreeBlockDescriptors) / fragmentation.NumFreeHandles,
+        fragmentation.NumSmallFreeBlocks);
+}
+
+// Release the stale descriptors of the previous frame.
+static void EndFrame(DescriptorAllocator& allocator)
+{
+    allocator.ReleaseStaleDescriptors(SignalFakeFence());
+}
+
+int main()
+{
+    DescriptorAllocator allocators[2] = {
+        DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, NumDescriptorsPerHeap),
+        DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, NumDescriptorsPerHeap)
+    };
+    DescriptorAllocator& uncompacted = allocators[0];
+    DescriptorAllocator& compacted = allocators[1];
+
+    std::vector<DescriptorAllocation> ranges[2];
+
+    // Allocate ranges of random sizes and free half of them.
+    std::mt19937 random(1);
+    std::uniform_int_distribution<uint32_t> rangeSize(MinRangeSize, MaxRangeSize);
+
+    for (uint32_t numAllocated = 0; numAllocated < NumDescriptorsToAllocate;)
+    {
+        uint32_t numDescriptors = rangeSize(random);
+        ranges[0].push_back(uncompacted.Allocate(numDescriptors));
+        ranges[1].push_back(compacted.Allocate(numDescriptors));
+        numAllocated += numDescriptors;
+    }
+
+    for (size_t i = 0; i < ranges[0].size(); ++i)
+    {
+        if (random() % 2)
+        {
+            ranges[0][i] = DescriptorAllocation();
+            ranges[1][i] = DescriptorAllocation();
+        }
+    }
+
+    EndFrame(uncompacted);
+    EndFrame(compacted);
+
+    printf("%-22s %6s %10s %22s %19s %18s\n", "", "pages", "free", "largest free blocks", "fragmented", "blocks < 256");
+    PrintFragmentation("before", GetFragmentation(compacted));
+
+    // Compact one of the allocators once per frame.
+    uint32_t numMovedDescriptors = 0;
+    double compactSeconds = 0.0;
+
+    for (uint32_t frame = 0; frame < NumFrames; ++frame)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        numMovedDescriptors += compacted.Compact(CompactionBudget, Application::Get().GetNextFenceTag());
+        auto t1 = std::chrono::steady_clock::now();
+        compactSeconds += std::chrono::duration<double>(t1 - t0).count();
+
+        EndFrame(uncompacted);
+        EndFrame(compacted);
+    }
+
+    PrintFragmentation("without Compact", GetFragmentation(uncompacted));
+    PrintFragmentation("with Compact", GetFragmentation(compacted));
+
+    printf("\nmoved %u descriptors in %u frames (budget %u per frame) in %.2f ms, %.1f ns per descriptor\n",
+        numMovedDescriptors, NumFrames, CompactionBudget, compactSeconds * 1e3,
+        compactSeconds * 1e9 / std::max(numMovedDescriptors, 1u));
+
+    // Allocate large ranges and count the pages that had to be created.
+    printf("\nnew pages for %u ranges of %u descriptors:\n", NumLargeRanges, LargeRangeSize);
+
+    const char* names[2] = { "without Compact", "with Compact" };
+    for (int i = 0; i < 2; ++i)
+    {
+        uint32_t numPages = GetFragmentation(allocators[i]).NumPages;
+
+        for (uint32_t j = 0; j < NumLargeRanges; ++j)
+        {
+            ranges[i].push_back(allocators[i].Allocate(LargeRangeSize));
+        }
+
+        printf("%-22s %6u\n", names[i], GetFragmentation(allocators[i]).NumPages - numPages);
+    }
+
+    return 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * Measures the CPU cost of staging and committing descriptor tables for each
+ * draw with the DynamicDescriptorHeap, and counts the CopyDescriptors calls
+ * that are made for each draw.
+ *
+ * The root signature has one per-frame descriptor table that is staged once
+ * per frame and three descriptor tables that are staged with different
+ * descriptors for every draw, so the three tables are copied to the GPU
+ * visible heap for every draw. The descriptors are copied with memcpy by the
+ * fake device (see Platform/d3d12.h), which is much cheaper than the copy of
+ * a D3D12 driver, so the number of CopyDescriptors calls is the number that
+ * carries over to D3D12.
+ */
+
+#include <DX12LibPCH.h>
+
+#include "FakeApplication.h"
+
+#include <Application.h>
+#include <CommandList.h>
+#include <DescriptorRing.h>
+#include <DynamicDescriptorHeap.h>
+#include <RootSignature.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+static const uint32_t NumDrawsPerFrame = 4000;
+static const uint32_t NumFramesPerRun = 50;
+// The minimum and the median of the runs are reported.
+static const int NumRuns = 21;
+
+// The root parameters of the root signature.
+enum RootParameters
+{
+    PerDrawConstants,   // 32-bit constants.
+    PerFrameTable,      // 1 CBV, staged once per frame.
+    MaterialTable,      // 4 SRVs, staged for every draw.
+    ObjectTable,        // 1 CBV and 2 SRVs, staged for every draw.
+    OutputTable,        // 2 UAVs, staged for every draw.
+    NumRootParameters
+};
+
+static const uint32_t NumMaterialDescriptors = 4;
+static const uint32_t NumObjectDescriptors = 3;
+static const uint32_t NumOutputDescriptors = 2;
+static const uint32_t NumDescriptorsPerDraw = NumMaterialDescriptors + NumObjectDescriptors + NumOutputDescriptors;
+
+static RootSignature CreateRootSignature()
+{
+    D3D12_DESCRIPTOR_RANGE1 perFrameRange = { D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_NONE, 0 };
+    D3D12_DESCRIPTOR_RANGE1 materialRange = { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, NumMaterialDescriptors, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_NONE, 0 };
+    D3D12_DESCRIPTOR_RANGE1 objectRanges[2] = {
+        { D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 1, 0, D3D12_DESCRIPTOR_RANGE_FLAG_NONE, 0 },
+        { D3D12_DESCRIPTOR_RANGE_TYPE_SRV, NumObjectDescriptors - 1, 4, 0, D3D12_DESCRIPTOR_RANGE_FLAG_NONE, 1 }
+    };
+    D3D12_DESCRIPTOR_RANGE1 outputRange = { D3D12_DESCRIPTOR_RANGE_TYPE_UAV, NumOutputDescriptors, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_NONE, 0 };
+
+    D3D12_ROOT_PARAMETER1 rootParameters[NumRootParameters] = {};
+    rootParameters[PerDrawConstants].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    rootParameters[PerDrawConstants].Constants = { 0, 0, 4 };
+
+    rootParameters[PerFrameTable].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    rootParameters[PerFrameTable].DescriptorTable = { 1, &perFrameRange };
+
+    rootParameters[MaterialTable].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    rootParameters[MaterialTable].DescriptorTable = { 1, &materialRange };
+
+    rootParameters[ObjectTable].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    rootParameters[ObjectTable].DescriptorTable = { 2, objectRanges };
+
+    rootParameters[OutputTable].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    rootParameters[OutputTable].DescriptorTable = { 1, &outputRange };
+
+    D3D12_ROOT_SIGNATURE_DESC1 rootSignatureDesc = { NumRootParameters, rootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE };
+
+    return RootSignature(rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1_1);
+}
+
+struct FrameResult
+{
+    double Seconds;
+    uint64_t NumCopyDescriptorsCalls;
+    uint64_t NumCopiedDescriptors;
+};
+
+// Records one frame of draws and returns the time that was spent staging and
+// committing the descriptors.
+static FrameResult RecordFrame(DynamicDescriptorHeap& dynamicDescriptorHeap, const RootSignature& rootSignature,
+    D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptors)
+{
+    auto& application = Application::Get();
+    auto device = application.GetDevice();
+    const UINT descriptorSize = application.GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    CommandList commandList;
+
+    uint64_t numCopyDescriptorsCalls = device->NumCopyDescriptorsCalls;
+    uint64_t numCopiedDescriptors = device->NumCopiedDescriptors;
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    dynamicDescriptorHeap.SetRootSignature(rootSignature);
+    dynamicDescriptorHeap.StageDescriptors(PerFrameTable, 0, 1, srcDescriptors);
+
+    // Every draw uses different descriptors, so none of the tables are reused.
+    CD3DX12_CPU_DESCRIPTOR_HANDLE drawDescriptors(srcDescriptors, 1, descriptorSize);
+    for (uint32_t draw = 0; draw < NumDrawsPerFrame; ++draw)
+    {
+        dynamicDescriptorHeap.StageDescriptors(MaterialTable, 0, NumMaterialDescriptors, drawDescriptors);
+        drawDescriptors.Offset(NumMaterialDescriptors, descriptorSize);
+        dynamicDescriptorHeap.StageDescriptors(ObjectTable, 0, NumObjectDescriptors, drawDescriptors);
+        drawDescriptors.Offset(NumObjectDescriptors, descriptorSize);
+        dynamicDescriptorHeap.StageDescriptors(OutputTable, 0, NumOutputDescriptors, drawDescriptors);
+        drawDescriptors.Offset(NumOutputDescriptors, descriptorSize);
+
+        dynamicDescriptorHeap.CommitStagedDescriptorsForDraw(commandList);
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+
+    // The chunks are returned to the descriptor ring and can be reused once
+    // the fake fence is signaled.
+    dynamicDescriptorHeap.Reset();
+    application.GetDescriptorRing(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).ReleaseStaleDescriptors(SignalFakeFence());
+
+    return { std::chrono::duration<double>(t1 - t0).count(),
+             device->NumCopyDescriptorsCalls - numCopyDescriptorsCalls,
+             device->NumCopiedDescriptors - numCopiedDescriptors };
+}
+
+int main()
+{
+    RootSignature rootSignature = CreateRootSignature();
+
+    // The CPU visible descriptors that are staged: one per-frame descriptor
+    // and the descriptors of every draw.
+    auto srcDescriptorHeap = Application::Get().CreateDescriptorHeap(1 + NumDrawsPerFrame * NumDescriptorsPerDraw,
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptors = srcDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+
+    DynamicDescriptorHeap dynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+    // Warm up (creates the descriptor heaps of the ring).
+    RecordFrame(dynamicDescriptorHeap, rootSignature, srcDescriptors);
+
+    std::vector<double> nsPerDraw;
+    FrameResult frameResult = {};
+
+    for (int run = 0; run < NumRuns; ++run)
+    {
+        double seconds = 0.0;
+        for (uint32_t frame = 0; frame < NumFramesPerRun; ++frame)
+        {
+            frameResult = RecordFrame(dynamicDescriptorHeap, rootSignature, srcDescriptors);
+            seconds += frameResult.Seconds;
+        }
+
+        nsPerDraw.push_back(seconds * 1e9 / (NumFramesPerRun * NumDrawsPerFrame));
+    }
+
+    std::sort(nsPerDraw.begin(), nsPerDraw.end());
+
+    printf("%u draws per frame, %u frames per run, %d runs\n", NumDrawsPerFrame, NumFramesPerRun, NumRuns);
+    printf("CopyDescriptors calls per draw: %.2f\n", static_cast<double>(frameResult.NumCopyDescriptorsCalls) / NumDrawsPerFrame);
+    printf("descriptors copied per draw: %.2f\n", static_cast<double>(frameResult.NumCopiedDescriptors) / NumDrawsPerFrame);
+    printf("ns per draw: min %.1f, median %.1f, max %.1f\n", nsPerDraw.front(), nsPerDraw[nsPerDraw.size() / 2], nsPerDraw.back());
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <DX12LibPCH.h>
+
+#include "FakeApplication.h"
+
+#include <Application.h>
+#include <BindlessDescriptorHeap.h>
+#include <CommandQueue.h>
+#include <DescriptorAllocator.h>
+#include <DescriptorRing.h>
+#include <LinearDescriptorAllocator.h>
+#include <SamplerHeap.h>
+
+#include <atomic>
+
+uint64_t Application::ms_FrameCount = 0;
+
+// The value that is signaled next on the fake fence.
+static std::atomic<uint64_t> gs_NextFenceValue = 1;
+
+FenceTag SignalFakeFence()
+{
+    uint64_t completedFenceValue = gs_NextFenceValue.fetch_add(1);
+
+    FenceTag completedFenceValues;
+    for (auto& fenceValue : completedFenceValues.FenceValues)
+    {
+        fenceValue = completedFenceValue;
+    }
+
+    return completedFenceValues;
+}
+
+Application::Application(HINSTANCE hInst)
+    : m_hInstance(hInst)
+    , m_DescriptorCompactionBudget(0)
+    , m_TearingSupported(false)
+{
+    *m_d3d12Device.GetAddressOf() = new ID3D12Device2();
+}
+
+Application::~Application()
+{}
+
+Application& Application::Get()
+{
+    static Application application(nullptr);
+    return application;
+}
+
+ComPtr<ID3D12Device2> Application::GetDevice() const
+{
+    return m_d3d12Device;
+}
+
+ComPtr<ID3D12DescriptorHeap> Application::CreateDescriptorHeap(UINT numDescriptors, D3D12_DESCRIPTOR_HEAP_TYPE type)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+    desc.Type = type;
+    desc.NumDescriptors = numDescriptors;
+    desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    desc.NodeMask = 0;
+
+    ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+    ThrowIfFailed(m_d3d12Device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&descriptorHeap)));
+
+    return descriptorHeap;
+}
+
+UINT Application::GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE type) const
+{
+    return m_d3d12Device->GetDescriptorHandleIncrementSize(type);
+}
+
+DescriptorRing& Application::GetDescriptorRing(D3D12_DESCRIPTOR_HEAP_TYPE type)
+{
+    assert(type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV && "Only shader visible descriptor heap types have a descriptor ring.");
+
+    // The ring is created on first use, since the DescriptorRing needs the
+    // Application. It has the same size as the ring of the real Application
+    // (including the space for the bindless descriptors).
+    if (!m_DescriptorRings[type])
+    {
+        m_DescriptorRings[type] = std::make_unique<DescriptorRing>(type, 32768, 65536);
+    }
+
+    return *m_DescriptorRings[type];
+}
+
+FenceTag Application::GetNextFenceTag() const
+{
+    uint64_t nextFenceValue = gs_NextFenceValue.load();
+
+    FenceTag fenceTag;
+    for (auto& fenceValue : fenceTag.FenceValues)
+    {
+        fenceValue = nextFenceValue;
+    }
+
+    return fenceTag;
+}
+
+bool Application::HasOpenCommandLists() const
+{
+    return false;
+}
+
+// The command queues are not created by the fake Application. The upload
+// rings that are created by the benchmarks only read the fence values.
+uint64_t CommandQueue::GetNextFenceValue() const
+{
+    return gs_NextFenceValue.load();
+}
+
+uint64_t CommandQueue::GetCompletedFenceValue() const
+{
+    return gs_NextFenceValue.load() - 1;
+}
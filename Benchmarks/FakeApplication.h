@@ -0,0 +1,21 @@
+#pragma once
+
+/**
+ *  @file FakeApplication.h
+ *
+ *  @brief The parts of the Application class that are used by the benchmarked
+ *  sources of MyDX12Lib are implemented in FakeApplication.cpp on top of the
+ *  fake device in Platform/d3d12.h.
+ *
+ *  The command queues are replaced by a single fake fence. Application::GetNextFenceTag
+ *  returns the value that is signaled next for all of the queues.
+ */
+
+#include <FenceTag.h>
+
+/**
+ * Signal the fake fence and complete all of the work that was tagged with
+ * Application::GetNextFenceTag so far.
+ * @return The completed fence values of the command queues.
+ */
+FenceTag SignalFakeFence();
@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ *  @file CommandList.h
+ *
+ *  @brief Replacement for MyDX12Lib/inc/CommandList.h that is used by the
+ *  benchmarks. The real CommandList can't be compiled without the Windows SDK
+ *  (and the Texture and Buffer classes), so this one only implements the
+ *  methods that the DynamicDescriptorHeap calls. It records no commands.
+ */
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+
+class CommandList
+{
+public:
+    CommandList()
+        : m_DescriptorHeaps{}
+        , m_NumDescriptorHeapChanges(0)
+    {
+        *m_d3d12CommandList.GetAddressOf() = new ID3D12GraphicsCommandList2();
+    }
+
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> GetGraphicsCommandList() const
+    {
+        return m_d3d12CommandList;
+    }
+
+    void SetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE heapType, ID3D12DescriptorHeap* heap)
+    {
+        if (m_DescriptorHeaps[heapType] != heap)
+        {
+            m_DescriptorHeaps[heapType] = heap;
+            m_NumDescriptorHeapChanges++;
+        }
+    }
+
+    // The number of times that a different descriptor heap was set.
+    uint32_t GetNumDescriptorHeapChanges() const
+    {
+        return m_NumDescriptorHeapChanges;
+    }
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> m_d3d12CommandList;
+    ID3D12DescriptorHeap* m_DescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+    uint32_t m_NumDescriptorHeapChanges;
+};
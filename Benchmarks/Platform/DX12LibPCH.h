@@ -0,0 +1,30 @@
+#pragma once
+
+/**
+ *  @file DX12LibPCH.h
+ *
+ *  @brief Replacement for MyDX12Lib/inc/DX12LibPCH.h that is used by the
+ *  benchmarks. The Windows and Direct3D 12 headers are replaced by the fake
+ *  ones in this directory, so that the sources of MyDX12Lib that only use
+ *  descriptor heaps and upload heaps can be compiled on Linux.
+ */
+
+#include <Windows.h>
+
+// Windows Runtime Library. Needed for Microsoft::WRL::ComPtr<> template class.
+#include <wrl.h>
+using namespace Microsoft::WRL;
+
+// DirectX 12 specific headers.
+#include <d3d12.h>
+#include <dxgi1_6.h>
+
+// STL Headers
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <map>
+#include <memory>
+
+// Helper functions
+#include <Helpers.h>
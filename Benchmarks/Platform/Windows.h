@@ -0,0 +1,52 @@
+#pragma once
+
+/**
+ *  @file Windows.h
+ *
+ *  @brief The Windows types that are used by MyDX12Lib, for the Linux builds
+ *  of the benchmarks.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+typedef long HRESULT;
+typedef int BOOL;
+typedef int INT;
+typedef long LONG;
+typedef unsigned int UINT;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint64_t UINT64;
+typedef int64_t INT64;
+typedef unsigned long DWORD;
+typedef size_t SIZE_T;
+typedef float FLOAT;
+typedef void* HANDLE;
+typedef void* HINSTANCE;
+typedef void* HWND;
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM;
+typedef intptr_t LRESULT;
+
+#define CALLBACK
+#define TRUE 1
+#define FALSE 0
+
+#define S_OK ((HRESULT)0)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+
+// The fake COM objects don't implement QueryInterface, so the interface
+// pointer is passed on its own.
+#define IID_PPV_ARGS(ppType) (ppType)
+
+inline unsigned char _BitScanForward(unsigned long* index, unsigned long mask)
+{
+    if (mask == 0)
+        return 0;
+
+    *index = static_cast<unsigned long>(__builtin_ctzl(mask));
+    return 1;
+}
@@ -0,0 +1,703 @@
+#pragma once
+
+/**
+ *  @file d3d12.h
+ *
+ *  @brief A fake Direct3D 12 device for the Linux builds of the benchmarks.
+ *
+ *  Only the types and methods that are used by the benchmarked sources of
+ *  MyDX12Lib are declared. Descriptor heaps are backed by system memory
+ *  (32 bytes per descriptor) and the descriptors are copied with memcpy, so
+ *  the cost of copying descriptors is part of the measurements. Committed
+ *  resources are backed by (write-back) system memory as well.
+ *
+ *  The helpers of d3dx12.h that are used by MyDX12Lib are declared here as
+ *  well, since the real d3dx12.h requires the Windows SDK.
+ */
+
+#include "Windows.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+// The real d3dx12.h is skipped (see the CD3DX12 helpers below).
+#define __D3DX12_H__
+
+#define D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE 2048
+
+enum DXGI_FORMAT
+{
+    DXGI_FORMAT_UNKNOWN = 0,
+};
+
+enum D3D12_DESCRIPTOR_HEAP_TYPE
+{
+    D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV = 0,
+    D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER,
+    D3D12_DESCRIPTOR_HEAP_TYPE_RTV,
+    D3D12_DESCRIPTOR_HEAP_TYPE_DSV,
+    D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES
+};
+
+enum D3D12_DESCRIPTOR_HEAP_FLAGS
+{
+    D3D12_DESCRIPTOR_HEAP_FLAG_NONE = 0,
+    D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE = 0x1
+};
+
+enum D3D12_COMMAND_LIST_TYPE
+{
+    D3D12_COMMAND_LIST_TYPE_DIRECT = 0,
+    D3D12_COMMAND_LIST_TYPE_BUNDLE = 1,
+    D3D12_COMMAND_LIST_TYPE_COMPUTE = 2,
+    D3D12_COMMAND_LIST_TYPE_COPY = 3
+};
+
+#define D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT 65536
+#define D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT 256
+
+enum D3D12_HEAP_TYPE
+{
+    D3D12_HEAP_TYPE_DEFAULT = 1,
+    D3D12_HEAP_TYPE_UPLOAD = 2,
+    D3D12_HEAP_TYPE_READBACK = 3
+};
+
+enum D3D12_HEAP_FLAGS
+{
+    D3D12_HEAP_FLAG_NONE = 0
+};
+
+enum D3D12_RESOURCE_STATES
+{
+    D3D12_RESOURCE_STATE_COMMON = 0,
+    D3D12_RESOURCE_STATE_GENERIC_READ = 0xac3
+};
+
+struct D3D12_HEAP_PROPERTIES
+{
+    D3D12_HEAP_TYPE Type;
+};
+
+struct D3D12_RESOURCE_DESC
+{
+    UINT64 Width;
+};
+
+struct D3D12_CLEAR_VALUE;
+
+struct D3D12_CPU_DESCRIPTOR_HANDLE
+{
+    SIZE_T ptr;
+};
+
+struct D3D12_GPU_DESCRIPTOR_HANDLE
+{
+    UINT64 ptr;
+};
+
+typedef UINT64 D3D12_GPU_VIRTUAL_ADDRESS;
+
+struct D3D12_DESCRIPTOR_HEAP_DESC
+{
+    D3D12_DESCRIPTOR_HEAP_TYPE Type;
+    UINT NumDescriptors;
+    D3D12_DESCRIPTOR_HEAP_FLAGS Flags;
+    UINT NodeMask;
+};
+
+/**
+ * View descriptions. Only the layout is needed (for the hashers in Helpers.h).
+ */
+
+enum D3D12_SRV_DIMENSION
+{
+    D3D12_SRV_DIMENSION_UNKNOWN = 0,
+    D3D12_SRV_DIMENSION_BUFFER = 1,
+    D3D12_SRV_DIMENSION_TEXTURE1D = 2,
+    D3D12_SRV_DIMENSION_TEXTURE1DARRAY = 3,
+    D3D12_SRV_DIMENSION_TEXTURE2D = 4,
+    D3D12_SRV_DIMENSION_TEXTURE2DARRAY = 5,
+    D3D12_SRV_DIMENSION_TEXTURE2DMS = 6,
+    D3D12_SRV_DIMENSION_TEXTURE2DMSARRAY = 7,
+    D3D12_SRV_DIMENSION_TEXTURE3D = 8,
+    D3D12_SRV_DIMENSION_TEXTURECUBE = 9,
+    D3D12_SRV_DIMENSION_TEXTURECUBEARRAY = 10,
+    D3D12_SRV_DIMENSION_RAYTRACING_ACCELERATION_STRUCTURE = 11
+};
+
+enum D3D12_BUFFER_SRV_FLAGS
+{
+    D3D12_BUFFER_SRV_FLAG_NONE = 0,
+    D3D12_BUFFER_SRV_FLAG_RAW = 0x1
+};
+
+struct D3D12_SHADER_RESOURCE_VIEW_DESC
+{
+    DXGI_FORMAT Format;
+    D3D12_SRV_DIMENSION ViewDimension;
+    UINT Shader4ComponentMapping;
+    union
+    {
+        struct { UINT64 FirstElement; UINT NumElements; UINT StructureByteStride; D3D12_BUFFER_SRV_FLAGS Flags; } Buffer;
+        struct { UINT MostDetailedMip; UINT MipLevels; FLOAT ResourceMinLODClamp; } Texture1D;
+        struct { UINT MostDetailedMip; UINT MipLevels; UINT FirstArraySlice; UINT ArraySize; FLOAT ResourceMinLODClamp; } Texture1DArray;
+        struct { UINT MostDetailedMip; UINT MipLevels; UINT PlaneSlice; FLOAT ResourceMinLODClamp; } Texture2D;
+        struct { UINT MostDetailedMip; UINT MipLevels; UINT FirstArraySlice; UINT ArraySize; UINT PlaneSlice; FLOAT ResourceMinLODClamp; } Texture2DArray;
+        struct { UINT UnusedField_NothingToDefine; } Texture2DMS;
+        struct { UINT FirstArraySlice; UINT ArraySize; } Texture2DMSArray;
+        struct { UINT MostDetailedMip; UINT MipLevels; FLOAT ResourceMinLODClamp; } Texture3D;
+        struct { UINT MostDetailedMip; UINT MipLevels; FLOAT ResourceMinLODClamp; } TextureCube;
+        struct { UINT MostDetailedMip; UINT MipLevels; UINT First2DArrayFace; UINT NumCubes; FLOAT ResourceMinLODClamp; } TextureCubeArray;
+        struct { D3D12_GPU_VIRTUAL_ADDRESS Location; } RaytracingAccelerationStructure;
+    };
+};
+
+enum D3D12_UAV_DIMENSION
+{
+    D3D12_UAV_DIMENSION_UNKNOWN = 0,
+    D3D12_UAV_DIMENSION_BUFFER = 1,
+    D3D12_UAV_DIMENSION_TEXTURE1D = 2,
+    D3D12_UAV_DIMENSION_TEXTURE1DARRAY = 3,
+    D3D12_UAV_DIMENSION_TEXTURE2D = 4,
+    D3D12_UAV_DIMENSION_TEXTURE2DARRAY = 5,
+    D3D12_UAV_DIMENSION_TEXTURE3D = 8
+};
+
+enum D3D12_BUFFER_UAV_FLAGS
+{
+    D3D12_BUFFER_UAV_FLAG_NONE = 0,
+    D3D12_BUFFER_UAV_FLAG_RAW = 0x1
+};
+
+struct D3D12_UNORDERED_ACCESS_VIEW_DESC
+{
+    DXGI_FORMAT Format;
+    D3D12_UAV_DIMENSION ViewDimension;
+    union
+    {
+        struct { UINT64 FirstElement; UINT NumElements; UINT StructureByteStride; UINT64 CounterOffsetInBytes; D3D12_BUFFER_UAV_FLAGS Flags; } Buffer;
+        struct { UINT MipSlice; } Texture1D;
+        struct { UINT MipSlice; UINT FirstArraySlice; UINT ArraySize; } Texture1DArray;
+        struct { UINT MipSlice; UINT PlaneSlice; } Texture2D;
+        struct { UINT MipSlice; UINT FirstArraySlice; UINT ArraySize; UINT PlaneSlice; } Texture2DArray;
+        struct { UINT MipSlice; UINT FirstWSlice; UINT WSize; } Texture3D;
+    };
+};
+
+enum D3D12_FILTER
+{
+    D3D12_FILTER_MIN_MAG_MIP_POINT = 0,
+    D3D12_FILTER_MIN_MAG_MIP_LINEAR = 0x15
+};
+
+enum D3D12_TEXTURE_ADDRESS_MODE
+{
+    D3D12_TEXTURE_ADDRESS_MODE_WRAP = 1,
+    D3D12_TEXTURE_ADDRESS_MODE_CLAMP = 3
+};
+
+enum D3D12_COMPARISON_FUNC
+{
+    D3D12_COMPARISON_FUNC_NEVER = 1,
+    D3D12_COMPARISON_FUNC_ALWAYS = 8
+};
+
+struct D3D12_SAMPLER_DESC
+{
+    D3D12_FILTER Filter;
+    D3D12_TEXTURE_ADDRESS_MODE AddressU;
+    D3D12_TEXTURE_ADDRESS_MODE AddressV;
+    D3D12_TEXTURE_ADDRESS_MODE AddressW;
+    FLOAT MipLODBias;
+    UINT MaxAnisotropy;
+    D3D12_COMPARISON_FUNC ComparisonFunc;
+    FLOAT BorderColor[4];
+    FLOAT MinLOD;
+    FLOAT MaxLOD;
+};
+
+/**
+ * Root signature descriptions (for the RootSignature class).
+ */
+
+enum D3D12_SHADER_VISIBILITY
+{
+    D3D12_SHADER_VISIBILITY_ALL = 0,
+    D3D12_SHADER_VISIBILITY_VERTEX = 1,
+    D3D12_SHADER_VISIBILITY_PIXEL = 5
+};
+
+enum D3D12_DESCRIPTOR_RANGE_TYPE
+{
+    D3D12_DESCRIPTOR_RANGE_TYPE_SRV = 0,
+    D3D12_DESCRIPTOR_RANGE_TYPE_UAV,
+    D3D12_DESCRIPTOR_RANGE_TYPE_CBV,
+    D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER
+};
+
+enum D3D12_DESCRIPTOR_RANGE_FLAGS
+{
+    D3D12_DESCRIPTOR_RANGE_FLAG_NONE = 0,
+    D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE = 0x1,
+    D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE = 0x2,
+    D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE = 0x4,
+    D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC = 0x8
+};
+
+struct D3D12_DESCRIPTOR_RANGE1
+{
+    D3D12_DESCRIPTOR_RANGE_TYPE RangeType;
+    UINT NumDescriptors;
+    UINT BaseShaderRegister;
+    UINT RegisterSpace;
+    D3D12_DESCRIPTOR_RANGE_FLAGS Flags;
+    UINT OffsetInDescriptorsFromTableStart;
+};
+
+struct D3D12_ROOT_DESCRIPTOR_TABLE1
+{
+    UINT NumDescriptorRanges;
+    const D3D12_DESCRIPTOR_RANGE1* pDescriptorRanges;
+};
+
+struct D3D12_ROOT_CONSTANTS
+{
+    UINT ShaderRegister;
+    UINT RegisterSpace;
+    UINT Num32BitValues;
+};
+
+enum D3D12_ROOT_PARAMETER_TYPE
+{
+    D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE = 0,
+    D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS,
+    D3D12_ROOT_PARAMETER_TYPE_CBV,
+    D3D12_ROOT_PARAMETER_TYPE_SRV,
+    D3D12_ROOT_PARAMETER_TYPE_UAV
+};
+
+struct D3D12_ROOT_PARAMETER1
+{
+    D3D12_ROOT_PARAMETER_TYPE ParameterType;
+    union
+    {
+        D3D12_ROOT_DESCRIPTOR_TABLE1 DescriptorTable;
+        D3D12_ROOT_CONSTANTS Constants;
+    };
+    D3D12_SHADER_VISIBILITY ShaderVisibility;
+};
+
+struct D3D12_STATIC_SAMPLER_DESC
+{
+    D3D12_FILTER Filter;
+    D3D12_TEXTURE_ADDRESS_MODE AddressU;
+    D3D12_TEXTURE_ADDRESS_MODE AddressV;
+    D3D12_TEXTURE_ADDRESS_MODE AddressW;
+    FLOAT MipLODBias;
+    UINT MaxAnisotropy;
+    D3D12_COMPARISON_FUNC ComparisonFunc;
+    UINT BorderColor;
+    FLOAT MinLOD;
+    FLOAT MaxLOD;
+    UINT ShaderRegister;
+    UINT RegisterSpace;
+    D3D12_SHADER_VISIBILITY ShaderVisibility;
+};
+
+enum D3D12_ROOT_SIGNATURE_FLAGS
+{
+    D3D12_ROOT_SIGNATURE_FLAG_NONE = 0,
+    D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT = 0x1
+};
+
+struct D3D12_ROOT_SIGNATURE_DESC1
+{
+    UINT NumParameters;
+    const D3D12_ROOT_PARAMETER1* pParameters;
+    UINT NumStaticSamplers;
+    const D3D12_STATIC_SAMPLER_DESC* pStaticSamplers;
+    D3D12_ROOT_SIGNATURE_FLAGS Flags;
+};
+
+enum D3D_ROOT_SIGNATURE_VERSION
+{
+    D3D_ROOT_SIGNATURE_VERSION_1 = 0x1,
+    D3D_ROOT_SIGNATURE_VERSION_1_0 = 0x1,
+    D3D_ROOT_SIGNATURE_VERSION_1_1 = 0x2
+};
+
+struct D3D12_VERSIONED_ROOT_SIGNATURE_DESC
+{
+    D3D_ROOT_SIGNATURE_VERSION Version;
+    D3D12_ROOT_SIGNATURE_DESC1 Desc_1_1;
+};
+
+/**
+ * Fake COM objects. Objects are created with a reference count of one and
+ * deleted when the last reference is released.
+ */
+
+struct IUnknown
+{
+    virtual ~IUnknown() = default;
+
+    unsigned long AddRef()
+    {
+        return ++m_RefCount;
+    }
+
+    unsigned long Release()
+    {
+        unsigned long refCount = --m_RefCount;
+        if (refCount == 0)
+        {
+            delete this;
+        }
+
+        return refCount;
+    }
+
+private:
+    std::atomic<unsigned long> m_RefCount = 1;
+};
+
+struct ID3D12Object : IUnknown
+{
+    HRESULT SetName(const wchar_t*)
+    {
+        return S_OK;
+    }
+};
+
+// The size of a descriptor in the fake descriptor heaps.
+static const UINT FakeDescriptorSize = 32;
+
+struct ID3D12DescriptorHeap : ID3D12Object
+{
+    explicit ID3D12DescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC& desc)
+        : m_Desc(desc)
+        , m_Descriptors(new uint8_t[static_cast<size_t>(desc.NumDescriptors) * FakeDescriptorSize]())
+    {}
+
+    D3D12_DESCRIPTOR_HEAP_DESC GetDesc() const
+    {
+        return m_Desc;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandleForHeapStart() const
+    {
+        return { reinterpret_cast<SIZE_T>(m_Descriptors.get()) };
+    }
+
+    // The GPU handles are the same addresses as the CPU handles.
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandleForHeapStart() const
+    {
+        return { reinterpret_cast<UINT64>(m_Descriptors.get()) };
+    }
+
+private:
+    D3D12_DESCRIPTOR_HEAP_DESC m_Desc;
+    std::unique_ptr<uint8_t[]> m_Descriptors;
+};
+
+// Resources are backed by system memory and are always mapped. The GPU
+// virtual address is the address of the memory.
+struct ID3D12Resource : ID3D12Object
+{
+    explicit ID3D12Resource(UINT64 width)
+        : m_Memory(static_cast<uint8_t*>(std::aligned_alloc(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+            AlignResourceSize(width))))
+    {}
+
+    ~ID3D12Resource() override
+    {
+        std::free(m_Memory);
+    }
+
+    D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const
+    {
+        return reinterpret_cast<D3D12_GPU_VIRTUAL_ADDRESS>(m_Memory);
+    }
+
+    HRESULT Map(UINT, const void*, void** data)
+    {
+        if (data)
+        {
+            *data = m_Memory;
+        }
+
+        return S_OK;
+    }
+
+    void Unmap(UINT, const void*) {}
+
+private:
+    static size_t AlignResourceSize(UINT64 width)
+    {
+        const size_t alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+        return static_cast<size_t>((width + alignment - 1) / alignment * alignment);
+    }
+
+    uint8_t* m_Memory;
+};
+
+// Root signatures are not serialized, so the blobs are empty.
+struct ID3DBlob : IUnknown
+{
+    void* GetBufferPointer()
+    {
+        return nullptr;
+    }
+
+    SIZE_T GetBufferSize() const
+    {
+        return 0;
+    }
+};
+
+struct ID3D12RootSignature : ID3D12Object {};
+struct ID3D12Fence : ID3D12Object {};
+struct ID3D12CommandQueue : ID3D12Object {};
+struct ID3D12CommandAllocator : ID3D12Object {};
+
+struct ID3D12GraphicsCommandList : ID3D12Object
+{
+    void SetDescriptorHeaps(UINT, ID3D12DescriptorHeap* const*) {}
+    void SetGraphicsRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) {}
+    void SetComputeRootDescriptorTable(UINT, D3D12_GPU_DESCRIPTOR_HANDLE) {}
+};
+
+struct ID3D12GraphicsCommandList2 : ID3D12GraphicsCommandList {};
+
+struct ID3D12Device : ID3D12Object
+{
+    HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* desc, ID3D12DescriptorHeap** heap)
+    {
+        *heap = new ID3D12DescriptorHeap(*desc);
+        return S_OK;
+    }
+
+    HRESULT CreateCommittedResource(const D3D12_HEAP_PROPERTIES*, D3D12_HEAP_FLAGS, const D3D12_RESOURCE_DESC* desc,
+        D3D12_RESOURCE_STATES, const D3D12_CLEAR_VALUE*, ID3D12Resource** resource)
+    {
+        *resource = new ID3D12Resource(desc->Width);
+        return S_OK;
+    }
+
+    HRESULT CreateRootSignature(UINT, const void*, SIZE_T, ID3D12RootSignature** rootSignature)
+    {
+        *rootSignature = new ID3D12RootSignature();
+        return S_OK;
+    }
+
+    UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE) const
+    {
+        return FakeDescriptorSize;
+    }
+
+    void CopyDescriptorsSimple(UINT numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptorRangeStart,
+        D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptorRangeStart, D3D12_DESCRIPTOR_HEAP_TYPE)
+    {
+        memmove(reinterpret_cast<void*>(destDescriptorRangeStart.ptr), reinterpret_cast<const void*>(srcDescriptorRangeStart.ptr),
+            static_cast<size_t>(numDescriptors) * FakeDescriptorSize);
+    }
+
+    void CopyDescriptors(UINT numDestDescriptorRanges, const D3D12_CPU_DESCRIPTOR_HANDLE* destDescriptorRangeStarts,
+        const UINT* destDescriptorRangeSizes, UINT numSrcDescriptorRanges,
+        const D3D12_CPU_DESCRIPTOR_HANDLE* srcDescriptorRangeStarts, const UINT* srcDescriptorRangeSizes,
+        D3D12_DESCRIPTOR_HEAP_TYPE)
+    {
+        NumCopyDescriptorsCalls++;
+
+        // Copy one descriptor at a time, so that the source and destination
+        // ranges do not need to line up.
+        UINT srcRange = 0;
+        UINT srcIndex = 0;
+
+        for (UINT destRange = 0; destRange < numDestDescriptorRanges; ++destRange)
+        {
+            UINT destSize = destDescriptorRangeSizes ? destDescriptorRangeSizes[destRange] : 1;
+
+            for (UINT destIndex = 0; destIndex < destSize && srcRange < numSrcDescriptorRanges; ++destIndex)
+            {
+                SIZE_T dest = destDescriptorRangeStarts[destRange].ptr + static_cast<SIZE_T>(destIndex) * FakeDescriptorSize;
+                SIZE_T src = srcDescriptorRangeStarts[srcRange].ptr + static_cast<SIZE_T>(srcIndex) * FakeDescriptorSize;
+                memcpy(reinterpret_cast<void*>(dest), reinterpret_cast<const void*>(src), FakeDescriptorSize);
+                NumCopiedDescriptors++;
+
+                UINT srcSize = srcDescriptorRangeSizes ? srcDescriptorRangeSizes[srcRange] : 1;
+                if (++srcIndex == srcSize)
+                {
+                    ++srcRange;
+                    srcIndex = 0;
+                }
+            }
+        }
+    }
+
+    // The number of CopyDescriptors calls and the number of descriptors that
+    // were copied by them. Only the DynamicDescriptorHeap calls CopyDescriptors,
+    // and its benchmark records on one thread, so they are not synchronized.
+    UINT64 NumCopyDescriptorsCalls = 0;
+    UINT64 NumCopiedDescriptors = 0;
+};
+
+struct ID3D12Device2 : ID3D12Device {};
+
+/**
+ * The helpers of d3dx12.h that are used by MyDX12Lib.
+ */
+
+struct CD3DX12_DEFAULT {};
+inline constexpr CD3DX12_DEFAULT D3D12_DEFAULT;
+
+struct CD3DX12_CPU_DESCRIPTOR_HANDLE : D3D12_CPU_DESCRIPTOR_HANDLE
+{
+    CD3DX12_CPU_DESCRIPTOR_HANDLE() = default;
+
+    explicit CD3DX12_CPU_DESCRIPTOR_HANDLE(const D3D12_CPU_DESCRIPTOR_HANDLE& o)
+        : D3D12_CPU_DESCRIPTOR_HANDLE(o)
+    {}
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE(CD3DX12_DEFAULT)
+    {
+        ptr = 0;
+    }
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE(const D3D12_CPU_DESCRIPTOR_HANDLE& other, INT offsetScaledByIncrementSize)
+    {
+        ptr = other.ptr + offsetScaledByIncrementSize;
+    }
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE(const D3D12_CPU_DESCRIPTOR_HANDLE& other, INT offsetInDescriptors, UINT descriptorIncrementSize)
+    {
+        ptr = other.ptr + static_cast<INT64>(offsetInDescriptors) * descriptorIncrementSize;
+    }
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE& Offset(INT offsetInDescriptors, UINT descriptorIncrementSize)
+    {
+        ptr += static_cast<INT64>(offsetInDescriptors) * descriptorIncrementSize;
+        return *this;
+    }
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE& Offset(INT offsetScaledByIncrementSize)
+    {
+        ptr += offsetScaledByIncrementSize;
+        return *this;
+    }
+
+    bool operator==(const D3D12_CPU_DESCRIPTOR_HANDLE& other) const
+    {
+        return ptr == other.ptr;
+    }
+
+    bool operator!=(const D3D12_CPU_DESCRIPTOR_HANDLE& other) const
+    {
+        return ptr != other.ptr;
+    }
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE& operator=(const D3D12_CPU_DESCRIPTOR_HANDLE& other)
+    {
+        ptr = other.ptr;
+        return *this;
+    }
+};
+
+struct CD3DX12_GPU_DESCRIPTOR_HANDLE : D3D12_GPU_DESCRIPTOR_HANDLE
+{
+    CD3DX12_GPU_DESCRIPTOR_HANDLE() = default;
+
+    explicit CD3DX12_GPU_DESCRIPTOR_HANDLE(const D3D12_GPU_DESCRIPTOR_HANDLE& o)
+        : D3D12_GPU_DESCRIPTOR_HANDLE(o)
+    {}
+
+    CD3DX12_GPU_DESCRIPTOR_HANDLE(CD3DX12_DEFAULT)
+    {
+        ptr = 0;
+    }
+
+    CD3DX12_GPU_DESCRIPTOR_HANDLE(const D3D12_GPU_DESCRIPTOR_HANDLE& other, INT offsetScaledByIncrementSize)
+    {
+        ptr = other.ptr + offsetScaledByIncrementSize;
+    }
+
+    CD3DX12_GPU_DESCRIPTOR_HANDLE(const D3D12_GPU_DESCRIPTOR_HANDLE& other, INT offsetInDescriptors, UINT descriptorIncrementSize)
+    {
+        ptr = other.ptr + static_cast<INT64>(offsetInDescriptors) * descriptorIncrementSize;
+    }
+
+    CD3DX12_GPU_DESCRIPTOR_HANDLE& Offset(INT offsetInDescriptors, UINT descriptorIncrementSize)
+    {
+        ptr += static_cast<INT64>(offsetInDescriptors) * descriptorIncrementSize;
+        return *this;
+    }
+
+    CD3DX12_GPU_DESCRIPTOR_HANDLE& Offset(INT offsetScaledByIncrementSize)
+    {
+        ptr += offsetScaledByIncrementSize;
+        return *this;
+    }
+
+    bool operator==(const D3D12_GPU_DESCRIPTOR_HANDLE& other) const
+    {
+        return ptr == other.ptr;
+    }
+
+    bool operator!=(const D3D12_GPU_DESCRIPTOR_HANDLE& other) const
+    {
+        return ptr != other.ptr;
+    }
+
+    CD3DX12_GPU_DESCRIPTOR_HANDLE& operator=(const D3D12_GPU_DESCRIPTOR_HANDLE& other)
+    {
+        ptr = other.ptr;
+        return *this;
+    }
+};
+
+struct CD3DX12_HEAP_PROPERTIES : D3D12_HEAP_PROPERTIES
+{
+    explicit CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE type)
+    {
+        Type = type;
+    }
+};
+
+struct CD3DX12_RESOURCE_DESC : D3D12_RESOURCE_DESC
+{
+    static CD3DX12_RESOURCE_DESC Buffer(UINT64 width)
+    {
+        CD3DX12_RESOURCE_DESC desc;
+        desc.Width = width;
+        return desc;
+    }
+};
+
+struct CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC : D3D12_VERSIONED_ROOT_SIGNATURE_DESC
+{
+    void Init_1_1(UINT numParameters, const D3D12_ROOT_PARAMETER1* parameters, UINT numStaticSamplers,
+        const D3D12_STATIC_SAMPLER_DESC* staticSamplers, D3D12_ROOT_SIGNATURE_FLAGS flags)
+    {
+        Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
+        Desc_1_1.NumParameters = numParameters;
+        Desc_1_1.pParameters = parameters;
+        Desc_1_1.NumStaticSamplers = numStaticSamplers;
+        Desc_1_1.pStaticSamplers = staticSamplers;
+        Desc_1_1.Flags = flags;
+    }
+};
+
+inline HRESULT D3DX12SerializeVersionedRootSignature(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC*, D3D_ROOT_SIGNATURE_VERSION,
+    ID3DBlob** blob, ID3DBlob** errorBlob)
+{
+    *blob = new ID3DBlob();
+    if (errorBlob)
+    {
+        *errorBlob = nullptr;
+    }
+
+    return S_OK;
+}
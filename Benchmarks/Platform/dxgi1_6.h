@@ -0,0 +1,12 @@
+#pragma once
+
+/**
+ *  @file dxgi1_6.h
+ *
+ *  @brief The DXGI interfaces that are named in the headers of MyDX12Lib.
+ */
+
+#include "d3d12.h"
+
+struct IDXGIAdapter4 : IUnknown {};
+struct IDXGISwapChain4 : IUnknown {};
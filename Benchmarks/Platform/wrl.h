@@ -0,0 +1,100 @@
+#pragma once
+
+/**
+ *  @file wrl.h
+ *
+ *  @brief A minimal Microsoft::WRL::ComPtr for the fake COM objects in d3d12.h.
+ */
+
+#include <utility>
+
+namespace Microsoft
+{
+namespace WRL
+{
+
+template<typename T>
+class ComPtr
+{
+public:
+    template<typename U>
+    friend class ComPtr;
+
+    ComPtr() = default;
+
+    ComPtr(std::nullptr_t) {}
+
+    ComPtr(T* ptr)
+        : m_Ptr(ptr)
+    {
+        InternalAddRef();
+    }
+
+    ComPtr(const ComPtr& other)
+        : m_Ptr(other.m_Ptr)
+    {
+        InternalAddRef();
+    }
+
+    template<typename U>
+    ComPtr(const ComPtr<U>& other)
+        : m_Ptr(other.m_Ptr)
+    {
+        InternalAddRef();
+    }
+
+    ComPtr(ComPtr&& other) noexcept
+        : m_Ptr(std::exchange(other.m_Ptr, nullptr))
+    {}
+
+    ~ComPtr()
+    {
+        InternalRelease();
+    }
+
+    ComPtr& operator=(ComPtr other)
+    {
+        std::swap(m_Ptr, other.m_Ptr);
+        return *this;
+    }
+
+    T* Get() const { return m_Ptr; }
+    T* operator->() const { return m_Ptr; }
+    explicit operator bool() const { return m_Ptr != nullptr; }
+
+    T* const* GetAddressOf() const { return &m_Ptr; }
+    T** GetAddressOf() { return &m_Ptr; }
+
+    // Like the ComPtrRef of WRL, taking the address releases the interface.
+    T** operator&()
+    {
+        InternalRelease();
+        return &m_Ptr;
+    }
+
+    void Reset()
+    {
+        InternalRelease();
+    }
+
+    bool operator==(const ComPtr& other) const { return m_Ptr == other.m_Ptr; }
+    bool operator!=(const ComPtr& other) const { return m_Ptr != other.m_Ptr; }
+
+private:
+    void InternalAddRef()
+    {
+        if (m_Ptr)
+            m_Ptr->AddRef();
+    }
+
+    void InternalRelease()
+    {
+        if (T* ptr = std::exchange(m_Ptr, nullptr))
+            ptr->Release();
+    }
+
+    T* m_Ptr = nullptr;
+};
+
+}
+}
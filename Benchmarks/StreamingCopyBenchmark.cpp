@@ -0,0 +1,105 @@
+/**
+ * Compares the throughput of StreamingCopy and memcpy for copies from 64 bytes
+ * to 8 MB.
+ *
+ * The destination moves linearly through a region that is larger than the
+ * last level cache, like the allocations of an UploadBuffer move through its
+ * pages, so every copy writes memory that is not in the cache. The source is
+ * reused and stays in the cache, like the CPU data that is uploaded.
+ *
+ * On Linux the destination is write-back memory, not the write-combined
+ * memory of a mapped upload heap, so memcpy is not penalized here for the
+ * partial writes that make it slow on an upload heap.
+ */
+
+#include <StreamingCopy.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Size of the region the destination moves through.
+static const size_t DestinationSize = 64 * 1024 * 1024;
+// Number of bytes that are copied per measurement.
+static const size_t BytesPerTrial = 256 * 1024 * 1024;
+// The best trial is reported.
+static const int NumTrials = 5;
+
+using CopyFunction = void (*)(void* dst, const void* src, size_t sizeInBytes);
+
+static void Memcpy(void* dst, const void* src, size_t sizeInBytes)
+{
+    memcpy(dst, src, sizeInBytes);
+}
+
+// Returns the throughput in GB/s.
+static double Measure(CopyFunction copy, uint8_t* dst, const uint8_t* src, size_t sizeInBytes)
+{
+    const size_t numCopies = std::max<size_t>(BytesPerTrial / sizeInBytes, 1);
+    double bestSeconds = 1e30;
+
+    for (int trial = 0; trial < NumTrials; ++trial)
+    {
+        size_t offset = 0;
+        auto t0 = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < numCopies; ++i)
+        {
+            if (offset + sizeInBytes > DestinationSize)
+                offset = 0;
+
+            copy(dst + offset, src, sizeInBytes);
+            offset += sizeInBytes;
+        }
+
+        auto t1 = std::chrono::steady_clock::now();
+        bestSeconds = std::min(bestSeconds, std::chrono::duration<double>(t1 - t0).count());
+    }
+
+    return static_cast<double>(numCopies * sizeInBytes) / bestSeconds * 1e-9;
+}
+
+static const char* GetKernelName(StreamingCopyKernel kernel)
+{
+    switch (kernel)
+    {
+    case StreamingCopyKernel::AVX2:
+        return "AVX2";
+    case StreamingCopyKernel::SSE2:
+        return "SSE2";
+    default:
+        return "memcpy";
+    }
+}
+
+int main()
+{
+    const size_t maxSize = 8 * 1024 * 1024;
+
+    uint8_t* src = static_cast<uint8_t*>(std::aligned_alloc(64, maxSize));
+    uint8_t* dst = static_cast<uint8_t*>(std::aligned_alloc(64, DestinationSize));
+
+    // Touch the memory, so that page faults are not measured.
+    memset(src, 0xab, maxSize);
+    memset(dst, 0, DestinationSize);
+
+    printf("StreamingCopy kernel: %s\n\n", GetKernelName(GetStreamingCopyKernel()));
+    printf("%10s %14s %20s %8s\n", "size", "memcpy GB/s", "StreamingCopy GB/s", "ratio");
+
+    for (size_t size = 64; size <= maxSize; size *= 2)
+    {
+        double memcpyThroughput = Measure(Memcpy, dst, src, size);
+        double streamingThroughput = Measure(StreamingCopy, dst, src, size);
+
+        printf("%10zu %14.2f %20.2f %8.2f\n", size, memcpyThroughput, streamingThroughput,
+            streamingThroughput / memcpyThroughput);
+    }
+
+    std::free(src);
+    std::free(dst);
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * Measures the throughput of UploadBuffer::Allocate from multiple threads
+ * that share one upload buffer, like worker threads that prepare the
+ * constant buffers of the same frame.
+ *
+ * The pages are backed by system memory (see Platform/d3d12.h). In each
+ * frame the threads allocate constant buffers until the allocations of the
+ * frame are used up, and the upload buffer is reset once all of the threads
+ * are done. The data is not written, so only the allocator is measured.
+ * With a page size of 64 KB every 256th allocation rolls over to a new page
+ * (see UploadBuffer::RolloverPage).
+ */
+
+#include <DX12LibPCH.h>
+
+#include <UploadBuffer.h>
+
+#include <atomic>
+#include <barrier>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+static const size_t AllocationSize = 256;
+static const size_t NumAllocationsPerFrame = 32 * 1024;
+static const uint32_t NumFrames = 200;
+// The best run is reported.
+static const int NumRuns = 3;
+
+// Returns the number of allocations per second.
+static double Run(UploadBuffer& uploadBuffer, uint32_t numThreads)
+{
+    // The upload buffer is reset by the last thread that arrives at the end of a frame.
+    std::barrier endFrame(numThreads, [&]() noexcept
+    {
+        uploadBuffer.Reset();
+    });
+
+    std::atomic<size_t> numNullAllocations = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < numThreads; ++i)
+    {
+        threads.emplace_back([&]()
+        {
+            const size_t numAllocationsPerThread = NumAllocationsPerFrame / numThreads;
+
+            for (uint32_t frame = 0; frame < NumFrames; ++frame)
+            {
+                for (size_t j = 0; j < numAllocationsPerThread; ++j)
+                {
+                    auto allocation = uploadBuffer.Allocate(AllocationSize, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+                    // Keep the compiler from removing the allocation.
+                    if (!allocation.CPU)
+                    {
+                        numNullAllocations.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+
+                endFrame.arrive_and_wait();
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+    return static_cast<double>(NumAllocationsPerFrame / numThreads * numThreads * NumFrames) / seconds;
+}
+
+int main()
+{
+    const uint32_t maxThreads = std::max(8u, std::thread::hardware_concurrency());
+    const size_t pageSizes[] = { _2MB, _64KB };
+
+    printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+
+    for (size_t pageSize : pageSizes)
+    {
+        UploadBuffer uploadBuffer(pageSize);
+
+        printf("\npage size %zu KB, %zu pages per frame\n", pageSize / 1024, NumAllocationsPerFrame * AllocationSize / pageSize);
+        printf("%8s %16s %16s %10s\n", "threads", "Mallocs/s", "ns/allocation", "scaling");
+
+        double singleThreadThroughput = 0.0;
+        for (uint32_t numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+        {
+            double throughput = 0.0;
+            for (int run = 0; run < NumRuns; ++run)
+            {
+                throughput = std::max(throughput, Run(uploadBuffer, numThreads));
+            }
+
+            if (numThreads == 1)
+            {
+                singleThreadThroughput = throughput;
+            }
+
+            printf("%8u %16.2f %16.2f %10.2f\n", numThreads, throughput * 1e-6, 1e9 / throughput,
+                throughput / singleThreadThroughput);
+        }
+    }
+
+    return 0;
+}
@@ -8,6 +8,9 @@
  *  @brief The application class is used to create windows for our application.
  */
 
+#include "DescriptorAllocation.h"
+#include "FenceTag.h"
+
 #include <d3d12.h>
 #include <dxgi1_6.h>
 #include <wrl.h>
@@ -15,9 +18,14 @@
 #include <memory>
 #include <string>
 
+class BindlessDescriptorHeap;
 class Window;
 class Game;
 class CommandQueue;
+class DescriptorAllocator;
+class DescriptorRing;
+class LinearDescriptorAllocator;
+class SamplerHeap;
 
 class Application
 {
@@ -99,6 +107,92 @@ public:
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(UINT numDescriptors, D3D12_DESCRIPTOR_HEAP_TYPE type);
     UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE type) const;
 
+    /**
+     * Allocate a number of CPU visible descriptors.
+     */
+    DescriptorAllocation AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors = 1);
+
+    /**
+     * Allocate a number of CPU visible descriptors for transient views that
+     * are only used for a single frame or pass. The descriptors are not freed
+     * individually (see LinearDescriptorAllocator).
+     */
+    D3D12_CPU_DESCRIPTOR_HANDLE AllocateTransientDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors = 1);
+
+    /**
+     * Get the shader visible descriptors that are used for bindless rendering.
+     */
+    BindlessDescriptorHeap& GetBindlessDescriptorHeap();
+
+    /**
+     * Get the shader visible descriptor heap that contains all of the samplers.
+     */
+    SamplerHeap& GetSamplerHeap();
+
+    /**
+     * Get the shader visible descriptor ring that the dynamic descriptor heaps
+     * of all command lists allocate their descriptors from. Only the
+     * CBV_SRV_UAV heap type has a descriptor ring (samplers are bound from
+     * the SamplerHeap).
+     */
+    DescriptorRing& GetDescriptorRing(D3D12_DESCRIPTOR_HEAP_TYPE type);
+
+    /**
+     * Get the fence values that will be signaled next on each of the command queues.
+     * Descriptors that are freed are tagged with these values and are reused
+     * once all of the command queues have completed them.
+     *
+     * The tag only covers command lists that have already been executed. Shader
+     * visible descriptors (transient descriptors and bindless indices) must not
+     * be tagged while a command list that references them is still being
+     * recorded, since that command list will signal a later fence value.
+     * Transient descriptors are retired in EndFrame (which asserts that no
+     * command list is open) and bindless indices that are freed while a
+     * command list is open are deferred to EndFrame.
+     * CPU visible descriptors are copied when the command list is recorded and
+     * can be freed at any time (the DynamicDescriptorHeap clears its caches of
+     * copied descriptor tables when they are freed, see
+     * DescriptorAllocator::GetFreeGeneration).
+     */
+    FenceTag GetNextFenceTag() const;
+
+    /**
+     * Check to see if any command list has been taken from a command queue
+     * and has not been executed yet.
+     */
+    bool HasOpenCommandLists() const;
+
+    /**
+     * Release the stale descriptors whose fence values have been completed.
+     * This is called automatically by the command queues when a fence completes.
+     */
+    void ReleaseStaleDescriptors();
+
+    /**
+     * Set the maximum number of descriptors that are relocated per frame to
+     * reduce the fragmentation of the descriptor allocators. Compaction is
+     * disabled by default (a budget of 0).
+     */
+    void SetDescriptorCompactionBudget(uint32_t maxDescriptorsPerFrame);
+
+    /**
+     * Compact the descriptor allocators within the compaction budget.
+     * This is called once per frame after the frame has been rendered (see EndFrame).
+     */
+    void CompactDescriptorAllocators();
+
+    /**
+     * Get the statistics of the descriptor allocators of all heap types as a JSON array.
+     */
+    std::string GetDescriptorAllocatorStatsJSON();
+
+    /**
+     * Get the statistics of the upload memory of all upload buffers and the
+     * upload rings of the command queues as a JSON object.
+     * The upload memory budget is set with UploadBuffer::SetMemoryBudget.
+     */
+    std::string GetUploadMemoryStatsJSON() const;
+
     static uint64_t GetFrameCount()
     {
         return ms_FrameCount;
@@ -115,6 +209,15 @@ protected:
     Microsoft::WRL::ComPtr<ID3D12Device2> CreateDevice(Microsoft::WRL::ComPtr<IDXGIAdapter4> adapter);
     bool CheckTearingSupport();
 
+    // Create the descriptor allocators and the shader visible descriptor heaps.
+    // Called by Create after the application instance has been set.
+    void CreateDescriptorAllocators();
+
+    // Called once per frame after the frame has been rendered. Retires the
+    // transient descriptors of the frame and the deferred bindless indices,
+    // destroys the idle descriptor pages and compacts the descriptor allocators.
+    void EndFrame();
+
 private:
     friend LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
     
@@ -131,6 +234,17 @@ private:
     std::shared_ptr<CommandQueue> m_ComputeCommandQueue;
     std::shared_ptr<CommandQueue> m_CopyCommandQueue;
 
+    // The descriptor allocators are destroyed before the command queues.
+    std::unique_ptr<DescriptorAllocator> m_DescriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+    std::unique_ptr<LinearDescriptorAllocator> m_LinearDescriptorAllocators[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+    std::unique_ptr<DescriptorRing> m_DescriptorRings[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+    // The bindless descriptors are reserved in the CBV_SRV_UAV descriptor ring.
+    std::unique_ptr<BindlessDescriptorHeap> m_BindlessDescriptorHeap;
+    std::unique_ptr<SamplerHeap> m_SamplerHeap;
+
+    // The maximum number of descriptors to relocate per frame.
+    uint32_t m_DescriptorCompactionBudget;
+
     bool m_TearingSupported;
 
     static uint64_t ms_FrameCount;
@@ -0,0 +1,137 @@
+#pragma once
+
+/**
+ *  @file BindlessDescriptorHeap.h
+ *
+ *  @brief A large region of shader visible CBV/SRV/UAV descriptors that is
+ *  used for bindless rendering.
+ *
+ *  Each view that is placed in the bindless heap receives a stable index for
+ *  as long as the view exists. Shaders access the views by indexing into an
+ *  unbounded descriptor table that starts at the beginning of the heap (or the
+ *  ResourceDescriptorHeap in shader model 6.6) and receive the indices through
+ *  root constants. Binding a view then only requires writing a 32-bit root
+ *  constant instead of copying descriptors into the DynamicDescriptorHeap.
+ *
+ *  The bindless descriptors are the reserved descriptors at the start of every
+ *  descriptor heap of the CBV_SRV_UAV DescriptorRing. The dynamic descriptors
+ *  of the command lists and the bindless descriptors are therefore in the same
+ *  descriptor heap and binding the bindless descriptor table does not change
+ *  the descriptor heap of the command list
+ *  (see DynamicDescriptorHeap::SetGraphicsBindlessDescriptorTable).
+ *
+ *  Indices are managed by a TLSF free list (see TLSFAllocator.h). Freed indices
+ *  are tagged with the next fence values of the command queues and are not
+ *  reused until the command queues have completed those fence values.
+ *  Indices that are freed while a command list is being recorded are only
+ *  tagged at the end of the frame, after that command list was executed
+ *  (see FreeDeferred).
+ */
+
+#include "FenceTag.h"
+#include "TLSFAllocator.h"
+
+#include "d3dx12.h"
+
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+class DescriptorRing;
+
+class BindlessDescriptorHeap
+{
+public:
+    // Returned from Allocate if the allocation could not be satisfied.
+    static constexpr uint32_t InvalidIndex = TLSFAllocator::InvalidOffset;
+
+    /**
+     * @param descriptorRing The CBV_SRV_UAV descriptor ring whose reserved
+     * descriptors are used as the bindless descriptors.
+     */
+    explicit BindlessDescriptorHeap( DescriptorRing& descriptorRing );
+
+    uint32_t GetNumDescriptors() const
+    {
+        return m_NumDescriptorsInHeap;
+    }
+
+    /**
+     * Get the CPU visible descriptor handle of the descriptor at a particular index.
+     */
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandle( uint32_t index ) const;
+
+    /**
+     * Allocate a contiguous range of indices in the heap.
+     * @throws std::bad_alloc if the heap is full.
+     */
+    uint32_t Allocate( uint32_t numDescriptors = 1 );
+
+    /**
+     * Free a range of indices. The indices are not reused until the command
+     * queues have completed the fence values in the fence tag.
+     */
+    void Free( uint32_t index, uint32_t numDescriptors, const FenceTag& fenceTag );
+
+    /**
+     * Free a range of indices that may be referenced by a command list that is
+     * still being recorded. That command list signals a later fence value than
+     * the next fence values, so the indices are only tagged when the deferred
+     * indices are retired at the end of the frame.
+     */
+    void FreeDeferred( uint32_t index, uint32_t numDescriptors );
+
+    /**
+     * Tag the indices that were freed with FreeDeferred. This must be called
+     * when no command list is being recorded (see Application::EndFrame).
+     */
+    void RetireDeferredDescriptors( const FenceTag& fenceTag );
+
+    /**
+     * Copy a CPU visible descriptor (created with the DescriptorAllocator) to an
+     * index in the heap.
+     */
+    void CopyDescriptor( uint32_t index, D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor );
+
+    /**
+     * Create a view directly in the heap and return its index.
+     */
+    uint32_t CreateShaderResourceView( ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc = nullptr );
+    uint32_t CreateUnorderedAccessView( ID3D12Resource* resource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* uavDesc = nullptr );
+
+    /**
+     * Return the stale indices back to the free list.
+     * @param completedFenceValues The completed fence values of the command queues.
+     */
+    void ReleaseStaleDescriptors( const FenceTag& completedFenceValues );
+
+private:
+    struct StaleDescriptorInfo
+    {
+        StaleDescriptorInfo( uint32_t index, uint32_t size, const FenceTag& fenceTag )
+            : Index( index )
+            , Size( size )
+            , Fence( fenceTag )
+        {}
+
+        // The index of the first descriptor in the heap.
+        uint32_t Index;
+        // The number of descriptors.
+        uint32_t Size;
+        // The fence values that must be completed before the descriptors can be reused.
+        FenceTag Fence;
+    };
+
+    using StaleDescriptorQueue = std::queue<StaleDescriptorInfo>;
+
+    TLSFAllocator m_FreeList;
+    StaleDescriptorQueue m_StaleDescriptors;
+    // The index and size of the ranges that were freed with FreeDeferred.
+    std::vector< std::pair<uint32_t, uint32_t> > m_DeferredDescriptors;
+
+    DescriptorRing& m_DescriptorRing;
+    uint32_t m_NumDescriptorsInHeap;
+
+    std::mutex m_AllocationMutex;
+};
\ No newline at end of file
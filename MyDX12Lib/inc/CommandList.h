@@ -13,6 +13,7 @@
 #include <cassert>
 
 #include "TextureUsage.h"
+#include "UploadBufferStats.h"
 
 #include <d3d12.h>
 #include <wrl.h>
@@ -20,6 +21,7 @@
 #include <map> // for std::map
 #include <memory> // for std::unique_ptr
 #include <mutex> // for std::mutex
+#include <type_traits> // for std::is_trivially_copyable
 #include <vector> // for std::vector
 
 class Buffer;
@@ -196,6 +198,23 @@ public:
         SetGraphicsDynamicConstantBuffer( rootParameterIndex, sizeof( T ), &data );
     }
 
+    /**
+     * Allocate a dynamic constant buffer in the upload buffer and bind it to an
+     * inline descriptor in the root signature. The returned pointer points
+     * into the mapped upload page, so the constants can be written in place
+     * (without building them on the stack and copying them). The constants
+     * must be written before the command list is executed.
+     * The upload memory is write-combined: write the constants sequentially
+     * and don't read from them.
+     */
+    void* AllocateGraphicsConstants( uint32_t rootParameterIndex, size_t sizeInBytes );
+    template<typename T>
+    T* AllocateGraphicsConstants( uint32_t rootParameterIndex )
+    {
+        static_assert( std::is_trivially_copyable<T>::value, "Constants must be trivially copyable" );
+        return static_cast<T*>( AllocateGraphicsConstants( rootParameterIndex, sizeof( T ) ) );
+    }
+
     /**
      * Set a set of 32-bit constants on the graphics pipeline.
      */
@@ -312,6 +331,64 @@ public:
         const D3D12_UNORDERED_ACCESS_VIEW_DESC* uav = nullptr
     );
 
+    /**
+     * Set the descriptor table at the root parameter index to the start of the
+     * bindless descriptors. The table should contain an unbounded range
+     * (NumDescriptors = UINT_MAX). The bindless descriptors are in the same
+     * descriptor heap as the descriptor tables that are staged with
+     * SetShaderResourceView or SetUnorderedAccessView, so both can be used in
+     * the same draw or dispatch. The table must be set again after the root
+     * signature is changed.
+     */
+    void SetGraphicsBindlessDescriptorTable( uint32_t rootParameterIndex );
+    void SetComputeBindlessDescriptorTable( uint32_t rootParameterIndex );
+
+    /**
+     * Set the index of the default SRV of a resource in the bindless descriptor
+     * heap as a 32-bit root constant.
+     *
+     * @param rootParameterIndex The root parameter that contains the 32-bit constants.
+     * @param destOffsetIn32BitValues The offset of the index in the root constants.
+     */
+    void SetGraphicsBindlessShaderResourceView(
+        uint32_t rootParameterIndex,
+        uint32_t destOffsetIn32BitValues,
+        const Resource& resource,
+        D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE |
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+    );
+    void SetComputeBindlessShaderResourceView(
+        uint32_t rootParameterIndex,
+        uint32_t destOffsetIn32BitValues,
+        const Resource& resource,
+        D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+    );
+
+    /**
+     * Set the index of the default UAV of a resource in the bindless descriptor
+     * heap as a 32-bit root constant.
+     */
+    void SetGraphicsBindlessUnorderedAccessView(
+        uint32_t rootParameterIndex,
+        uint32_t destOffsetIn32BitValues,
+        const Resource& resource,
+        D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_UNORDERED_ACCESS
+    );
+    void SetComputeBindlessUnorderedAccessView(
+        uint32_t rootParameterIndex,
+        uint32_t destOffsetIn32BitValues,
+        const Resource& resource,
+        D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_UNORDERED_ACCESS
+    );
+
+    /**
+     * Set a table of samplers at the root parameter index. The samplers are
+     * taken from the global sampler heap (see SamplerHeap) so the table is
+     * bound directly without copying any descriptors.
+     */
+    void SetGraphicsSamplers( uint32_t rootParameterIndex, const D3D12_SAMPLER_DESC* samplerDescs, uint32_t numSamplers = 1 );
+    void SetComputeSamplers( uint32_t rootParameterIndex, const D3D12_SAMPLER_DESC* samplerDescs, uint32_t numSamplers = 1 );
+
     /**
      * Set the render targets for the graphics rendering pipeline.
      */
@@ -368,6 +445,42 @@ public:
         return m_ComputeCommandList;
     }
 
+    /**
+     * The memory that is used by a command list (in bytes).
+     */
+    struct MemoryUsage
+    {
+        // The pages of the upload buffer (upload heap memory).
+        size_t UploadBufferBytes;
+        // The barriers and resource states of the resource state tracker (approximate).
+        size_t ResourceStateTrackerBytes;
+        // The CPU visible descriptor handle caches of the dynamic descriptor heaps.
+        size_t DynamicDescriptorHeapBytes;
+        // The chunks of the shader visible descriptor rings that are used by
+        // the dynamic descriptor heaps.
+        size_t ShaderVisibleDescriptorBytes;
+        // The references to the tracked objects.
+        size_t TrackedObjectsBytes;
+
+        size_t GetTotalBytes() const
+        {
+            return UploadBufferBytes + ResourceStateTrackerBytes + DynamicDescriptorHeapBytes +
+                   ShaderVisibleDescriptorBytes + TrackedObjectsBytes;
+        }
+    };
+
+    /**
+     * Report the memory that is used by the command list. Objects that the
+     * command list creates on first use are not counted until they are used.
+     */
+    MemoryUsage GetMemoryUsage() const;
+
+    /**
+     * Get the statistics of the upload buffer of the command list (all zero
+     * if the command list did not upload any dynamic data yet).
+     */
+    UploadBufferStats GetUploadBufferStats() const;
+
 protected:
 
 private:
@@ -387,6 +500,16 @@ private:
     // Binds the current descriptor heaps to the command list.
     void BindDescriptorHeaps();
 
+    // Get the upload buffer, the resource state tracker, or a dynamic descriptor
+    // heap. They are created the first time they are requested.
+    UploadBuffer& GetUploadBuffer();
+    ResourceStateTracker& GetResourceStateTracker();
+    DynamicDescriptorHeap& GetDynamicDescriptorHeap( D3D12_DESCRIPTOR_HEAP_TYPE heapType );
+
+    // Set the descriptor table layout of the root signature on the dynamic
+    // descriptor heaps.
+    void SetDescriptorTableLayouts( const RootSignature& rootSignature );
+
     using TrackedObjects = std::vector < Microsoft::WRL::ComPtr<ID3D12Object> >;
 
     D3D12_COMMAND_LIST_TYPE m_d3d12CommandListType;
@@ -405,6 +528,7 @@ private:
 
     // Resource created in an upload heap. Useful for drawing of dynamic geometry
     // or for uploading constant buffer data that changes every draw call.
+    // The pages are taken from the upload ring of the command queue.
     std::unique_ptr<UploadBuffer> m_UploadBuffer;
 
     // Resource state tracker is used by the command list to track (per command list)
@@ -414,7 +538,7 @@ private:
 
     // The dynamic descriptor heap allows for descriptors to be staged before
     // being committed to the command list. Dynamic descriptors need to be
-    // committed before a Draw or Dispatch.
+    // committed before a Draw or Dispatch. Only the CBV_SRV_UAV heap is used.
     std::unique_ptr<DynamicDescriptorHeap> m_DynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 
     // Keep track of the currently bound descriptor heaps. Only change descriptor 
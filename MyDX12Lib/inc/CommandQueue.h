@@ -7,9 +7,13 @@
 #include <d3d12.h>  // For ID3D12CommandQueue, ID3D12Device2, and ID3D12Fence
 #include <wrl.h>    // For Microsoft::WRL::ComPtr
 
+#include <atomic>   // For std::atomic
 #include <cstdint>  // For uint64_t
+#include <memory>   // For std::unique_ptr
 #include <queue>    // For std::queue
 
+class UploadRing;
+
 class CommandQueue
 {
 public:
@@ -28,12 +32,30 @@ public:
     void WaitForFenceValue(uint64_t fenceValue);
     void Flush();
 
+    // Get the fence value that will be signaled for the next executed command list.
+    uint64_t GetNextFenceValue() const;
+    // Get the last fence value that was observed to be completed.
+    uint64_t GetCompletedFenceValue() const;
+
+    // Get the number of command lists that were taken from the queue and
+    // have not been executed yet.
+    uint32_t GetNumOpenCommandLists() const;
+
     Microsoft::WRL::ComPtr<ID3D12CommandQueue> GetD3D12CommandQueue() const;
+
+    // Get the upload ring that is shared by the command lists that are executed
+    // on this queue (nullptr for a copy queue).
+    UploadRing* GetUploadRing() const;
 protected:
 
     Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CreateCommandAllocator();
     Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> CreateCommandList(Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator);
 
+    // Query the completed fence value of the fence. If the fence has advanced,
+    // the application releases the descriptors that are no longer in use and
+    // the blocks of the upload ring are reclaimed.
+    uint64_t UpdateCompletedFenceValue();
+
 private:
     // Keep track of command allocators that are "in-flight"
     struct CommandAllocatorEntry
@@ -50,8 +72,13 @@ private:
     Microsoft::WRL::ComPtr<ID3D12CommandQueue>  m_d3d12CommandQueue;
     Microsoft::WRL::ComPtr<ID3D12Fence>         m_d3d12Fence;
     HANDLE                      m_FenceEvent;
-    uint64_t                    m_FenceValue;
+    std::atomic_uint64_t        m_FenceValue;
+    std::atomic_uint64_t        m_CompletedFenceValue;
+    std::atomic_uint32_t        m_NumOpenCommandLists;
 
     CommandAllocatorQueue       m_CommandAllocatorQueue;
     CommandListQueue            m_CommandListQueue;
+
+    // The upload memory for dynamic buffers (sized by the frames in flight).
+    std::unique_ptr<UploadRing> m_UploadRing;
 };
\ No newline at end of file
@@ -7,6 +7,12 @@
  *
  *  @brief A single allocation for the descriptor allocator.
  *
+ *  The allocation is a packed DescriptorHandle (the index of the page in the
+ *  allocator, the offset in the page and the number of descriptors) together
+ *  with a pointer to the allocator that owns the page. The CPU descriptor
+ *  handles are resolved through the page table of the DescriptorAllocator.
+ *  The DescriptorAllocator must outlive all of its allocations.
+ *
  *  Variable sized memory allocation strategy based on:
  *  http://diligentgraphics.com/diligent-engine/architecture/d3d12/variable-size-memory-allocations-manager/
  *  Date Accessed: May 9, 2018
@@ -15,9 +21,21 @@
 #include <d3d12.h>
 
 #include <cstdint>
-#include <memory>
 
-class DescriptorAllocatorPage;
+class DescriptorAllocator;
+
+// A compact reference to a range of descriptors in a DescriptorAllocator.
+struct DescriptorHandle
+{
+    // The offset of the first descriptor in the page.
+    uint32_t Offset;
+    // The index of the page in the page table of the allocator.
+    uint16_t PageIndex;
+    // The number of descriptors in the range (0 for a NULL handle).
+    uint16_t NumHandles;
+};
+
+static_assert( sizeof( DescriptorHandle ) == 8, "DescriptorHandle must be packed into 8 bytes." );
 
 class DescriptorAllocation
 {
@@ -25,7 +43,7 @@ public:
     // Creates a NULL descriptor.
     DescriptorAllocation();
 
-    DescriptorAllocation( D3D12_CPU_DESCRIPTOR_HANDLE descriptor, uint32_t numHandles, uint32_t descriptorSize, std::shared_ptr<DescriptorAllocatorPage> page );
+    DescriptorAllocation( DescriptorHandle handle, DescriptorAllocator* allocator );
 
     // The destructor will automatically free the allocation.
     ~DescriptorAllocation();
@@ -47,21 +65,17 @@ public:
     // Get the number of (consecutive) handles for this allocation.
     uint32_t GetNumHandles() const;
 
-    // Get the heap that this allocation came from.
+    // Get the packed handle of this allocation.
     // (For internal use only).
-    std::shared_ptr<DescriptorAllocatorPage> GetDescriptorAllocatorPage() const;
+    DescriptorHandle GetHandle() const;
 
 private:
     // Free the descriptor back to the heap it came from.
     void Free();
 
-    // The base descriptor.
-    D3D12_CPU_DESCRIPTOR_HANDLE m_Descriptor;
-    // The number of descriptors in this allocation.
-    uint32_t m_NumHandles;
-    // The offset to the next descriptor.
-    uint32_t m_DescriptorSize;
+    // The packed page index, offset and number of descriptors.
+    DescriptorHandle m_Handle;
 
-    // A pointer back to the original page where this allocation came from.
-    std::shared_ptr<DescriptorAllocatorPage> m_Page;
+    // The allocator that owns the page where this allocation came from.
+    DescriptorAllocator* m_Allocator;
 };
\ No newline at end of file
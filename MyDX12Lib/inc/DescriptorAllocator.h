@@ -13,15 +13,41 @@
  *  Variable sized memory allocation strategy based on:
  *  http://diligentgraphics.com/diligent-engine/architecture/d3d12/variable-size-memory-allocations-manager/
  *  Date Accessed: May 9, 2018
+ *
+ *  Single descriptor allocations are served from thread local magazines of
+ *  descriptors that are refilled in bulk from the pages, so that threads that
+ *  create views do not serialize on the allocator and page locks.
+ *  Magazines are refilled from slab pages that claim descriptors from an atomic
+ *  occupancy bitmap, so single descriptors are allocated and freed without
+ *  taking a shared lock (except when a new slab page needs to be created).
+ *  The owning thread marks its magazine as in use with an atomic flag (no
+ *  mutex). The flag is only contended when the magazine of an idle thread is
+ *  trimmed (see TrimIdlePages).
+ *
+ *  Pages are stored in a fixed size page table. Allocations only store the
+ *  index of the page in the table (see DescriptorHandle) and are resolved
+ *  through the allocator without taking a lock. Destroyed pages are removed
+ *  from the table right away, but are only deleted (and their index reused)
+ *  once the GPU has completed the next fence values of the command queues.
+ *
+ *  Available pages are indexed by the size of their largest free block, so
+ *  the page that fits a request best is found in O(log n). Pages that have been
+ *  completely free for a number of frames (calls to TrimIdlePages) are
+ *  destroyed (slab pages release their heap).
  */
 
 #include "DescriptorAllocation.h"
+#include "DescriptorAllocatorStats.h"
+#include "FenceTag.h"
+#include "HighResolutionClock.h"
 
 #include "d3dx12.h"
 
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 #include <memory>
+#include <queue>
 #include <set>
 #include <vector>
 
@@ -30,7 +56,11 @@ class DescriptorAllocatorPage;
 class DescriptorAllocator
 {
 public:
-    DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerHeap = 256);
+    /**
+     * @param maxIdleFrames The number of frames that a page must be
+     * completely free before it is destroyed.
+     */
+    DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerHeap = 256, uint32_t maxIdleFrames = 256);
     virtual ~DescriptorAllocator();
 
     /**
@@ -38,26 +68,211 @@ public:
      * 
      * @param numDescriptors The number of contiguous descriptors to allocate. 
      * Cannot be more than the number of descriptors per descriptor heap.
+     * Single descriptors are allocated from the magazine of the calling thread.
      */
     DescriptorAllocation Allocate(uint32_t numDescriptors = 1);
 
     /**
-     * When the frame has completed, the stale descriptors can be released.
+     * When the command queues have completed the fence values that stale
+     * descriptors were tagged with, the stale descriptors can be released.
+     * Stale descriptors in the thread local magazines are reused by the owning
+     * thread once their fence values have completed.
+     * @param completedFenceValues The completed fence values of the command queues.
      */
-    void ReleaseStaleDescriptors( uint64_t frameNumber );
+    void ReleaseStaleDescriptors( const FenceTag& completedFenceValues );
+
+    /**
+     * Destroy the pages that have been completely free for the maximum number
+     * of idle frames. The magazines of threads that did not allocate since the
+     * previous call return their reusable descriptors to the pages first.
+     * This should be called once per frame.
+     */
+    void TrimIdlePages();
+
+    /**
+     * Relocate ranges of descriptors within the pages to merge fragmented free
+     * blocks. The most fragmented pages are compacted first. Relocated ranges
+     * keep their DescriptorHandle (see DescriptorAllocatorPage::Compact) and
+     * their old location is released once the fence tag has completed.
+     *
+     * Views must not be created in range allocations while compacting.
+     *
+     * @param maxDescriptorsToMove The maximum number of descriptors to copy.
+     * @return The number of descriptors that were copied.
+     */
+    uint32_t Compact( uint32_t maxDescriptorsToMove, const FenceTag& fenceTag );
+
+    /**
+     * Get the occupancy and fragmentation statistics of the allocator and
+     * each of its pages. Allocation rates are measured since the previous
+     * call to GetStats.
+     */
+    DescriptorAllocatorStats GetStats();
+
+    /**
+     * Get the number of times that CPU visible descriptors of a heap type were
+     * freed (by a DescriptorAllocator) or retired (by a LinearDescriptorAllocator).
+     * A freed descriptor handle can be reused for a different view once its
+     * fence tag has completed, so caches that are keyed on descriptor handles
+     * (see DynamicDescriptorHeap) must be cleared when the generation changes.
+     */
+    static uint64_t GetFreeGeneration( D3D12_DESCRIPTOR_HEAP_TYPE type )
+    {
+        return ms_FreeGenerations[type].load( std::memory_order_acquire );
+    }
+
+    static void AdvanceFreeGeneration( D3D12_DESCRIPTOR_HEAP_TYPE type )
+    {
+        ms_FreeGenerations[type].fetch_add( 1, std::memory_order_release );
+    }
 
 private:
-    using DescriptorHeapPool = std::vector< std::shared_ptr<DescriptorAllocatorPage> >;
+    friend class DescriptorAllocation;
+
+    // A thread local cache of single descriptors.
+    struct Magazine;
+    // The magazines of a single thread (indexed by the allocator id).
+    struct ThreadMagazines;
+
+    using MagazinePool = std::vector< std::shared_ptr<Magazine> >;
+
+    // Pages with free descriptors ordered by the size of their largest free block.
+    using AvailableHeapSet = std::set< std::pair<uint32_t, uint16_t> >;
+
+    struct PageInfo
+    {
+        // The key of the page in the available heaps.
+        uint32_t LargestFreeBlock;
+        // The number of frames that the page has been completely free.
+        uint32_t NumIdleFrames;
+        // The number of allocated descriptors at the previous call to GetStats.
+        uint64_t LastNumAllocatedDescriptors;
+    };
+
+    // The maximum number of pages in the page table.
+    static const uint32_t MaxPages = 4096;
+    // The number of descriptors in a slab page.
+    static const uint32_t NumDescriptorsPerSlab = 1024;
+    // The maximum number of slab pages. When all slab pages are full, single
+    // descriptors are allocated from the regular pages.
+    static const uint32_t MaxSlabPages = 256;
+
+    // Get the CPU descriptor handle of a descriptor in an allocation.
+    D3D12_CPU_DESCRIPTOR_HANDLE GetDescriptorHandle( DescriptorHandle handle, uint32_t offset ) const;
+
+    // Free an allocation. Called by the DescriptorAllocation class.
+    void Free( DescriptorHandle handle, const FenceTag& fenceTag );
 
     // Create a new heap with a specific number of descriptors.
-    std::shared_ptr<DescriptorAllocatorPage> CreateAllocatorPage();
+    // Returns the index of the page in the page table.
+    uint16_t CreateAllocatorPage( bool isSlab = false );
+
+    // Remove a page that has no allocated descriptors from the page table.
+    // The page is deleted once the fence tag has completed.
+    void DestroyAllocatorPage( uint16_t pageIndex, const FenceTag& fenceTag );
+
+    // Delete the destroyed pages whose fence tag has completed and make
+    // their indices available for new pages.
+    void ReleaseRetiredPages( const FenceTag& completedFenceValues );
+
+    // Mark a page as having stale descriptors.
+    void MarkStalePage( uint16_t pageIndex );
+
+    // Resolve the index of a page in the page table without taking a lock.
+    DescriptorAllocatorPage* GetPage( uint16_t pageIndex ) const;
+
+    // Update the key of a (non-slab) page in the available heaps.
+    void UpdateAvailableHeap( uint16_t pageIndex );
+
+    // Find a slab page with free descriptors, revive a retired slab page or
+    // create a new slab page (in that order).
+    // Returns the index in m_SlabPages or MaxSlabPages if all slab pages are in use.
+    uint32_t AcquireSlabPage();
+
+    // Get (or create) the magazine of the calling thread.
+    Magazine& GetThreadMagazine();
+
+    // Fill the magazine with single descriptors from the pages.
+    void RefillMagazine( Magazine& magazine );
+
+    // Move the stale descriptors whose fence values have completed to the ready descriptors.
+    void PromoteStaleDescriptors( Magazine& magazine );
+
+    // Return the last ready descriptors of a magazine back to their pages.
+    // Slab pages are released without a lock.
+    void ReleaseReadyDescriptors( Magazine& magazine, uint32_t numDescriptors );
+
+    // Return all descriptors in a magazine back to the pages.
+    void FlushMagazine( Magazine& magazine );
+
+    // Return a single descriptor to the magazine of the calling thread.
+    void FreeToMagazine( DescriptorHandle handle, const FenceTag& fenceTag );
+
+    // Return the ready and completed stale descriptors of the magazines that
+    // have not allocated since the previous call to their pages.
+    void TrimIdleMagazines();
 
     D3D12_DESCRIPTOR_HEAP_TYPE m_HeapType;
     uint32_t m_NumDescriptorsPerHeap;
 
-    DescriptorHeapPool m_HeapPool;
-    // Indices of available heaps in the heap pool.
-    std::set<size_t> m_AvailableHeaps;
+    // The pages that are owned by the allocator. Only accessed while
+    // holding the allocation mutex.
+    std::unique_ptr<DescriptorAllocatorPage> m_Pages[MaxPages];
+    // The page table that is used to resolve a DescriptorHandle without
+    // taking a lock. Pages are published with a release store when they
+    // are created and removed when they are destroyed.
+    std::atomic<DescriptorAllocatorPage*> m_PageTable[MaxPages];
+    PageInfo m_PageInfos[MaxPages];
+    uint32_t m_NumPages;
+    // Indices of destroyed pages that can be reused.
+    std::vector<uint16_t> m_FreePageIndices;
+
+    struct RetiredPage
+    {
+        uint16_t PageIndex;
+        // The fence values that must be completed before the page is deleted.
+        FenceTag Fence;
+    };
+
+    // Destroyed pages that may still be resolved by other threads.
+    std::queue<RetiredPage> m_RetiredPages;
+
+    // A bit for each page in the page table that is set when descriptors are
+    // added to the stale allocations queue of the page.
+    std::atomic<uint64_t> m_StalePages[MaxPages / 64];
+
+    AvailableHeapSet m_AvailableHeaps;
+
+    uint32_t m_MaxIdleFrames;
+
+    // The number of multi-descriptor allocations.
+    uint64_t m_NumRangeAllocations;
+    // The number of allocations made by magazines whose thread has exited.
+    uint64_t m_NumOrphanedAllocations;
+    // The total number of allocations at the previous call to GetStats.
+    uint64_t m_LastNumAllocations;
+    // Measures the time between calls to GetStats.
+    HighResolutionClock m_StatsClock;
+
+    // Indices of the slab pages in the page table. The first m_NumSlabPages
+    // entries can be accessed without taking a lock.
+    uint16_t m_SlabPages[MaxSlabPages];
+    std::atomic<uint32_t> m_NumSlabPages;
 
     std::mutex m_AllocationMutex;
+
+    // Used to find the magazines of this allocator in the thread local storage.
+    uint32_t m_AllocatorId;
+
+    // The last fence values that were passed to ReleaseStaleDescriptors.
+    // The values are read by the magazines without taking a lock.
+    std::atomic<uint64_t> m_CompletedFenceValues[FenceTag::NumQueues];
+
+    // All of the magazines that were created for this allocator.
+    MagazinePool m_Magazines;
+    std::mutex m_MagazineMutex;
+
+    static thread_local ThreadMagazines ms_ThreadMagazines;
+
+    static std::atomic<uint64_t> ms_FreeGenerations[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 };
\ No newline at end of file
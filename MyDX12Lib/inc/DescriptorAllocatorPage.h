@@ -7,29 +7,78 @@
  *
  *  @brief A descriptor heap (page for the DescriptorAllocator class).
  *
- *  Variable sized memory allocation strategy based on:
- *  http://diligentgraphics.com/diligent-engine/architecture/d3d12/variable-size-memory-allocations-manager/
- *  Date Accessed: May 9, 2018
+ *  Free descriptors are managed by a two-level segregated fit (TLSF) free list
+ *  (see TLSFAllocator.h) which allocates and coalesces blocks in constant time.
+ *
+ *  A page can also be created as a slab of single descriptors. Slab pages
+ *  keep an atomic occupancy bitmap (one bit per descriptor) instead of the free
+ *  list, so descriptors are claimed and released without taking a lock.
+ *
+ *  Slab pages that are not used for a while can be retired, which releases the
+ *  descriptor heap but keeps the page (and its bitmap) so that threads can
+ *  safely scan it without taking a lock.
+ *
+ *  Descriptors are identified by their offset in the page. The DescriptorAllocator
+ *  class combines the offset with the index of the page to form a DescriptorHandle.
+ *
+ *  Ranges of descriptors (allocated with Allocate) are identified by a slot
+ *  in an indirection table instead, which stores the current offset of the
+ *  range. This allows the Compact method to relocate live ranges within the
+ *  page to merge the free blocks without invalidating the DescriptorHandles.
  */
 
-#include "DescriptorAllocation.h"
+#include "DescriptorAllocatorStats.h"
+#include "FenceTag.h"
+#include "TLSFAllocator.h"
 
-#include <d3d12.h>
+#include "d3dx12.h"
 
 #include <wrl.h>
 
-#include <map>
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <vector>
 
-class DescriptorAllocatorPage : public std::enable_shared_from_this<DescriptorAllocatorPage>
+class DescriptorAllocatorPage
 {
 public:
-    DescriptorAllocatorPage( D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors );
+    // The offset (in descriptors) within the descriptor heap.
+    using OffsetType = TLSFAllocator::OffsetType;
+    // The number of descriptors that are available.
+    using SizeType = TLSFAllocator::SizeType;
+
+    // Returned from Allocate if the allocation could not be satisfied.
+    static constexpr OffsetType InvalidOffset = TLSFAllocator::InvalidOffset;
+
+    /**
+    * @param isSlab Create a slab page that can only allocate single descriptors.
+    */
+    DescriptorAllocatorPage( D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors, bool isSlab = false );
 
     D3D12_DESCRIPTOR_HEAP_TYPE GetHeapType() const;
 
+    /**
+    * Check to see if this page is a slab of single descriptors.
+    */
+    bool IsSlab() const;
+
+    /**
+    * Check to see if the descriptor heap of this slab page has been released.
+    */
+    bool IsRetired() const;
+
+    /**
+    * Get the total number of descriptors in the heap.
+    */
+    uint32_t GetNumDescriptors() const;
+
+    /**
+    * Get the CPU descriptor handle of a descriptor in the heap.
+    */
+    D3D12_CPU_DESCRIPTOR_HANDLE GetDescriptorHandle( OffsetType offset ) const;
+
     /**
     * Check to see if this descriptor page has a contiguous block of descriptors
     * large enough to satisfy the request.
@@ -41,93 +90,173 @@ public:
     */
     uint32_t NumFreeHandles() const;
 
+    /**
+    * Get the size of the largest contiguous block of free descriptors that
+    * is guaranteed to be allocated (see TLSFAllocator::GetLargestFreeBlock).
+    */
+    uint32_t GetLargestFreeBlock() const;
+
+    /**
+    * Get the number of free descriptors that are not in the largest free block.
+    * Both are read while holding the lock of the page.
+    */
+    uint32_t GetNumFragmentedDescriptors() const;
+
+    /**
+    * Get the occupancy and fragmentation statistics of the page.
+    * The PageIndex and AllocationRate are filled in by the DescriptorAllocator.
+    */
+    DescriptorPageStats GetStats() const;
+
     /**
     * Allocate a number of descriptors from this descriptor heap.
-    * If the allocation cannot be satisfied, then a NULL descriptor
-    * is returned.
+    * @return The slot of the range in the indirection table or InvalidOffset
+    * if the allocation cannot be satisfied. Use GetSlotOffset to get the
+    * offset of the first descriptor.
     */
-    DescriptorAllocation Allocate( uint32_t numDescriptors );
+    OffsetType Allocate( uint32_t numDescriptors );
 
     /**
-    * Return a descriptor back to the heap.
-    * @param frameNumber Stale descriptors are not freed directly, but put
-    * on a stale allocations queue. Stale allocations are returned to the heap
-    * using the DescriptorAllocatorPage::ReleaseStaleAllocations method.
+    * Get the current offset of a range that was allocated with Allocate.
+    * The offset can change when the page is compacted.
     */
-    void Free( DescriptorAllocation&& descriptorHandle, uint64_t frameNumber );
+    OffsetType GetSlotOffset( OffsetType slot ) const;
 
     /**
-    * Returned the stale descriptors back to the descriptor heap.
+    * Return a range that was allocated with Allocate back to the heap.
+    * The descriptors are put on the stale allocations queue (see Free).
+    */
+    void FreeSlot( OffsetType slot, const FenceTag& fenceTag );
+
+    /**
+    * Relocate ranges to lower offsets in the page so that the free descriptors
+    * are merged into larger blocks. Ranges at the highest offsets are moved
+    * first. The old location of a range is put on the stale allocations queue.
+    *
+    * Views must not be written to the ranges of the page while it is compacted.
+    *
+    * @param maxDescriptorsToMove The maximum number of descriptors to copy.
+    * @return The number of descriptors that were copied.
     */
-    void ReleaseStaleDescriptors( uint64_t frameNumber );
+    uint32_t Compact( uint32_t maxDescriptorsToMove, const FenceTag& fenceTag );
 
-protected:
+    /**
+    * Allocate up to numDescriptors single descriptors while only taking the
+    * lock once. Each descriptor must be freed individually.
+    * @return The number of descriptors that were written to offsets.
+    */
+    uint32_t AllocateSingleDescriptors( uint32_t numDescriptors, OffsetType* offsets );
 
-    // Compute the offset of the descriptor handle from the start of the heap.
-    uint32_t ComputeOffset( D3D12_CPU_DESCRIPTOR_HANDLE handle );
+    /**
+    * Claim up to numDescriptors single descriptors from the occupancy bitmap of
+    * a slab page. This method does not take a lock and is safe to call from
+    * multiple threads.
+    * @return The number of descriptors that were written to offsets.
+    */
+    uint32_t AllocateSlabDescriptors( uint32_t numDescriptors, OffsetType* offsets );
 
-    // Adds a new block to the free list.
-    void AddNewBlock( uint32_t offset, uint32_t numDescriptors );
+    /**
+    * Return a range of descriptors back to the heap.
+    * @param fenceTag Stale descriptors are not freed directly, but put
+    * on a stale allocations queue. Stale allocations are returned to the heap
+    * using the DescriptorAllocatorPage::ReleaseStaleDescriptors method once
+    * the command queues have completed the fence values in the tag.
+    */
+    void Free( OffsetType offset, uint32_t numDescriptors, const FenceTag& fenceTag );
 
-    // Free a block of descriptors.
-    // This will also merge free blocks in the free list to form larger blocks
-    // that can be reused.
-    void FreeBlock( uint32_t offset, uint32_t numDescriptors );
+    /**
+    * Return a single descriptor that is no longer in use by the GPU directly
+    * back to the page (without going through the stale allocations queue).
+    * This does not take a lock for slab pages.
+    */
+    void ReleaseDescriptor( OffsetType offset );
 
-private:
-    // The offset (in descriptors) within the descriptor heap.
-    using OffsetType = uint32_t;
-    // The number of descriptors that are available.
-    using SizeType = uint32_t;
+    /**
+    * Release the descriptor heap of a slab page that has no allocated
+    * descriptors. All descriptors in the bitmap are marked as allocated so
+    * that other threads will not allocate from the page.
+    * @return false if any of the descriptors were allocated.
+    */
+    bool RetireSlab();
 
-    struct FreeBlockInfo;
-    // A map that lists the free blocks by the offset within the descriptor heap.
-    using FreeListByOffset = std::map<OffsetType, FreeBlockInfo>;
+    /**
+    * Create a new descriptor heap for a retired slab page and mark all
+    * descriptors as free.
+    */
+    void ReviveSlab();
 
-    // A map that lists the free blocks by size.
-    // Needs to be a multimap since multiple blocks can have the same size.
-    using FreeListBySize = std::multimap<SizeType, FreeListByOffset::iterator>;
+    /**
+    * Returned the stale descriptors back to the descriptor heap.
+    * Only the head of the stale allocations queue is checked once the fence
+    * values of a stale allocation have not been completed.
+    * @param completedFenceValues The completed fence values of the command queues.
+    * @return true if the page still has stale descriptors.
+    */
+    bool ReleaseStaleDescriptors( const FenceTag& completedFenceValues );
 
-    struct FreeBlockInfo
-    {
-        FreeBlockInfo( SizeType size )
-            : Size( size )
-        {}
+private:
+    // Create the descriptor heap for this page.
+    void CreateDescriptorHeap();
 
-        SizeType Size;
-        FreeListBySize::iterator FreeListBySizeIt;
-    };
+    // Set the occupancy bitmap of a slab page to all free descriptors.
+    // Only the bits of descriptors past the end of the heap are set.
+    void ResetSlabBitmap();
+
+    // Clear the occupancy bit of a descriptor in a slab page.
+    void FreeSlabDescriptor( OffsetType offset );
 
     struct StaleDescriptorInfo
     {
-        StaleDescriptorInfo( OffsetType offset, SizeType size, uint64_t frame )
+        StaleDescriptorInfo( OffsetType offset, SizeType size, const FenceTag& fenceTag )
             : Offset( offset )
             , Size( size )
-            , FrameNumber( frame )
+            , Fence( fenceTag )
         {}
 
         // The offset within the descriptor heap.
         OffsetType Offset;
         // The number of descriptors
         SizeType Size;
-        // The frame number that the descriptor was freed.
-        uint64_t FrameNumber;
+        // The fence values that must be completed before the descriptors can be reused.
+        FenceTag Fence;
     };
 
-    // Stale descriptors are queued for release until the frame that they were freed
-    // has completed.
+    // Stale descriptors are queued for release until the command queues have
+    // completed the fence values that they were tagged with.
     using StaleDescriptorQueue = std::queue<StaleDescriptorInfo>;
 
-    FreeListByOffset m_FreeListByOffset;
-    FreeListBySize m_FreeListBySize;
+    // The free list of descriptors within the descriptor heap.
+    TLSFAllocator m_FreeList;
     StaleDescriptorQueue m_StaleDescriptors;
+    // The total number of descriptors in the stale queue.
+    uint32_t m_NumStaleDescriptors;
+
+    // The indirection table of the ranges in a (non-slab) page. The offsets
+    // can be read without taking a lock.
+    std::unique_ptr<std::atomic<OffsetType>[]> m_SlotOffsets;
+    std::unique_ptr<SizeType[]> m_SlotSizes;
+    // The slot of the range that starts at an offset (InvalidOffset if no range starts there).
+    std::unique_ptr<OffsetType[]> m_OffsetSlots;
+    std::vector<OffsetType> m_FreeSlots;
+    // One bit per offset that is set if a range was moved to the offset in
+    // the current call to Compact.
+    std::unique_ptr<uint64_t[]> m_MovedBitmap;
+
+    // The occupancy bitmap of a slab page. A set bit is an allocated descriptor.
+    std::unique_ptr<std::atomic<uint64_t>[]> m_SlabBitmap;
+    uint32_t m_NumSlabWords;
+    // The word to start searching for free descriptors.
+    std::atomic<uint32_t> m_SlabHint;
+    bool m_IsSlab;
+
+    // The total number of descriptors that were allocated from the page.
+    std::atomic<uint64_t> m_NumAllocatedDescriptors;
 
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_d3d12DescriptorHeap;
     D3D12_DESCRIPTOR_HEAP_TYPE m_HeapType;
     CD3DX12_CPU_DESCRIPTOR_HANDLE m_BaseDescriptor;
     uint32_t m_DescriptorHandleIncrementSize;
     uint32_t m_NumDescriptorsInHeap;
-    uint32_t m_NumFreeHandles;
 
-    std::mutex m_AllocationMutex;
+    mutable std::mutex m_AllocationMutex;
 };
\ No newline at end of file
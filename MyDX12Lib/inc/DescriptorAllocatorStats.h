@@ -0,0 +1,84 @@
+#pragma once
+
+/**
+ *  @file DescriptorAllocatorStats.h
+ *
+ *  @brief Occupancy and fragmentation statistics of a DescriptorAllocator and
+ *  its pages. The statistics can be written as JSON so that the page size
+ *  (numDescriptorsPerHeap) can be chosen based on measured data.
+ */
+
+#include <d3d12.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The number of buckets in a free block size histogram. Bucket i counts the
+// free blocks with a size in the range [2^i, 2^(i+1)). The last bucket also
+// counts all larger blocks.
+static const uint32_t NumFreeBlockHistogramBuckets = 17;
+
+struct DescriptorPageStats
+{
+    // The index of the page in the page table of the allocator.
+    uint32_t PageIndex;
+    // The page only allocates single descriptors.
+    bool IsSlab;
+    // The descriptor heap of the (slab) page has been released.
+    bool IsRetired;
+
+    // The total number of descriptors in the page.
+    uint32_t NumDescriptors;
+    uint32_t NumFreeHandles;
+    // The largest allocation that is guaranteed to fit (a lower bound of the
+    // size of the largest free block).
+    uint32_t LargestFreeBlock;
+    uint32_t FreeBlockHistogram[NumFreeBlockHistogramBuckets];
+
+    // The number of entries in the stale queue of the page.
+    uint32_t StaleQueueDepth;
+    // The number of descriptors in the stale queue of the page.
+    uint32_t NumStaleDescriptors;
+
+    // The total number of descriptors that were allocated from the page.
+    // Single descriptors that are reused by the thread local magazines are
+    // not allocated from the page again.
+    uint64_t NumAllocatedDescriptors;
+    // The number of descriptors allocated from the page per second
+    // since the previous time that the statistics were queried.
+    double AllocationRate;
+};
+
+struct DescriptorAllocatorStats
+{
+    D3D12_DESCRIPTOR_HEAP_TYPE HeapType;
+    uint32_t NumDescriptorsPerHeap;
+
+    // Totals of all pages that have a descriptor heap.
+    uint32_t NumPages;
+    uint32_t NumDescriptors;
+    uint32_t NumFreeHandles;
+    uint32_t LargestFreeBlock;
+    uint32_t FreeBlockHistogram[NumFreeBlockHistogramBuckets];
+    // The number of descriptors in the stale queues of the pages.
+    uint32_t NumStaleDescriptors;
+
+    // The number of free descriptors that are cached by the thread local magazines.
+    uint32_t NumMagazineDescriptors;
+    // The number of stale descriptors in the thread local magazines.
+    uint32_t NumMagazineStaleDescriptors;
+
+    // The total number of allocations made with DescriptorAllocator::Allocate.
+    uint64_t NumAllocations;
+    // The number of allocations per second since the previous time that the
+    // statistics were queried.
+    double AllocationRate;
+
+    std::vector<DescriptorPageStats> Pages;
+
+    /**
+     * Write the statistics as a JSON object.
+     */
+    std::string ToJSON() const;
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+/**
+ *  @file DescriptorRing.h
+ *
+ *  @brief A process-wide ring of shader visible descriptors that is shared
+ *  by the DynamicDescriptorHeaps of all command lists.
+ *
+ *  The ring is divided into fixed-size chunks. A DynamicDescriptorHeap
+ *  requests a chunk when it runs out of descriptors and returns all of its
+ *  chunks when the command list is reset. Returned chunks are tagged with the
+ *  next fence values of the command queues and are reused (in the order that
+ *  they were returned) once the command queues have completed those values.
+ *
+ *  Since all chunks are taken from the same descriptor heap, moving to the next
+ *  chunk does not change the descriptor heap that is bound to the command list.
+ *  If every chunk is in use, another descriptor heap is added to the ring. The
+ *  memory that is used for shader visible descriptors therefore only grows to
+ *  the peak number of chunks in flight, regardless of the number of command lists.
+ *
+ *  The first descriptors of every descriptor heap of the ring can be reserved
+ *  for descriptors that must be visible at a fixed index (see
+ *  BindlessDescriptorHeap). The reserved descriptors are written to a CPU
+ *  visible descriptor heap and are copied to the same region of every
+ *  descriptor heap of the ring, so the command lists never need to switch
+ *  descriptor heaps to access them.
+ */
+
+#include "FenceTag.h"
+
+#include "d3dx12.h"
+
+#include <wrl.h>
+
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+class DescriptorRing
+{
+public:
+    // The number of descriptors in a chunk.
+    static constexpr uint32_t NumDescriptorsPerChunk = 1024;
+
+    /**
+     * A chunk of descriptors in one of the descriptor heaps of the ring.
+     */
+    struct Chunk
+    {
+        // The index of the chunk (used to free the chunk).
+        uint32_t Index;
+        ID3D12DescriptorHeap* DescriptorHeap;
+        D3D12_CPU_DESCRIPTOR_HANDLE BaseCPUDescriptor;
+        D3D12_GPU_DESCRIPTOR_HANDLE BaseGPUDescriptor;
+    };
+
+    /**
+     * @param type The type of the shader visible descriptor heaps.
+     * @param numDescriptorsPerHeap The number of descriptors in the chunks of
+     * each descriptor heap of the ring (rounded down to a multiple of the chunk size).
+     * @param numReservedDescriptors The number of descriptors that are reserved
+     * at the start of each descriptor heap of the ring.
+     */
+    DescriptorRing( D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerHeap, uint32_t numReservedDescriptors = 0 );
+
+    D3D12_DESCRIPTOR_HEAP_TYPE GetHeapType() const
+    {
+        return m_HeapType;
+    }
+
+    /**
+     * Get the number of descriptor heaps that were created for the ring.
+     */
+    uint32_t GetNumDescriptorHeaps() const;
+
+    uint32_t GetNumReservedDescriptors() const
+    {
+        return m_NumReservedDescriptors;
+    }
+
+    /**
+     * Get the CPU visible descriptor of a reserved descriptor. Views that are
+     * written to the descriptor are not visible to shaders until they are
+     * committed with CommitReservedDescriptors.
+     */
+    D3D12_CPU_DESCRIPTOR_HANDLE GetReservedCPUDescriptorHandle( uint32_t index ) const;
+
+    /**
+     * Copy a range of reserved descriptors to every descriptor heap of the ring.
+     * The descriptors must not be in use by the GPU.
+     */
+    void CommitReservedDescriptors( uint32_t index, uint32_t numDescriptors );
+
+    /**
+     * Allocate a chunk of descriptors. The chunk is taken from the first
+     * descriptor heap in the ring that has a free chunk.
+     */
+    Chunk AllocateChunk();
+
+    /**
+     * Return a chunk to the ring. The chunk is not reused until the command
+     * queues have completed the fence values in the fence tag.
+     */
+    void FreeChunk( uint32_t chunkIndex, const FenceTag& fenceTag );
+
+    /**
+     * Return the stale chunks back to the ring.
+     * @param completedFenceValues The completed fence values of the command queues.
+     */
+    void ReleaseStaleDescriptors( const FenceTag& completedFenceValues );
+
+private:
+    // Add a descriptor heap to the ring and make its chunks available.
+    void CreateDescriptorHeap();
+
+    struct StaleChunkInfo
+    {
+        StaleChunkInfo( uint32_t chunkIndex, const FenceTag& fenceTag )
+            : ChunkIndex( chunkIndex )
+            , Fence( fenceTag )
+        {}
+
+        // The index of the chunk.
+        uint32_t ChunkIndex;
+        // The fence values that must be completed before the chunk can be reused.
+        FenceTag Fence;
+    };
+
+    using ChunkQueue = std::queue<uint32_t>;
+    using StaleChunkQueue = std::queue<StaleChunkInfo>;
+
+    std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> m_DescriptorHeaps;
+    // The CPU visible copy of the reserved descriptors.
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_ReservedDescriptorHeap;
+    CD3DX12_CPU_DESCRIPTOR_HANDLE m_BaseReservedDescriptor;
+    // The chunks that are available, in the order that they should be reused.
+    ChunkQueue m_AvailableChunks;
+    StaleChunkQueue m_StaleChunks;
+
+    D3D12_DESCRIPTOR_HEAP_TYPE m_HeapType;
+    uint32_t m_DescriptorHandleIncrementSize;
+    uint32_t m_NumChunksPerHeap;
+    uint32_t m_NumReservedDescriptors;
+
+    mutable std::mutex m_ChunkMutex;
+};
\ No newline at end of file
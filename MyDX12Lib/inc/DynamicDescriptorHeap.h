@@ -10,26 +10,51 @@
  *  or Dispatch command is executed.
  *  The DynamicDescriptorHeap class is based on the one provided by the MiniEngine:
  *  https://github.com/Microsoft/DirectX-Graphics-Samples
+ *
+ *  Descriptor tables that are static (see RootSignature::GetStaticDescriptorTableBitMask)
+ *  are copied to a persistent region at the end of the current chunk (see
+ *  below). When a static table is committed again with the same descriptors, it
+ *  is bound from the persistent region instead of being copied again. The
+ *  chunks are kept until the dynamic descriptor heap is reset, so persistent
+ *  tables in previous chunks are reused until the descriptor heap changes.
+ *
+ *  Other descriptor tables that are copied to the heap are remembered in a small
+ *  cache (keyed by the hash of the staged descriptors). A table that is staged
+ *  again with the same descriptors reuses the copy in the current chunk, unless
+ *  it contains volatile descriptors (D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE).
+ *  The tables (and the static tables in the persistent regions) are identified
+ *  by their CPU visible descriptor handles, so the cache and the persistent
+ *  tables are forgotten when a descriptor of the heap type is freed or retired
+ *  (see DescriptorAllocator::GetFreeGeneration), since the handle can then be
+ *  reused for a different view while the command list is being recorded.
+ *
+ *  The GPU visible descriptors are taken in chunks from the process-wide
+ *  DescriptorRing of the descriptor heap type (see Application::GetDescriptorRing).
+ *  The chunks are returned to the ring when the dynamic descriptor heap is reset.
+ *
+ *  The bindless descriptors (see BindlessDescriptorHeap) are reserved at the
+ *  start of every descriptor heap of the ring. The bindless descriptor tables
+ *  are set through the dynamic descriptor heap so that they can be rebound
+ *  when a chunk is taken from a different descriptor heap.
  */
 
+#include "RootSignature.h"
+
 #include "d3dx12.h"
 
 #include <wrl.h>
 
 #include <cstdint>
-#include <functional>
 #include <memory>
-#include <queue>
+#include <unordered_map>
+#include <vector>
 
 class CommandList;
-class RootSignature;
 
 class DynamicDescriptorHeap
 {
 public:
-    DynamicDescriptorHeap(
-        D3D12_DESCRIPTOR_HEAP_TYPE heapType,
-        uint32_t numDescriptorsPerHeap = 1024);
+    explicit DynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE heapType);
 
     virtual ~DynamicDescriptorHeap();
 
@@ -43,15 +68,10 @@ public:
     /**
      * Copy all of the staged descriptors to the GPU visible descriptor heap and
      * bind the descriptor heap and the descriptor tables to the command list.
-     * The passed-in function object is used to set the GPU visible descriptors
-     * on the command list. Two possible functions are:
+     * The descriptor tables are set on the command list using:
      *   * Before a draw    : ID3D12GraphicsCommandList::SetGraphicsRootDescriptorTable
      *   * Before a dispatch: ID3D12GraphicsCommandList::SetComputeRootDescriptorTable
-     * 
-     * Since the DynamicDescriptorHeap can't know which function will be used, it must
-     * be passed as an argument to the function.
      */
-    void CommitStagedDescriptors( CommandList& commandList, std::function<void(ID3D12GraphicsCommandList*, UINT, D3D12_GPU_DESCRIPTOR_HANDLE)> setFunc );
     void CommitStagedDescriptorsForDraw(CommandList& commandList);
     void CommitStagedDescriptorsForDispatch(CommandList& commandList);
 
@@ -73,72 +93,177 @@ public:
     D3D12_GPU_DESCRIPTOR_HANDLE CopyDescriptor( CommandList& commandList, D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptor);
 
     /**
-     * Parse the root signature to determine which root parameters contain
-     * descriptor tables and determine the number of descriptors needed for
-     * each table.
+     * Set the descriptor table at the root parameter index to the start of the
+     * bindless descriptors in the current descriptor heap. The table is set
+     * again whenever the descriptor heap changes, until the root signature
+     * is changed or the dynamic descriptor heap is reset.
      */
-    void ParseRootSignature( const RootSignature& rootSignature);
+    void SetGraphicsBindlessDescriptorTable(CommandList& commandList, uint32_t rootParameterIndex);
+    void SetComputeBindlessDescriptorTable(CommandList& commandList, uint32_t rootParameterIndex);
+
+    /**
+     * Use the descriptor table layout of the root signature to determine which
+     * root parameters contain descriptor tables and the number of descriptors
+     * needed for each table. The layout is computed by the root signature, so
+     * this only stores a pointer to it. The root signature must not be
+     * destroyed while it is set.
+     */
+    void SetRootSignature( const RootSignature& rootSignature);
 
     /**
      * Reset used descriptors. This should only be done if any descriptors
      * that are being referenced by a command list has finished executing on the 
-     * command queue.
+     * command queue. The chunks of the descriptor ring are returned to the ring
+     * and are reused once the command queues reach their next fence values.
      */
     void Reset();
 
+    /**
+     * Get the number of bytes that are used by the CPU visible descriptor
+     * handle caches.
+     */
+    size_t GetMemoryUsage() const;
+
+    /**
+     * Get the number of bytes of the chunks of the descriptor ring that were
+     * used since the last reset.
+     */
+    size_t GetShaderVisibleMemoryUsage() const;
+
 protected:
 
 private:
-    // Request a descriptor heap if one is available.
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> RequestDescriptorHeap();
-    // Create a new descriptor heap of no descriptor heap is available.
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap();
+    // Request a new chunk from the descriptor ring. The descriptor heap is
+    // only bound to the command list if the chunk is in a different heap.
+    void RequestDescriptorChunk(CommandList& commandList);
+
+    // Return the chunks that were used since the last reset to the descriptor ring.
+    void FreeDescriptorChunks();
 
     // Compute the number of stale descriptors that need to be copied
     // to GPU visible descriptor heap.
     uint32_t ComputeStaleDescriptorCount() const;
 
+    // Commit the staged descriptors for a pipeline (graphics or compute). The
+    // pipeline type provides the function that sets the descriptor tables on
+    // the command list so that the call can be inlined.
+    template<typename Pipeline>
+    void CommitStagedDescriptors(CommandList& commandList);
+
+    // Bind the stale static descriptor tables from the persistent region of
+    // the current chunk. Tables that are not in the persistent region
+    // yet are copied to it. Tables that don't fit in the chunk are left stale.
+    template<typename Pipeline>
+    void CommitStaticDescriptorTables(ID3D12GraphicsCommandList* d3d12GraphicsCommandList);
+
+    // Bind the stale descriptor tables that match a table that was already
+    // copied to the current chunk.
+    template<typename Pipeline>
+    void CommitCachedDescriptorTables(ID3D12GraphicsCommandList* d3d12GraphicsCommandList);
+
+    // Clear the cache of the descriptor tables that were copied to the current chunk.
+    void ResetCommittedDescriptorTables();
+
+    // Clear the caches of copied descriptor tables if a CPU visible descriptor
+    // of the heap type was freed or retired since the previous commit.
+    void ValidateDescriptorTableCaches();
+
+    // Set the bindless descriptor table of a pipeline (graphics or compute).
+    template<typename Pipeline>
+    void SetBindlessDescriptorTable(CommandList& commandList, uint32_t rootParameterIndex);
+
+    // Set the bindless descriptor tables of both pipelines to the start of
+    // the current descriptor heap.
+    void BindBindlessDescriptorTables(ID3D12GraphicsCommandList* d3d12GraphicsCommandList);
+
     /**
      * The maximum number of descriptor tables per root signature.
-     * A 32-bit mask is used to keep track of the root parameter indices that
-     * are descriptor tables.
      */
-    static const uint32_t MaxDescriptorTables = 32;
+    static const uint32_t MaxDescriptorTables = RootSignature::MaxDescriptorTables;
+
+    // Returned if a descriptor table is not in the persistent region.
+    static const uint32_t InvalidOffset = UINT32_MAX;
+
+    // The number of entries in the cache of committed descriptor tables.
+    static const uint32_t NumCommittedDescriptorTables = 64;
+
+    // The number of pipelines (graphics and compute).
+    static const uint32_t NumPipelines = 2;
+
+    /**
+     * A static descriptor table that was copied to a persistent region.
+     */
+    struct PersistentDescriptorTable
+    {
+        // The GPU visible descriptor of the table. It stays valid until the
+        // descriptor heap changes.
+        D3D12_GPU_DESCRIPTOR_HANDLE BaseDescriptor;
+        // The offset of the CPU visible descriptors of the table in the
+        // persistent descriptor handle cache.
+        uint32_t HandleOffset;
+        uint32_t NumDescriptors;
+    };
+
+    /**
+     * A descriptor table that was copied to the current chunk.
+     */
+    struct CommittedDescriptorTable
+    {
+        // The hash of the CPU visible descriptors of the table.
+        std::size_t Hash;
+        // The offset of the table in the descriptor heap.
+        uint32_t Offset;
+    };
 
     /**
      * A structure that represents a descriptor table entry in the root signature.
      */
     struct DescriptorTableCache
     {
-        DescriptorTableCache()
-            : NumDescriptors(0)
-            , BaseDescriptor(nullptr)
-        {}
-
-        // Reset the table cache.
-        void Reset()
-        {
-            NumDescriptors = 0;
-            BaseDescriptor = nullptr;
-        }
-
         // The number of descriptors in this descriptor table.
         uint32_t NumDescriptors;
         // The pointer to the descriptor in the descriptor handle cache.
         D3D12_CPU_DESCRIPTOR_HANDLE* BaseDescriptor;
     };
 
+    // Get the staged descriptors of the descriptor table at a root parameter index.
+    DescriptorTableCache GetDescriptorTableCache(uint32_t rootIndex) const;
+
+    // Queue a copy of the staged descriptors of a descriptor table to an
+    // offset in the current chunk.
+    void QueueDescriptorCopy(uint32_t offset, const DescriptorTableCache& descriptorTableCache);
+
+    // Copy all of the queued descriptors with a single call to
+    // ID3D12Device::CopyDescriptors.
+    void FlushDescriptorCopies();
+
+    // Compute the hash of the staged descriptors of a descriptor table.
+    static std::size_t HashDescriptorTable(const DescriptorTableCache& descriptorTableCache);
+
+    // Find the GPU visible descriptor of a descriptor table in the persistent
+    // regions of the chunks in the current descriptor heap (a null handle if
+    // the table is not found).
+    D3D12_GPU_DESCRIPTOR_HANDLE FindPersistentDescriptorTable(std::size_t hash, const DescriptorTableCache& descriptorTableCache) const;
+
+    // Forget the persistent descriptor tables (when the descriptor heap changes).
+    void ResetPersistentDescriptorTables();
+
+    // Check to see if the staged descriptors of a descriptor table were
+    // copied to an offset in the current chunk.
+    bool IsCopiedDescriptorTable(uint32_t offset, const DescriptorTableCache& descriptorTableCache) const;
+
     // Describes the type of descriptors that can be staged using this 
     // dynamic descriptor heap.
     // Valid values are:
     //   * D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV
-    //   * D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER
+    //   * D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER (the CommandList binds sampler
+    //     tables from the global SamplerHeap instead)
     // This parameter also determines the type of GPU visible descriptor heap to 
     // create.
     D3D12_DESCRIPTOR_HEAP_TYPE m_DescriptorHeapType;
 
-    // The number of descriptors to allocate in new GPU visible descriptor heaps.
-    uint32_t m_NumDescriptorsPerHeap;
+    // The number of descriptors in a chunk of the descriptor ring.
+    uint32_t m_NumDescriptorsPerChunk;
 
     // The increment size of a descriptor.
     uint32_t m_DescriptorHandleIncrementSize;
@@ -146,26 +271,62 @@ private:
     // The descriptor handle cache.
     std::unique_ptr<D3D12_CPU_DESCRIPTOR_HANDLE[]> m_DescriptorHandleCache;
 
-    // Descriptor handle cache per descriptor table.
-    DescriptorTableCache m_DescriptorTableCache[MaxDescriptorTables];
+    // The layout of the descriptor tables of the current root signature
+    // (the bit masks of the descriptor tables and the offset of each table in
+    // the descriptor handle cache).
+    const RootSignature::DescriptorTableLayout* m_DescriptorTableLayout;
 
-    // Each bit in the bit mask represents the index in the root signature
-    // that contains a descriptor table.
-    uint32_t m_DescriptorTableBitMask;
     // Each bit set in the bit mask represents a descriptor table
     // in the root signature that has changed since the last time the 
     // descriptors were copied.
     uint32_t m_StaleDescriptorTableBitMask;
 
-    using DescriptorHeapPool = std::queue< Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> >;
+    // The indices of the chunks of the descriptor ring that were used since
+    // the last reset.
+    std::vector<uint32_t> m_DescriptorChunks;
 
-    DescriptorHeapPool m_DescriptorHeapPool;
-    DescriptorHeapPool m_AvailableDescriptorHeaps;
+    // The root parameter indices of the bindless descriptor tables of the
+    // graphics and compute pipelines (InvalidOffset if not set).
+    uint32_t m_BindlessRootParameterIndices[NumPipelines];
 
-    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_CurrentDescriptorHeap;
+    // The descriptor heap (of the descriptor ring) that contains the current chunk.
+    ID3D12DescriptorHeap* m_CurrentDescriptorHeap;
     CD3DX12_GPU_DESCRIPTOR_HANDLE m_CurrentGPUDescriptorHandle;
     CD3DX12_CPU_DESCRIPTOR_HANDLE m_CurrentCPUDescriptorHandle;
+    // The start of the current chunk.
+    CD3DX12_GPU_DESCRIPTOR_HANDLE m_BaseGPUDescriptorHandle;
+    CD3DX12_CPU_DESCRIPTOR_HANDLE m_BaseCPUDescriptorHandle;
 
+    // The number of free handles between the dynamic descriptors (at the start
+    // of the chunk) and the persistent region (at the end of the chunk).
     uint32_t m_NumFreeHandles;
+
+    // The number of descriptors in the persistent region of the current chunk.
+    uint32_t m_NumPersistentDescriptors;
+    // Maps the hash of the descriptors of a static table to the table in the
+    // persistent region of a chunk in the current descriptor heap.
+    std::unordered_multimap<std::size_t, PersistentDescriptorTable> m_PersistentDescriptorTables;
+    // The CPU visible descriptors of the persistent descriptor tables (used
+    // to verify that a table matches the staged descriptors).
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_PersistentDescriptorHandleCache;
+    // The CPU visible descriptors that were copied to each offset of the
+    // current chunk.
+    std::unique_ptr<D3D12_CPU_DESCRIPTOR_HANDLE[]> m_CopiedDescriptorHandleCache;
+
+    // The descriptor tables that were copied to the dynamic descriptors of the
+    // current chunk, indexed by the hash of the table.
+    CommittedDescriptorTable m_CommittedDescriptorTables[NumCommittedDescriptorTables];
+    // The free generation of the CPU visible descriptors when the caches were
+    // last validated (see DescriptorAllocator::GetFreeGeneration).
+    uint64_t m_FreeGeneration;
+
+    // The descriptor copies that are queued during a commit. Each destination
+    // range holds one or more adjacent descriptor tables and the source
+    // descriptors are gathered in the same order.
+    D3D12_CPU_DESCRIPTOR_HANDLE m_CopyDestDescriptorRangeStarts[MaxDescriptorTables];
+    UINT m_CopyDestDescriptorRangeSizes[MaxDescriptorTables];
+    uint32_t m_NumCopyDestDescriptorRanges;
+    std::unique_ptr<D3D12_CPU_DESCRIPTOR_HANDLE[]> m_CopySrcDescriptorHandles;
+    uint32_t m_NumCopySrcDescriptors;
     
 };
\ No newline at end of file
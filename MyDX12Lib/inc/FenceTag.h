@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ *  @file FenceTag.h
+ *
+ *  @brief A fence tag records a fence value for each of the command queues
+ *  (direct, compute and copy). Resources that are released are tagged with the
+ *  fence values that will be signaled next on each queue (see
+ *  Application::GetNextFenceTag) and can be reused once all of the command
+ *  queues have completed those fence values. This assumes that the command
+ *  lists that use a resource have been executed before the resource is tagged
+ *  (see BindlessDescriptorHeap::FreeDeferred for resources that are released
+ *  while a command list is being recorded).
+ *
+ *  Fence values only increase, so tags that are created later are never
+ *  completed before tags that were created earlier. This allows stale resources
+ *  to be kept in a FIFO queue.
+ */
+
+#include <cstdint>
+
+struct FenceTag
+{
+    // The command queues that are tracked by the fence tag.
+    enum Queue
+    {
+        Direct,
+        Compute,
+        Copy,
+        NumQueues
+    };
+
+    uint64_t FenceValues[NumQueues];
+
+    /**
+     * Check to see if all of the fence values in this tag have been completed.
+     * @param completedFenceValues The completed fence values of the command queues.
+     */
+    bool IsComplete( const FenceTag& completedFenceValues ) const
+    {
+        for ( uint32_t i = 0; i < NumQueues; ++i )
+        {
+            if ( FenceValues[i] > completedFenceValues.FenceValues[i] )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
@@ -24,7 +24,7 @@ inline void ThrowIfFailed(HRESULT hr)
     }
 }
 
-// Hashers for view descriptions.
+// Hashers for view and sampler descriptions.
 namespace std
 {
     // Source: https://stackoverflow.com/questions/2590677/how-do-i-combine-hash-values-in-c0x
@@ -161,6 +161,31 @@ namespace std
             return seed;
         }
     };
+
+    template<>
+    struct hash<D3D12_SAMPLER_DESC>
+    {
+        std::size_t operator()(const D3D12_SAMPLER_DESC& samplerDesc) const noexcept
+        {
+            std::size_t seed = 0;
+
+            hash_combine(seed, samplerDesc.Filter);
+            hash_combine(seed, samplerDesc.AddressU);
+            hash_combine(seed, samplerDesc.AddressV);
+            hash_combine(seed, samplerDesc.AddressW);
+            hash_combine(seed, samplerDesc.MipLODBias);
+            hash_combine(seed, samplerDesc.MaxAnisotropy);
+            hash_combine(seed, samplerDesc.ComparisonFunc);
+            hash_combine(seed, samplerDesc.BorderColor[0]);
+            hash_combine(seed, samplerDesc.BorderColor[1]);
+            hash_combine(seed, samplerDesc.BorderColor[2]);
+            hash_combine(seed, samplerDesc.BorderColor[3]);
+            hash_combine(seed, samplerDesc.MinLOD);
+            hash_combine(seed, samplerDesc.MaxLOD);
+
+            return seed;
+        }
+    };
 }
 
 namespace Math
@@ -0,0 +1,86 @@
+#pragma once
+
+/**
+ *  @file LinearDescriptorAllocator.h
+ *
+ *  @brief A linear (bump) allocator for CPU visible descriptors of transient
+ *  views that are only used for a single frame or pass (for example the
+ *  staging textures that are used to generate mips).
+ *
+ *  Descriptors are allocated by incrementing an offset in the current page and
+ *  are never freed individually. At the end of every frame (and when the
+ *  current page is full), the current page is retired with the fence values
+ *  that will be signaled next on the command queues and is reset in bulk once
+ *  the command queues have completed those fence values. The descriptors must
+ *  therefore only be used by command lists that are executed in the frame that
+ *  the descriptors were allocated in.
+ *  This keeps short lived views out of the pages of the DescriptorAllocator
+ *  where they would fragment the free lists.
+ */
+
+#include "FenceTag.h"
+
+#include "d3dx12.h"
+
+#include <wrl.h>
+
+#include <cstdint>
+#include <mutex>
+#include <queue>
+
+class LinearDescriptorAllocator
+{
+public:
+    LinearDescriptorAllocator( D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerPage = 1024 );
+
+    /**
+     * Allocate a number of contiguous descriptors. The descriptors stay valid
+     * until the command queues have completed the commands that were executed
+     * before the page was retired.
+     * @throws std::bad_alloc if more descriptors are requested than fit in a page.
+     */
+    D3D12_CPU_DESCRIPTOR_HANDLE Allocate( uint32_t numDescriptors = 1 );
+
+    /**
+     * Retire the current page (if any descriptors were allocated from it).
+     * This is called once per frame after the command lists of the frame have
+     * been executed (see Application::EndFrame).
+     */
+    void RetireCurrentPage();
+
+    /**
+     * Reset the retired pages whose fence values have been completed.
+     * @param completedFenceValues The completed fence values of the command queues.
+     */
+    void ReleaseStaleDescriptors( const FenceTag& completedFenceValues );
+
+private:
+    // Get a page from the available pages or create a new page.
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> RequestPage();
+
+    // Move the current page to the retired pages. The allocation mutex must be locked.
+    void RetirePage();
+
+    struct RetiredPage
+    {
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> DescriptorHeap;
+        // The fence values that must be completed before the page can be reset.
+        FenceTag Fence;
+    };
+
+    using PageQueue = std::queue< Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> >;
+    using RetiredPageQueue = std::queue<RetiredPage>;
+
+    D3D12_DESCRIPTOR_HEAP_TYPE m_HeapType;
+    uint32_t m_NumDescriptorsPerPage;
+    uint32_t m_DescriptorHandleIncrementSize;
+
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_CurrentPage;
+    CD3DX12_CPU_DESCRIPTOR_HANDLE m_CurrentDescriptor;
+    uint32_t m_NumFreeHandles;
+
+    PageQueue m_AvailablePages;
+    RetiredPageQueue m_RetiredPages;
+
+    std::mutex m_AllocationMutex;
+};
\ No newline at end of file
@@ -7,13 +7,25 @@
  *
  *  @brief A wrapper for a DX12 resource. This provides a base class for all 
  *  other resource types (Buffers & Textures).
+ *
+ *  Views that are requested with a view description are cached per resource
+ *  (keyed by the description) so that requesting the same view again returns
+ *  the existing CPU descriptor instead of creating a new one.
  */
 
+#include "DescriptorAllocation.h"
+// For the hash of the view descriptions.
+#include "Helpers.h"
+
 #include <d3d12.h>
 #include <wrl.h>
 
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_map>
 
 class Resource
 {
@@ -63,19 +75,51 @@ public:
 
     /**
      * Get the SRV for a resource.
+     * The view is created the first time it is requested and cached with the
+     * resource. The cached views are released when the resource is replaced.
      * 
      * @param srvDesc The description of the SRV to return. The default is nullptr 
      * which returns the default SRV for the resource (the SRV that is created when no 
      * description is provided.
      */
-    virtual D3D12_CPU_DESCRIPTOR_HANDLE GetShaderResourceView( const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc = nullptr ) const = 0;
+    virtual D3D12_CPU_DESCRIPTOR_HANDLE GetShaderResourceView( const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc = nullptr ) const;
 
     /**
      * Get the UAV for a (sub)resource.
+     * The view is created the first time it is requested and cached with the
+     * resource.
      * 
      * @param uavDesc The description of the UAV to return.
      */
-    virtual D3D12_CPU_DESCRIPTOR_HANDLE GetUnorderedAccessView( const D3D12_UNORDERED_ACCESS_VIEW_DESC* uavDesc = nullptr ) const = 0;
+    virtual D3D12_CPU_DESCRIPTOR_HANDLE GetUnorderedAccessView( const D3D12_UNORDERED_ACCESS_VIEW_DESC* uavDesc = nullptr ) const;
+
+    /**
+     * Mark the resource as transient (only used for a single frame or pass).
+     * Views of transient resources are allocated from the linear descriptor
+     * allocator instead of the general purpose descriptor allocator. These
+     * views are only valid for the current frame, so they are not cached and
+     * a new view is created every time a view is requested.
+     * Any views that were already created are released.
+     */
+    void SetTransient( bool isTransient );
+
+    bool IsTransient() const
+    {
+        return m_IsTransient;
+    }
+
+    /**
+     * Get the index of the default SRV in the bindless descriptor heap.
+     * The view is copied to the bindless heap the first time the index is
+     * requested and the index stays the same until the underlying resource is
+     * replaced or released.
+     */
+    uint32_t GetBindlessShaderResourceIndex() const;
+
+    /**
+     * Get the index of the default UAV in the bindless descriptor heap.
+     */
+    uint32_t GetBindlessUnorderedAccessIndex() const;
 
     /**
      * Set the name of the resource. Useful for debugging purposes.
@@ -95,4 +139,49 @@ protected:
     Microsoft::WRL::ComPtr<ID3D12Resource> m_d3d12Resource;
     std::unique_ptr<D3D12_CLEAR_VALUE> m_d3d12ClearValue;
     std::wstring m_ResourceName;
+
+private:
+    // Return the bindless indices to the bindless descriptor heap.
+    void ReleaseBindlessIndices();
+
+    // Release the cached views of the resource.
+    void ReleaseViews();
+
+    // Get (or create) a cached view. Views of transient resources are
+    // created every time. The view mutex must be locked.
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCachedShaderResourceView( const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc ) const;
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCachedUnorderedAccessView( const D3D12_UNORDERED_ACCESS_VIEW_DESC* uavDesc ) const;
+
+    // The key of a view is its description (std::nullopt for the default view).
+    template<typename ViewDesc>
+    using ViewKey = std::optional<ViewDesc>;
+
+    // View descriptions are compared bitwise (like the samplers in the
+    // SamplerHeap), so unused members of a description should be zero.
+    template<typename ViewDesc>
+    struct ViewKeyEqual
+    {
+        bool operator()( const ViewKey<ViewDesc>& a, const ViewKey<ViewDesc>& b ) const
+        {
+            return a.has_value() == b.has_value() && ( !a || memcmp( &*a, &*b, sizeof( ViewDesc ) ) == 0 );
+        }
+    };
+
+    // The views that have been created for this resource keyed by the view
+    // description. Descriptions with the same hash are stored separately.
+    // The descriptor of a view is resolved through its allocation on every
+    // use, since the allocator can relocate descriptors (see DescriptorAllocator::Compact).
+    template<typename ViewDesc>
+    using ViewMap = std::unordered_map<ViewKey<ViewDesc>, DescriptorAllocation, std::hash<ViewKey<ViewDesc>>, ViewKeyEqual<ViewDesc>>;
+
+    mutable ViewMap<D3D12_SHADER_RESOURCE_VIEW_DESC> m_ShaderResourceViews;
+    mutable ViewMap<D3D12_UNORDERED_ACCESS_VIEW_DESC> m_UnorderedAccessViews;
+    mutable std::mutex m_ViewMutex;
+
+    bool m_IsTransient;
+
+    // The indices of the default views in the bindless descriptor heap.
+    // The indices are assigned on first use while holding the view mutex.
+    mutable uint32_t m_BindlessSRVIndex;
+    mutable uint32_t m_BindlessUAVIndex;
 };
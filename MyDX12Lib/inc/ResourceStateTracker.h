@@ -77,6 +77,12 @@ public:
      */
     void Reset();
 
+    /**
+     * Get the (approximate) number of bytes that are used by the resource
+     * barriers and the final resource states of the command list.
+     */
+    size_t GetMemoryUsage() const;
+
     /**
      * The global state must be locked before flushing pending resource barriers
      * and committing the final resource state to the global resource state.
@@ -9,6 +9,10 @@
  *  the D3D12_ROOT_SIGNATURE_DESC used to create it. This provides the 
  *  functionality necessary for the DynamicDescriptorHeap to determine the 
  *  layout of the root signature at runtime.
+ *
+ *  The layout of the descriptor tables of each descriptor heap type is computed
+ *  once when the root signature description is set, so binding the root
+ *  signature to a DynamicDescriptorHeap only needs to swap a pointer.
  */
 
 
@@ -21,6 +25,37 @@
 class RootSignature
 {
 public:
+    /**
+     * The maximum number of descriptor tables per root signature.
+     * A 32-bit mask is used to keep track of the root parameter indices that
+     * are descriptor tables.
+     */
+    static const uint32_t MaxDescriptorTables = 32;
+
+    /**
+     * The layout of the descriptor tables of a single descriptor heap type.
+     */
+    struct DescriptorTableLayout
+    {
+        // Each bit in the bit mask represents a root parameter index that
+        // contains a descriptor table of the descriptor heap type.
+        uint32_t DescriptorTableBitMask;
+        // The descriptor tables in which every range is marked with
+        // D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC and none of the ranges is
+        // marked with D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE.
+        uint32_t StaticDescriptorTableBitMask;
+        // The descriptor tables in which any of the ranges is marked with
+        // D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE.
+        uint32_t VolatileDescriptorTableBitMask;
+        // The total number of descriptors in the descriptor tables.
+        uint32_t NumDescriptors;
+        // The number of descriptors in each descriptor table.
+        uint32_t NumDescriptorsPerTable[MaxDescriptorTables];
+        // The offset of each descriptor table from the first descriptor of the
+        // first table. The tables are packed in root parameter order.
+        uint32_t DescriptorTableOffsets[MaxDescriptorTables];
+    };
+
     RootSignature();
     RootSignature(
         const D3D12_ROOT_SIGNATURE_DESC1& rootSignatureDesc, 
@@ -46,7 +81,29 @@ public:
         return m_RootSignatureDesc;
     }
 
+    /**
+     * Get the layout of the descriptor tables of a descriptor heap type. The
+     * layout of the RTV and DSV heap types is always empty.
+     */
+    const DescriptorTableLayout& GetDescriptorTableLayout(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) const
+    {
+        return m_DescriptorTableLayouts[descriptorHeapType];
+    }
+
     uint32_t GetDescriptorTableBitMask(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) const;
+
+    /**
+     * Get a bit mask of the descriptor tables in which every range is marked
+     * with D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC and none of the ranges is
+     * marked with D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE.
+     */
+    uint32_t GetStaticDescriptorTableBitMask(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) const;
+
+    /**
+     * Get a bit mask of the descriptor tables in which any of the ranges is
+     * marked with D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE.
+     */
+    uint32_t GetVolatileDescriptorTableBitMask(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) const;
     uint32_t GetNumDescriptors(uint32_t rootIndex) const;
 
 private:
@@ -56,12 +113,9 @@ private:
     // Need to know the number of descriptors per descriptor table.
     // A maximum of 32 descriptor tables are supported (since a 32-bit
     // mask is used to represent the descriptor tables in the root signature.
-    uint32_t m_NumDescriptorsPerTable[32];
-
-    // A bit mask that represents the root parameter indices that are 
-    // descriptor tables for Samplers.
-    uint32_t m_SamplerTableBitMask;
-    // A bit mask that represents the root parameter indices that are 
-    // CBV, UAV, and SRV descriptor tables.
-    uint32_t m_DescriptorTableBitMask;
+    uint32_t m_NumDescriptorsPerTable[MaxDescriptorTables];
+
+    // The layout of the descriptor tables of each descriptor heap type.
+    // Only the CBV_SRV_UAV and SAMPLER layouts contain descriptor tables.
+    DescriptorTableLayout m_DescriptorTableLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
 };
@@ -0,0 +1,100 @@
+#pragma once
+
+/**
+ *  @file SamplerHeap.h
+ *
+ *  @brief A single, shader visible sampler descriptor heap that holds every
+ *  unique sampler that is used by the application.
+ *
+ *  Samplers are identified by the hash of their D3D12_SAMPLER_DESC. The first
+ *  time a sampler (or a table of samplers) is requested, it is created in the
+ *  next free slot of the heap. The slot is permanent, so every later request
+ *  for the same sampler returns the same slot and sampler descriptor tables
+ *  never need to be copied to a DynamicDescriptorHeap. Since the sampler heap
+ *  is never replaced, binding sampler tables also never causes the descriptor
+ *  heaps on the command list to switch.
+ *
+ *  Shader visible sampler heaps are limited to 2048 samplers
+ *  (D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE).
+ */
+
+#include "d3dx12.h"
+
+#include <wrl.h>
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class SamplerHeap
+{
+public:
+    static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+    /**
+     * @param numSamplers The number of samplers in the shader visible heap.
+     */
+    explicit SamplerHeap( uint32_t numSamplers = D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE );
+
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> GetDescriptorHeap() const
+    {
+        return m_d3d12DescriptorHeap;
+    }
+
+    uint32_t GetNumSamplers() const
+    {
+        return m_NumSamplersInHeap;
+    }
+
+    /**
+     * Get the number of unique samplers that have been created in the heap.
+     */
+    uint32_t GetNumAllocatedSamplers() const;
+
+    /**
+     * Get the GPU descriptor handle of the sampler at a particular index.
+     */
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandle( uint32_t index = 0 ) const;
+
+    /**
+     * Get the index of a sampler in the heap. The sampler is created the
+     * first time it is requested.
+     * @throws std::bad_alloc if the heap is full.
+     */
+    uint32_t GetSamplerIndex( const D3D12_SAMPLER_DESC& samplerDesc );
+
+    /**
+     * Get the index of the first sampler of a contiguous table of samplers.
+     * The table is created the first time it is requested and shares the
+     * slots of an identical table that was created before.
+     * @throws std::bad_alloc if the heap is full.
+     */
+    uint32_t GetSamplerTable( const D3D12_SAMPLER_DESC* samplerDescs, uint32_t numSamplers );
+
+private:
+    static std::size_t HashSamplerTable( const D3D12_SAMPLER_DESC* samplerDescs, uint32_t numSamplers );
+
+    // Find the index of a table of samplers that was created before (or InvalidIndex).
+    uint32_t FindSamplerTable( std::size_t hash, const D3D12_SAMPLER_DESC* samplerDescs, uint32_t numSamplers ) const;
+
+    // Check to see if the samplers starting at index match the sampler descriptions.
+    bool IsSamplerTable( uint32_t index, const D3D12_SAMPLER_DESC* samplerDescs, uint32_t numSamplers ) const;
+
+    // Maps the hash of a table of sampler descriptions to the index of the
+    // first sampler. Tables with the same hash are disambiguated by comparing
+    // the sampler descriptions.
+    using SamplerTableMap = std::unordered_multimap<std::size_t, uint32_t>;
+
+    SamplerTableMap m_SamplerTables;
+    // The descriptions of the samplers that have been created in the heap.
+    std::vector<D3D12_SAMPLER_DESC> m_SamplerDescs;
+
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_d3d12DescriptorHeap;
+    CD3DX12_CPU_DESCRIPTOR_HANDLE m_BaseCPUDescriptor;
+    CD3DX12_GPU_DESCRIPTOR_HANDLE m_BaseGPUDescriptor;
+    uint32_t m_DescriptorHandleIncrementSize;
+    uint32_t m_NumSamplersInHeap;
+
+    mutable std::mutex m_SamplerMutex;
+};
\ No newline at end of file
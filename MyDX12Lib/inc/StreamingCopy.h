@@ -0,0 +1,33 @@
+#pragma once
+
+/**
+ *  @file StreamingCopy.h
+ *
+ *  @brief Copy kernels for writing into write-combined memory, such as the
+ *  mapped pages of an UploadBuffer.
+ *
+ *  The kernels use non-temporal (streaming) stores, so that the destination
+ *  is never read back and every cache line is written in full. The kernel is
+ *  selected at runtime based on the features of the CPU (AVX2 or SSE2).
+ *  Small copies and CPUs without these features use memcpy.
+ */
+
+#include <cstddef>
+
+enum class StreamingCopyKernel
+{
+    Memcpy,
+    SSE2,
+    AVX2,
+};
+
+/**
+ * Copy data to write-combined memory. The source and the destination may
+ * have any alignment. A store fence is issued after the copy.
+ */
+void StreamingCopy(void* dst, const void* src, size_t sizeInBytes);
+
+/**
+ * Get the kernel that is used by StreamingCopy on this CPU.
+ */
+StreamingCopyKernel GetStreamingCopyKernel();
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+/**
+ *  @file TLSFAllocator.h
+ *
+ *  @brief A two-level segregated fit (TLSF) free-list allocator.
+ *  The allocator manages a range of offsets [0, capacity) and hands out
+ *  contiguous blocks from that range. Allocating, freeing and coalescing
+ *  blocks run in constant time and do not allocate memory after the
+ *  allocator has been constructed.
+ *
+ *  The allocator only deals with offsets and sizes (it does not depend on
+ *  Direct3D), so it can be used by any allocator that sub-allocates a range,
+ *  for example the DescriptorAllocatorPage class.
+ *
+ *  TLSF allocation strategy based on:
+ *  http://www.gii.upv.es/tlsf/files/papers/ecrts04_tlsf.pdf
+ */
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+class TLSFAllocator
+{
+public:
+    // The offset of a block within the managed range.
+    using OffsetType = uint32_t;
+    // The size of a block.
+    using SizeType = uint32_t;
+
+    // Returned from Allocate if the request could not be satisfied.
+    static constexpr OffsetType InvalidOffset = std::numeric_limits<OffsetType>::max();
+
+    /**
+     * @param capacity The size of the range that is managed by the allocator.
+     */
+    explicit TLSFAllocator( SizeType capacity );
+
+    /**
+     * Get the size of the range that is managed by the allocator.
+     */
+    SizeType GetCapacity() const
+    {
+        return m_Capacity;
+    }
+
+    /**
+     * Get the total size of all the free blocks.
+     */
+    SizeType GetFreeSize() const
+    {
+        return m_FreeSize;
+    }
+
+    /**
+     * Check to see if there is a free block large enough to satisfy the request.
+     */
+    bool HasSpace( SizeType size ) const;
+
+    /**
+     * Get the size of the largest request that is guaranteed to succeed
+     * (0 if there are no free blocks). This is the lower bound of the size
+     * class of the largest free block, which is found in constant time from
+     * the bitmaps. Blocks smaller than 2^(SecondLevelLog2 + 1) are exact; the
+     * largest block can be up to 1/2^SecondLevelLog2 larger than the result.
+     */
+    SizeType GetLargestFreeBlock() const;
+
+    /**
+     * Count the free blocks by size. Bucket i of the histogram is incremented
+     * for each free block with a size in the range [2^i, 2^(i+1)). Larger
+     * blocks are counted in the last bucket.
+     */
+    void GetFreeBlockHistogram( uint32_t* histogram, uint32_t numBuckets ) const;
+
+    /**
+     * Allocate a block from the range.
+     * @return The offset of the block or InvalidOffset if the allocation
+     * can not be satisfied.
+     */
+    OffsetType Allocate( SizeType size );
+
+    /**
+     * Return a block back to the free list. The block is merged with
+     * its free neighbours.
+     * @param offset The offset that was returned from Allocate.
+     * @param size The size that was passed to Allocate.
+     */
+    void Free( OffsetType offset, SizeType size );
+
+private:
+    // The number of second level lists per first level list is 2^SecondLevelLog2.
+    static constexpr uint32_t SecondLevelLog2 = 4;
+    static constexpr uint32_t SecondLevelCount = 1u << SecondLevelLog2;
+    // Sizes smaller than SecondLevelCount are all stored in the first first level list.
+    static constexpr uint32_t FirstLevelCount = 32 - SecondLevelLog2 + 1;
+
+    // Block information is stored per offset. Only the entry for the first
+    // offset of a block is valid.
+    struct Block
+    {
+        // The size of the block.
+        SizeType Size;
+        // The offset of the block that comes before this block in the range.
+        OffsetType PrevPhysical;
+        // The links in the free list (only valid if the block is free).
+        OffsetType PrevFree;
+        OffsetType NextFree;
+        bool IsFree;
+    };
+
+    // Compute the first and second level indices of the list that stores blocks of this size.
+    static void Mapping( SizeType size, uint32_t& fl, uint32_t& sl );
+
+    // Find a free block that is large enough to satisfy the request.
+    OffsetType FindFreeBlock( SizeType size ) const;
+
+    // Add/remove a block to/from the free list it belongs to.
+    void InsertFreeBlock( OffsetType offset );
+    void RemoveFreeBlock( OffsetType offset );
+
+    std::vector<Block> m_Blocks;
+
+    // Each bit represents a first level list that contains at least one free block.
+    uint32_t m_FirstLevelBitmap;
+    // Each bit represents a second level list that contains at least one free block.
+    uint32_t m_SecondLevelBitmap[FirstLevelCount];
+    // The head of each of the free lists.
+    OffsetType m_FreeLists[FirstLevelCount][SecondLevelCount];
+
+    SizeType m_Capacity;
+    SizeType m_FreeSize;
+};
@@ -1,12 +1,19 @@
 ﻿#pragma once
 
 #include <Defines.h>
+#include <UploadBufferStats.h>
 
 #include <wrl.h>
 #include <d3d12.h>
 
+#include <atomic>
 #include <memory>
 #include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+class UploadRing;
 
 /**
  *  @file UploadBuffer.h
@@ -14,6 +21,31 @@
  *  @author Jeremiah van Oosten
  *
  *  @brief An UploadBuffer provides a convenient method to upload resources to the GPU.
+ *
+ *  Allocations that are larger than the page size are served from dedicated
+ *  large pages that are sized to the allocation. When the upload buffer is
+ *  reset, the large pages are kept per size class (a power of two multiple
+ *  of the page size) and are reused by later allocations in the same class.
+ *
+ *  If the upload buffer is created with an UploadRing (see
+ *  CommandQueue::GetUploadRing), new pages are taken from the blocks of the
+ *  ring. The blocks are returned to the ring when the upload buffer is reset.
+ *  Only if the ring has no free blocks does the upload buffer create its own pages.
+ *
+ *  A page or large page is released by the reset at which it has been idle
+ *  (had no allocations) for a number of consecutive resets (the page decay). The memory of the
+ *  pages of all upload buffers is counted against an optional process-wide
+ *  budget. While the budget is exceeded, every page that was not used since
+ *  the previous reset is released.
+ *
+ *  Allocate can be called from multiple threads at the same time (for example,
+ *  by worker threads that prepare the constants of the same frame). Space in
+ *  the current page is reserved with an atomic fetch-add of the page offset.
+ *  When the current page is full, the thread that requests the next page takes
+ *  it from a lock-free stack of available pages (or from the upload ring, or
+ *  creates it) and installs it with a compare-exchange. Large pages are
+ *  requested under a mutex. Reset and the other functions must not be called
+ *  while another thread is allocating.
  */
 class UploadBuffer
 {
@@ -27,41 +59,98 @@ public:
 
     /**
      * @param pageSize The size to use to allocate new pages in GPU memory.
+     * @param uploadRing The ring to take the pages from (optional). The block
+     * size of the ring must match the page size.
      */
-    explicit UploadBuffer(size_t pageSize = _2MB);
+    explicit UploadBuffer(size_t pageSize = _2MB, UploadRing* uploadRing = nullptr);
 
     virtual ~UploadBuffer();
 
+    // The default number of consecutive idle resets after which a page is released.
+    static const uint32_t DefaultPageDecay = 120;
+
     /**
-     * The maximum size of an allocation is the size of a single page.
+     * Set the number of consecutive idle resets after which a page or large
+     * page is released. A page that was idle for numResets resets is released
+     * by that reset. A page decay of 0 keeps all pages.
+     */
+    void SetPageDecay(uint32_t numResets) { m_PageDecay = numResets; }
+    uint32_t GetPageDecay() const { return m_PageDecay; }
+
+    /**
+     * Allocations that are larger than the page size get a dedicated page.
      */
     size_t GetPageSize() const { return m_PageSize;  }
 
+    /**
+     * The number of bytes of upload heap memory that is used by the pages
+     * (including the blocks of the upload ring that are in use).
+     */
+    size_t GetMemoryUsage() const { return (m_NumPages + m_NumRingPages) * m_PageSize + m_LargePageMemoryUsage; }
+
     /**
      * Allocate memory in an Upload heap.
-     * An allocation must not exceed the size of a page.
+     * An allocation that exceeds the size of a page is allocated from a
+     * dedicated large page.
      * Use a memcpy or similar method to copy the 
      * buffer data to CPU pointer in the Allocation structure returned from 
      * this function.
+     * This function is thread-safe.
      */
     Allocation Allocate(size_t sizeInBytes, size_t alignment);
 
     /**
      * Release all allocated pages. This should only be done when the command list
-     * is finished executing on the CommandQueue.
+     * is finished executing on the CommandQueue. The blocks of the upload ring
+     * are returned to the ring and pages that have decayed are released.
      */
     void Reset();
 
+    /**
+     * Get the statistics of the upload buffer.
+     */
+    UploadBufferStats GetStats() const;
+
+    /**
+     * Set the process-wide budget for the memory of the pages of all upload
+     * buffers (the blocks of the upload rings are not counted). A budget of 0
+     * disables the budget.
+     */
+    static void SetMemoryBudget(size_t budgetInBytes);
+    static size_t GetMemoryBudget();
+
+    /**
+     * Get the memory of the pages of all upload buffers.
+     */
+    static size_t GetTotalMemoryUsage();
+
+    /**
+     * Check to see if the pages of all upload buffers exceed the budget.
+     */
+    static bool IsOverMemoryBudget();
+
+    /**
+     * Get the statistics of the pages of all upload buffers. The memory of
+     * the upload rings is not known to the upload buffers and is left at 0.
+     */
+    static UploadMemoryStats GetGlobalStats();
+
 private:
     // A single page for the allocator.
     struct Page
     {
         Page(size_t sizeInBytes);
+        // A page in memory that is owned (and mapped) by the upload ring.
+        Page(void* cpuPtr, D3D12_GPU_VIRTUAL_ADDRESS gpuPtr, size_t sizeInBytes, uint32_t ringBlockIndex);
         ~Page();
 
         // Check to see if the page has room to satisfy the requested
         // allocation.
         bool HasSpace(size_t sizeInBytes, size_t alignment ) const;
+
+        // Reserve memory in the page with an atomic fetch-add of the offset.
+        // Returns false if the remaining space in the page is too small.
+        bool TryAllocate(size_t sizeInBytes, size_t alignment, Allocation& allocation);
         
         // Allocate memory from the page.
         // Throws std::bad_alloc if the the allocation size is larger
@@ -69,9 +158,22 @@ private:
         // remaining space in the page.
         Allocation Allocate(size_t sizeInBytes, size_t alignment);
 
-        // Reset the page for reuse.
+        // Reset the page for reuse. A page that had no allocations since the
+        // previous reset was idle.
         void Reset();
 
+        // The size of the page in bytes.
+        size_t GetPageSize() const { return m_PageSize; }
+
+        // The number of consecutive resets that the page was idle.
+        uint32_t GetNumIdleResets() const { return m_NumIdleResets; }
+
+        // The next page in the stack of available pages, the stack of new
+        // pages or the stack of ring pages.
+        Page* NextPage;
+        // The index of the block of the upload ring.
+        uint32_t RingBlockIndex;
+
     private:
 
         Microsoft::WRL::ComPtr<ID3D12Resource> m_d3d12Resource;
@@ -82,24 +184,107 @@ private:
 
         // Allocated page size.
         size_t m_PageSize;
-        // Current allocation offset in bytes.
-        size_t m_Offset;
+        // Current allocation offset in bytes. The offset can exceed the page
+        // size when concurrent allocations overflow the page.
+        std::atomic_size_t m_Offset;
+        uint32_t m_NumIdleResets;
     };
 
     // A pool of memory pages.
     using PagePool = std::deque< std::shared_ptr<Page> >;
 
-    // Request a page from the pool of available pages
-    // or create a new page if there are no available pages.
-    std::shared_ptr<Page> RequestPage();
+    // Request a page from the stack of available pages, or from the upload
+    // ring, or create a new page if there are no available pages.
+    Page* RequestPage();
+
+    // Take a page from the upload ring. Returns nullptr if there is no upload
+    // ring or if all of its blocks are in use.
+    Page* RequestRingPage();
+
+    // Replace the current page after it was found to be full. If another
+    // thread already replaced the page, its page is returned instead.
+    Page* RolloverPage(Page* fullPage);
+
+    // Take a page that was requested by a thread that lost the race to
+    // replace the current page. Returns nullptr if there are no spare pages.
+    Page* RequestSparePage();
+
+    // Lock-free stack operations. Pages are only popped from the stack of
+    // available pages and only pushed to the stacks of new and ring pages
+    // while allocating, so the stacks are not affected by the ABA problem.
+    // For this reason, a page that lost the race to become the current page
+    // is not pushed back to the stack of available pages but is kept in the
+    // spare pages.
+    static void PushPage(std::atomic<Page*>& stack, Page* page);
+    static Page* PopPage(std::atomic<Page*>& stack);
+
+    // Return the blocks that were taken since the last reset to the upload ring.
+    void FreeRingBlocks();
+
+    // Move the pages that were created since the last reset to the page pool.
+    void AdoptNewPages();
+
+    // Reset the pages of a pool and release the pages that have now been idle
+    // for maxIdleResets (or more) consecutive resets (none if maxIdleResets is 0).
+    // Returns the memory of the released pages.
+    size_t ResetPages(PagePool& pagePool, uint32_t maxIdleResets);
+
+    // Add to (or subtract from) the memory of the pages of all upload buffers.
+    static void AddTotalMemoryUsage(size_t sizeInBytes);
+    static void SubtractTotalMemoryUsage(size_t sizeInBytes);
+
+    // Request a large page with room for a single allocation from the
+    // available large pages of its size class, or create a new large page.
+    std::shared_ptr<Page> RequestLargePage(size_t sizeInBytes, size_t alignment);
+
+    // Get the size class of a large page or allocation. Size class i holds the
+    // sizes in the range (2^i * pageSize, 2^(i+1) * pageSize].
+    uint32_t GetLargePageSizeClass(size_t sizeInBytes) const;
 
     PagePool m_PagePool;
-    PagePool m_AvailablePages;
+    // The stack of available pages of the page pool.
+    std::atomic<Page*> m_AvailablePages;
+    // The stack of pages that were created since the last reset. The pages
+    // are moved to the page pool on reset.
+    std::atomic<Page*> m_NewPages;
+    std::atomic_uint32_t m_NumPages;
 
-    std::shared_ptr<Page> m_CurrentPage;
+    // Large pages for allocations that are larger than the page size.
+    PagePool m_LargePagePool;
+    std::map<uint32_t, PagePool> m_AvailableLargePages;
+    // The total size of the large pages.
+    std::atomic_size_t m_LargePageMemoryUsage;
+    std::mutex m_LargePageMutex;
+
+    // The ring that pages are taken from (optional).
+    UploadRing* m_UploadRing;
+    // The stack of pages of the upload ring that were taken since the last reset.
+    std::atomic<Page*> m_RingPages;
+    std::atomic_uint32_t m_NumRingPages;
+
+    std::atomic<Page*> m_CurrentPage;
+    // Pages that were requested by threads that lost the race to replace the
+    // current page. They are used by the next rollovers, so no page is skipped.
+    std::vector<Page*> m_SparePages;
+    std::atomic_uint32_t m_NumSparePages;
+    std::mutex m_SparePageMutex;
 
     // The size of each page of memory.
     size_t m_PageSize;
 
+    // The memory of the pages and large pages that were requested since the last reset.
+    std::atomic_size_t m_UsedMemory;
+    size_t m_HighWaterMark;
+
+    uint32_t m_PageDecay;
+    uint64_t m_NumReleasedPages;
+
+    // The memory of the pages of all upload buffers.
+    static std::atomic_size_t ms_TotalMemoryUsage;
+    static std::atomic_size_t ms_PeakMemoryUsage;
+    static std::atomic_size_t ms_MemoryBudget;
+    static std::atomic_uint32_t ms_NumUploadBuffers;
+    static std::atomic_uint64_t ms_NumReleasedPages;
+
 };
 
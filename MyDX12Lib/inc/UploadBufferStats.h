@@ -0,0 +1,67 @@
+#pragma once
+
+/**
+ *  @file UploadBufferStats.h
+ *
+ *  @brief Statistics of the upload heap memory that is used by an UploadBuffer
+ *  and by all of the upload buffers of the process. The statistics can be
+ *  written as JSON so that they can be shown on a dashboard.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct UploadBufferStats
+{
+    size_t PageSize;
+
+    // The pages that are owned by the upload buffer.
+    uint32_t NumPages;
+    // The blocks of the upload ring that were taken since the last reset.
+    uint32_t NumRingBlocks;
+    uint32_t NumLargePages;
+
+    // The upload heap memory of the pages, ring blocks and large pages.
+    size_t MemoryUsage;
+    // The memory of the pages and large pages that were used since the last reset.
+    size_t UsedMemory;
+    // The largest amount of memory that was used between two resets.
+    size_t HighWaterMark;
+
+    // The number of consecutive idle resets after which a page or large page
+    // is released (0 if pages are never released).
+    uint32_t PageDecay;
+    // The total number of pages and large pages that were released.
+    uint64_t NumReleasedPages;
+
+    /**
+     * Write the statistics as a JSON object.
+     */
+    std::string ToJSON() const;
+};
+
+struct UploadMemoryStats
+{
+    // The number of upload buffers.
+    uint32_t NumUploadBuffers;
+
+    // The memory of the pages and large pages of all upload buffers (the
+    // memory that is counted against the budget).
+    size_t MemoryUsage;
+    // The largest value of MemoryUsage.
+    size_t PeakMemoryUsage;
+    // The upload memory budget (0 if there is no budget).
+    size_t MemoryBudget;
+
+    // The memory of the upload rings of the command queues.
+    size_t UploadRingMemoryUsage;
+
+    // The total number of pages and large pages that were released.
+    uint64_t NumReleasedPages;
+
+    /**
+     * Write the statistics as a JSON object.
+     */
+    std::string ToJSON() const;
+};
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+/**
+ *  @file UploadRing.h
+ *
+ *  @brief A persistently mapped ring of upload heap memory that is owned by a
+ *  CommandQueue and is shared by the UploadBuffers of all command lists that
+ *  are executed on that queue.
+ *
+ *  The ring is a single buffer in an upload heap that is divided into blocks
+ *  of the same size as the pages of an UploadBuffer. An UploadBuffer takes a
+ *  block from the ring when it needs a new page and returns its blocks when
+ *  the command list is reset. Returned blocks are tagged with the next fence
+ *  value of the command queue and are reused (in the order that they were
+ *  returned) once the command queue has completed that value.
+ *
+ *  The size of the ring is set by the number of frames in flight, so the
+ *  upload memory does not grow with the number of command lists. If every
+ *  block is in use, the UploadBuffer falls back to its own pages.
+ */
+
+#include <Defines.h>
+
+#include <d3d12.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <mutex>
+#include <queue>
+
+class CommandQueue;
+
+class UploadRing
+{
+public:
+    /**
+     * A block of the ring.
+     */
+    struct Block
+    {
+        // The index of the block (used to free the block).
+        uint32_t Index;
+        void* CPU;
+        D3D12_GPU_VIRTUAL_ADDRESS GPU;
+    };
+
+    /**
+     * @param commandQueue The command queue whose fence values are used to
+     * reclaim the blocks.
+     * @param sizeInBytes The size of the ring (rounded down to a multiple of
+     * the block size).
+     * @param blockSize The size of each block.
+     */
+    UploadRing(CommandQueue& commandQueue, Microsoft::WRL::ComPtr<ID3D12Device2> device, size_t sizeInBytes, size_t blockSize = _2MB);
+
+    virtual ~UploadRing();
+
+    size_t GetBlockSize() const { return m_BlockSize; }
+
+    /**
+     * The size of the ring in bytes.
+     */
+    size_t GetSize() const { return m_NumBlocks * m_BlockSize; }
+
+    /**
+     * The upload heap memory of the ring (0 until the first block is allocated).
+     */
+    size_t GetMemoryUsage() const;
+
+    /**
+     * Allocate a block of the ring. The upload heap is created on the first
+     * allocation. Stale blocks are reused once the completed fence value that
+     * the command queue last read from its fence has reached their fence value.
+     * @return false if all of the blocks are still in use.
+     */
+    bool AllocateBlock(Block& block);
+
+    /**
+     * Return a block to the ring. The block is not reused until the command
+     * queue has completed its next fence value.
+     */
+    void FreeBlock(uint32_t blockIndex);
+
+    /**
+     * Return the stale blocks back to the ring.
+     * @param completedFenceValue The completed fence value of the command queue.
+     */
+    void ReleaseStaleBlocks(uint64_t completedFenceValue);
+
+private:
+    // Create and map the buffer of the ring.
+    void CreateResource();
+
+    // Move the stale blocks whose fence value has completed to the available
+    // blocks. The block mutex must be held.
+    void MoveCompletedBlocks(uint64_t completedFenceValue);
+
+    struct StaleBlockInfo
+    {
+        // The index of the block.
+        uint32_t BlockIndex;
+        // The fence value that must be completed before the block can be reused.
+        uint64_t FenceValue;
+    };
+
+    using BlockQueue = std::queue<uint32_t>;
+    using StaleBlockQueue = std::queue<StaleBlockInfo>;
+
+    CommandQueue& m_CommandQueue;
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_d3d12Device;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_d3d12Resource;
+    // Base pointer.
+    uint8_t* m_CPUPtr;
+    D3D12_GPU_VIRTUAL_ADDRESS m_GPUPtr;
+
+    size_t m_BlockSize;
+    uint32_t m_NumBlocks;
+
+    // The blocks that are available, in the order that they should be reused.
+    BlockQueue m_AvailableBlocks;
+    StaleBlockQueue m_StaleBlocks;
+
+    mutable std::mutex m_BlockMutex;
+};
\ No newline at end of file
@@ -4,6 +4,13 @@
 
 #include <Game.h>
 #include <CommandQueue.h>
+#include <BindlessDescriptorHeap.h>
+#include <DescriptorAllocator.h>
+#include <DescriptorRing.h>
+#include <LinearDescriptorAllocator.h>
+#include <SamplerHeap.h>
+#include <UploadBuffer.h>
+#include <UploadRing.h>
 #include <Window.h>
 
 constexpr wchar_t WINDOW_CLASS_NAME[] = L"DX12RenderWindowClass";
@@ -30,6 +37,7 @@ struct MakeWindow : public Window
 
 Application::Application(HINSTANCE hInst)
     : m_hInstance(hInst)
+    , m_DescriptorCompactionBudget(0)
     , m_TearingSupported(false)
 {
     // Windows 10 Creators update adds Per Monitor V2 DPI awareness context.
@@ -80,7 +88,33 @@ Application::Application(HINSTANCE hInst)
 void Application::Create(HINSTANCE hInst)
 {
     if (!gs_pSingelton)
+    {
         gs_pSingelton = new Application(hInst);
+
+        // The descriptor allocators and heaps query the device through the
+        // application instance, so they can only be created once it is set.
+        gs_pSingelton->CreateDescriptorAllocators();
+    }
+}
+
+void Application::CreateDescriptorAllocators()
+{
+    if (!m_d3d12Device)
+        return;
+
+    for (int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i)
+    {
+        m_DescriptorAllocators[i] = std::make_unique<DescriptorAllocator>(static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(i));
+        m_LinearDescriptorAllocators[i] = std::make_unique<LinearDescriptorAllocator>(static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(i));
+    }
+
+    // RTV and DSV descriptor heaps can't be shader visible and samplers are
+    // bound from the SamplerHeap, so only CBV, SRV, and UAV descriptors need a ring.
+    // The first descriptors of the ring are the bindless descriptors.
+    m_DescriptorRings[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV] = std::make_unique<DescriptorRing>(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 32768, 65536);
+
+    m_BindlessDescriptorHeap = std::make_unique<BindlessDescriptorHeap>(*m_DescriptorRings[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]);
+    m_SamplerHeap = std::make_unique<SamplerHeap>();
 }
 
 Application& Application::Get()
@@ -352,6 +386,176 @@ UINT Application::GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE ty
     return m_d3d12Device->GetDescriptorHandleIncrementSize(type);
 }
 
+DescriptorAllocation Application::AllocateDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors)
+{
+    return m_DescriptorAllocators[type]->Allocate(numDescriptors);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE Application::AllocateTransientDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors)
+{
+    return m_LinearDescriptorAllocators[type]->Allocate(numDescriptors);
+}
+
+BindlessDescriptorHeap& Application::GetBindlessDescriptorHeap()
+{
+    return *m_BindlessDescriptorHeap;
+}
+
+SamplerHeap& Application::GetSamplerHeap()
+{
+    return *m_SamplerHeap;
+}
+
+DescriptorRing& Application::GetDescriptorRing(D3D12_DESCRIPTOR_HEAP_TYPE type)
+{
+    assert(m_DescriptorRings[type] && "Only shader visible descriptor heap types have a descriptor ring.");
+
+    return *m_DescriptorRings[type];
+}
+
+FenceTag Application::GetNextFenceTag() const
+{
+    FenceTag fenceTag;
+    fenceTag.FenceValues[FenceTag::Direct] = m_DirectCommandQueue->GetNextFenceValue();
+    fenceTag.FenceValues[FenceTag::Compute] = m_ComputeCommandQueue->GetNextFenceValue();
+    fenceTag.FenceValues[FenceTag::Copy] = m_CopyCommandQueue->GetNextFenceValue();
+
+    return fenceTag;
+}
+
+bool Application::HasOpenCommandLists() const
+{
+    return m_DirectCommandQueue->GetNumOpenCommandLists() > 0 ||
+        m_ComputeCommandQueue->GetNumOpenCommandLists() > 0 ||
+        m_CopyCommandQueue->GetNumOpenCommandLists() > 0;
+}
+
+void Application::ReleaseStaleDescriptors()
+{
+    FenceTag completedFenceValues;
+    completedFenceValues.FenceValues[FenceTag::Direct] = m_DirectCommandQueue->GetCompletedFenceValue();
+    completedFenceValues.FenceValues[FenceTag::Compute] = m_ComputeCommandQueue->GetCompletedFenceValue();
+    completedFenceValues.FenceValues[FenceTag::Copy] = m_CopyCommandQueue->GetCompletedFenceValue();
+
+    for (auto& descriptorAllocator : m_DescriptorAllocators)
+    {
+        // The command queues are created before the descriptor allocators.
+        if (descriptorAllocator)
+        {
+            descriptorAllocator->ReleaseStaleDescriptors(completedFenceValues);
+        }
+    }
+
+    for (auto& linearDescriptorAllocator : m_LinearDescriptorAllocators)
+    {
+        if (linearDescriptorAllocator)
+        {
+            linearDescriptorAllocator->ReleaseStaleDescriptors(completedFenceValues);
+        }
+    }
+
+    if (m_BindlessDescriptorHeap)
+    {
+        m_BindlessDescriptorHeap->ReleaseStaleDescriptors(completedFenceValues);
+    }
+
+    for (auto& descriptorRing : m_DescriptorRings)
+    {
+        if (descriptorRing)
+        {
+            descriptorRing->ReleaseStaleDescriptors(completedFenceValues);
+        }
+    }
+}
+
+void Application::EndFrame()
+{
+    // Transient descriptors are only used by the command lists of the frame
+    // that they were allocated in. These command lists must have been executed
+    // before the transient descriptors are retired (see GetNextFenceTag).
+    assert(!HasOpenCommandLists() && "Transient descriptors are retired while a command list is being recorded.");
+
+    for (auto& linearDescriptorAllocator : m_LinearDescriptorAllocators)
+    {
+        if (linearDescriptorAllocator)
+        {
+            linearDescriptorAllocator->RetireCurrentPage();
+        }
+    }
+
+    // The bindless indices of resources that were destroyed while a command
+    // list was being recorded.
+    if (m_BindlessDescriptorHeap)
+    {
+        m_BindlessDescriptorHeap->RetireDeferredDescriptors(GetNextFenceTag());
+    }
+
+    for (auto& descriptorAllocator : m_DescriptorAllocators)
+    {
+        if (descriptorAllocator)
+        {
+            descriptorAllocator->TrimIdlePages();
+        }
+    }
+
+    CompactDescriptorAllocators();
+}
+
+void Application::SetDescriptorCompactionBudget(uint32_t maxDescriptorsPerFrame)
+{
+    m_DescriptorCompactionBudget = maxDescriptorsPerFrame;
+}
+
+void Application::CompactDescriptorAllocators()
+{
+    uint32_t budget = m_DescriptorCompactionBudget;
+    if (budget == 0)
+        return;
+
+    FenceTag fenceTag = GetNextFenceTag();
+    for (auto& descriptorAllocator : m_DescriptorAllocators)
+    {
+        if (!descriptorAllocator)
+            continue;
+
+        uint32_t numMovedDescriptors = descriptorAllocator->Compact(budget, fenceTag);
+        budget -= std::min(budget, numMovedDescriptors);
+        if (budget == 0)
+            break;
+    }
+}
+
+std::string Application::GetDescriptorAllocatorStatsJSON()
+{
+    std::string json = "[";
+    for (auto& descriptorAllocator : m_DescriptorAllocators)
+    {
+        if (!descriptorAllocator)
+            continue;
+
+        json += (json.size() > 1) ? ",\n" : "\n";
+        json += descriptorAllocator->GetStats().ToJSON();
+    }
+    json += "\n]";
+
+    return json;
+}
+
+std::string Application::GetUploadMemoryStatsJSON() const
+{
+    UploadMemoryStats stats = UploadBuffer::GetGlobalStats();
+
+    for (auto& commandQueue : { m_DirectCommandQueue, m_ComputeCommandQueue, m_CopyCommandQueue })
+    {
+        if (commandQueue && commandQueue->GetUploadRing())
+        {
+            stats.UploadRingMemoryUsage += commandQueue->GetUploadRing()->GetMemoryUsage();
+        }
+    }
+
+    return stats.ToJSON();
+}
+
 // Remove a window from our window lists.
 static void RemoveWindow(HWND hWnd)
 {
@@ -413,6 +617,8 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM l
                     RenderEventArgs renderEventArgs(0.0f, 0.0f, Application::ms_FrameCount);
                     // Delta time will be filled in by the Window.
                     pWindow->OnRender(renderEventArgs);
+
+                    Application::Get().EndFrame();
                 }
                 break;
             case WM_SYSKEYDOWN:
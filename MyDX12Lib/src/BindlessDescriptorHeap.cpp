@@ -0,0 +1,105 @@
+#include <DX12LibPCH.h>
+
+#include <BindlessDescriptorHeap.h>
+
+#include <Application.h>
+#include <DescriptorRing.h>
+
+BindlessDescriptorHeap::BindlessDescriptorHeap( DescriptorRing& descriptorRing )
+    : m_FreeList( descriptorRing.GetNumReservedDescriptors() )
+    , m_DescriptorRing( descriptorRing )
+    , m_NumDescriptorsInHeap( descriptorRing.GetNumReservedDescriptors() )
+{
+    assert( descriptorRing.GetHeapType() == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE BindlessDescriptorHeap::GetCPUDescriptorHandle( uint32_t index ) const
+{
+    return m_DescriptorRing.GetReservedCPUDescriptorHandle( index );
+}
+
+uint32_t BindlessDescriptorHeap::Allocate( uint32_t numDescriptors )
+{
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    uint32_t index = m_FreeList.Allocate( numDescriptors );
+    if ( index == InvalidIndex )
+    {
+        // The size of the bindless heap is fixed since the indices must stay
+        // valid. Consider increasing the number of descriptors in the heap.
+        throw std::bad_alloc();
+    }
+
+    return index;
+}
+
+void BindlessDescriptorHeap::Free( uint32_t index, uint32_t numDescriptors, const FenceTag& fenceTag )
+{
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    // Don't reuse the indices until the GPU is done with them.
+    m_StaleDescriptors.emplace( index, numDescriptors, fenceTag );
+}
+
+void BindlessDescriptorHeap::FreeDeferred( uint32_t index, uint32_t numDescriptors )
+{
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    m_DeferredDescriptors.emplace_back( index, numDescriptors );
+}
+
+void BindlessDescriptorHeap::RetireDeferredDescriptors( const FenceTag& fenceTag )
+{
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    for ( auto& deferredDescriptor : m_DeferredDescriptors )
+    {
+        m_StaleDescriptors.emplace( deferredDescriptor.first, deferredDescriptor.second, fenceTag );
+    }
+
+    m_DeferredDescriptors.clear();
+}
+
+void BindlessDescriptorHeap::CopyDescriptor( uint32_t index, D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor )
+{
+    auto device = Application::Get().GetDevice();
+
+    device->CopyDescriptorsSimple( 1, GetCPUDescriptorHandle( index ), srcDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
+    m_DescriptorRing.CommitReservedDescriptors( index, 1 );
+}
+
+uint32_t BindlessDescriptorHeap::CreateShaderResourceView( ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc )
+{
+    auto device = Application::Get().GetDevice();
+
+    uint32_t index = Allocate();
+    device->CreateShaderResourceView( resource, srvDesc, GetCPUDescriptorHandle( index ) );
+    m_DescriptorRing.CommitReservedDescriptors( index, 1 );
+
+    return index;
+}
+
+uint32_t BindlessDescriptorHeap::CreateUnorderedAccessView( ID3D12Resource* resource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* uavDesc )
+{
+    auto device = Application::Get().GetDevice();
+
+    uint32_t index = Allocate();
+    device->CreateUnorderedAccessView( resource, nullptr, uavDesc, GetCPUDescriptorHandle( index ) );
+    m_DescriptorRing.CommitReservedDescriptors( index, 1 );
+
+    return index;
+}
+
+void BindlessDescriptorHeap::ReleaseStaleDescriptors( const FenceTag& completedFenceValues )
+{
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    while ( !m_StaleDescriptors.empty() && m_StaleDescriptors.front().Fence.IsComplete( completedFenceValues ) )
+    {
+        auto& staleDescriptor = m_StaleDescriptors.front();
+
+        m_FreeList.Free( staleDescriptor.Index, staleDescriptor.Size );
+
+        m_StaleDescriptors.pop();
+    }
+}
\ No newline at end of file
@@ -12,11 +12,14 @@
 #include <PanoToCubemapPSO.h>
 #include <RenderTarget.h>
 #include <Resource.h>
+#include <SamplerHeap.h>
 #include <ResourceStateTracker.h>
 #include <RootSignature.h>
+#include <StreamingCopy.h>
 #include <StructuredBuffer.h>
 #include <Texture.h>
 #include <UploadBuffer.h>
+#include <UploadRing.h>
 #include <VertexBuffer.h>
 
 std::map<std::wstring, ID3D12Resource* > CommandList::ms_TextureCache;
@@ -32,13 +35,11 @@ CommandList::CommandList( D3D12_COMMAND_LIST_TYPE type )
     ThrowIfFailed( device->CreateCommandList( 0, m_d3d12CommandListType, m_d3d12CommandAllocator.Get(),
                                               nullptr, IID_PPV_ARGS( &m_d3d12CommandList ) ) );
 
-    m_UploadBuffer = std::make_unique<UploadBuffer>();
-
-    m_ResourceStateTracker = std::make_unique<ResourceStateTracker>();
-
+    // The upload buffer, the resource state tracker and the dynamic descriptor
+    // heaps are created the first time they are needed (command lists that
+    // only copy or clear don't need all of them).
     for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
     {
-        m_DynamicDescriptorHeap[i] = std::make_unique<DynamicDescriptorHeap>( static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>( i ) );
         m_DescriptorHeaps[i] = nullptr;
     }
 }
@@ -53,7 +54,7 @@ void CommandList::TransitionBarrier( const Resource& resource, D3D12_RESOURCE_ST
     {
         // The "before" state is not important. It will be resolved by the resource state tracker.
         auto barrier = CD3DX12_RESOURCE_BARRIER::Transition( d3d12Resource.Get(), D3D12_RESOURCE_STATE_COMMON, stateAfter, subResource );
-        m_ResourceStateTracker->ResourceBarrier( barrier );
+        GetResourceStateTracker().ResourceBarrier( barrier );
     }
 
     if ( flushBarriers )
@@ -67,7 +68,7 @@ void CommandList::UAVBarrier( const Resource& resource, bool flushBarriers )
     auto d3d12Resource = resource.GetD3D12Resource();
     auto barrier = CD3DX12_RESOURCE_BARRIER::UAV( d3d12Resource.Get() );
 
-    m_ResourceStateTracker->ResourceBarrier( barrier );
+    GetResourceStateTracker().ResourceBarrier( barrier );
 
     if ( flushBarriers )
     {
@@ -81,7 +82,7 @@ void CommandList::AliasingBarrier(const Resource& beforeResource, const Resource
     auto d3d12AfterResource = afterResource.GetD3D12Resource();
     auto barrier = CD3DX12_RESOURCE_BARRIER::Aliasing(d3d12BeforeResource.Get(), d3d12AfterResource.Get() );
 
-    m_ResourceStateTracker->ResourceBarrier(barrier);
+    GetResourceStateTracker().ResourceBarrier(barrier);
 
     if (flushBarriers)
     {
@@ -91,7 +92,10 @@ void CommandList::AliasingBarrier(const Resource& beforeResource, const Resource
 
 void CommandList::FlushResourceBarriers()
 {
-    m_ResourceStateTracker->FlushResourceBarriers( *this );
+    if ( m_ResourceStateTracker )
+    {
+        m_ResourceStateTracker->FlushResourceBarriers( *this );
+    }
 }
 
 void CommandList::CopyResource( Resource& dstRes, const Resource& srcRes )
@@ -162,7 +166,7 @@ void CommandList::CopyBuffer( Buffer& buffer, size_t numElements, size_t element
             subresourceData.RowPitch = bufferSize;
             subresourceData.SlicePitch = subresourceData.RowPitch;
 
-            m_ResourceStateTracker->TransitionResource(d3d12Resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
+            GetResourceStateTracker().TransitionResource(d3d12Resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
             FlushResourceBarriers();
 
             UpdateSubresources( m_d3d12CommandList.Get(), d3d12Resource.Get(),
@@ -363,12 +367,15 @@ void CommandList::GenerateMips_UAV( Texture& texture )
     auto resource = texture.GetD3D12Resource();
     auto resourceDesc = resource->GetDesc();
 
-    auto stagingResource = resource;
-    Texture stagingTexture( stagingResource );
     // If the passed-in resource does not allow for UAV access
     // then create a staging resource that is used to generate
-    // the mipmap chain.
-    if ( ( resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS ) == 0 )
+    // the mipmap chain. Otherwise the views are created on the texture itself
+    // so they are cached with the texture and reused the next time.
+    bool useStagingTexture = ( resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS ) == 0;
+
+    ComPtr<ID3D12Resource> stagingResource;
+    Texture stagingTexture;
+    if ( useStagingTexture )
     {
         auto stagingDesc = resourceDesc;
         stagingDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
@@ -385,6 +392,8 @@ void CommandList::GenerateMips_UAV( Texture& texture )
 
         ResourceStateTracker::AddGlobalResourceState( stagingResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST );
 
+        // The views of the staging texture are only used for this pass.
+        stagingTexture.SetTransient( true );
         stagingTexture.SetD3D12Resource( stagingResource );
         stagingTexture.CreateViews();
         stagingTexture.SetName(L"Generate Mips UAV Staging Texture");
@@ -392,6 +401,8 @@ void CommandList::GenerateMips_UAV( Texture& texture )
         CopyResource( stagingTexture, texture );
     }
 
+    Texture& mipTexture = useStagingTexture ? stagingTexture : texture;
+
     m_d3d12CommandList->SetPipelineState( m_GenerateMipsPSO->GetPipelineState().Get() );
     SetComputeRootSignature( m_GenerateMipsPSO->GetRootSignature() );
 
@@ -440,7 +451,7 @@ void CommandList::GenerateMips_UAV( Texture& texture )
 
         SetCompute32BitConstants( GenerateMips::GenerateMipsCB, generateMipsCB );
 
-        SetShaderResourceView( GenerateMips::SrcMip, 0, stagingTexture, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, srcMip, 1 );
+        SetShaderResourceView( GenerateMips::SrcMip, 0, mipTexture, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, srcMip, 1 );
         for ( uint32_t mip = 0; mip < mipCount; ++mip )
         {
             D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
@@ -448,23 +459,23 @@ void CommandList::GenerateMips_UAV( Texture& texture )
             uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
             uavDesc.Texture2D.MipSlice = srcMip + mip + 1;
 
-            SetUnorderedAccessView(GenerateMips::OutMip, mip, stagingTexture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, srcMip + mip + 1, 1, &uavDesc );
+            SetUnorderedAccessView(GenerateMips::OutMip, mip, mipTexture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, srcMip + mip + 1, 1, &uavDesc );
         }
         // Pad any unused mip levels with a default UAV. Doing this keeps the DX12 runtime happy.
         if ( mipCount < 4 )
         {
-            m_DynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->StageDescriptors( GenerateMips::OutMip, mipCount, 4 - mipCount, m_GenerateMipsPSO->GetDefaultUAV() );
+            GetDynamicDescriptorHeap( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV ).StageDescriptors( GenerateMips::OutMip, mipCount, 4 - mipCount, m_GenerateMipsPSO->GetDefaultUAV() );
         }
         
         Dispatch( Math::DivideByMultiple(dstWidth, 8), Math::DivideByMultiple(dstHeight, 8) );
 
-        UAVBarrier( stagingTexture );
+        UAVBarrier( mipTexture );
 
         srcMip += mipCount;
     }
 
     // Copy back to the original texture.
-    if ( stagingResource != resource )
+    if ( useStagingTexture )
     {
         CopyResource( texture, stagingTexture );
     }
@@ -510,6 +521,7 @@ void CommandList::GenerateMips_BGR( Texture& texture )
     ResourceStateTracker::AddGlobalResourceState(resourceCopy.Get(), D3D12_RESOURCE_STATE_COMMON );
 
     Texture copyTexture(resourceCopy);
+    copyTexture.SetTransient(true);
 
     // Create an alias for which to perform the copy operation.
     auto aliasDesc = resourceDesc;
@@ -531,6 +543,7 @@ void CommandList::GenerateMips_BGR( Texture& texture )
 
     // Copy the original texture to the aliased texture.
     Texture aliasTexture(aliasCopy);
+    aliasTexture.SetTransient(true);
     AliasingBarrier(Texture(), aliasTexture); // There is no "before" texture. 
                                               // Default constructed Texture is equivalent to a "null" texture.
     CopyResource(aliasTexture, texture);
@@ -593,6 +606,7 @@ void CommandList::GenerateMips_sRGB( Texture& texture )
     ResourceStateTracker::AddGlobalResourceState(resourceCopy.Get(), D3D12_RESOURCE_STATE_COMMON);
 
     Texture copyTexture(resourceCopy);
+    copyTexture.SetTransient(true);
 
     // Create an alias for which to perform the copy operation.
     auto aliasDesc = resourceDesc;
@@ -611,6 +625,7 @@ void CommandList::GenerateMips_sRGB( Texture& texture )
 
     // Copy the original texture to the aliased texture.
     Texture aliasTexture(aliasCopy);
+    aliasTexture.SetTransient(true);
     AliasingBarrier(Texture(), aliasTexture); // There is no "before" texture. 
                                               // Default constructed Texture is equivalent to a "null" texture.
     CopyResource(aliasTexture, texture);
@@ -655,12 +670,15 @@ void CommandList::PanoToCubemap(Texture& cubemapTexture, const Texture& panoText
 
     CD3DX12_RESOURCE_DESC cubemapDesc(cubemapResource->GetDesc());
 
-    auto stagingResource = cubemapResource;
-    Texture stagingTexture(stagingResource);
     // If the passed-in resource does not allow for UAV access
     // then create a staging resource that is used to generate
-    // the cubemap.
-    if ((cubemapDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS) == 0)
+    // the cubemap. Otherwise the views are created on the cubemap itself
+    // so they are cached with the cubemap.
+    bool useStagingTexture = (cubemapDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS) == 0;
+
+    ComPtr<ID3D12Resource> stagingResource;
+    Texture stagingTexture;
+    if (useStagingTexture)
     {
         auto stagingDesc = cubemapDesc;
         stagingDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
@@ -677,6 +695,8 @@ void CommandList::PanoToCubemap(Texture& cubemapTexture, const Texture& panoText
 
         ResourceStateTracker::AddGlobalResourceState(stagingResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST);
 
+        // The views of the staging texture are only used for this pass.
+        stagingTexture.SetTransient(true);
         stagingTexture.SetD3D12Resource(stagingResource);
         stagingTexture.CreateViews();
         stagingTexture.SetName(L"Pano to Cubemap Staging Texture");
@@ -684,7 +704,9 @@ void CommandList::PanoToCubemap(Texture& cubemapTexture, const Texture& panoText
         CopyResource(stagingTexture, cubemapTexture );
     }
 
-    TransitionBarrier(stagingTexture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    Texture& dstTexture = useStagingTexture ? stagingTexture : cubemapTexture;
+
+    TransitionBarrier(dstTexture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 
     m_d3d12CommandList->SetPipelineState(m_PanoToCubemapPSO->GetPipelineState().Get());
     SetComputeRootSignature(m_PanoToCubemapPSO->GetRootSignature());
@@ -713,13 +735,13 @@ void CommandList::PanoToCubemap(Texture& cubemapTexture, const Texture& panoText
         for ( uint32_t mip = 0; mip < numMips; ++mip )
         {
             uavDesc.Texture2DArray.MipSlice = mipSlice + mip;
-            SetUnorderedAccessView(PanoToCubemapRS::DstMips, mip, stagingTexture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, 0, 0, &uavDesc);
+            SetUnorderedAccessView(PanoToCubemapRS::DstMips, mip, dstTexture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, 0, 0, &uavDesc);
         }
 
         if (numMips < 5)
         {
             // Pad unused mips. This keeps DX12 runtime happy.
-            m_DynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->StageDescriptors(PanoToCubemapRS::DstMips, panoToCubemapCB.NumMips, 5 - numMips, m_PanoToCubemapPSO->GetDefaultUAV());
+            GetDynamicDescriptorHeap( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV ).StageDescriptors(PanoToCubemapRS::DstMips, panoToCubemapCB.NumMips, 5 - numMips, m_PanoToCubemapPSO->GetDefaultUAV());
         }
 
         Dispatch(Math::DivideByMultiple(panoToCubemapCB.CubemapSize, 16), Math::DivideByMultiple(panoToCubemapCB.CubemapSize, 16), 6 );
@@ -727,7 +749,7 @@ void CommandList::PanoToCubemap(Texture& cubemapTexture, const Texture& panoText
         mipSlice += numMips;
     }
 
-    if (stagingResource != cubemapResource)
+    if (useStagingTexture)
     {
         CopyResource(cubemapTexture, stagingTexture);
     }
@@ -782,12 +804,24 @@ void CommandList::CopyTextureSubresource( Texture& texture, uint32_t firstSubres
 void CommandList::SetGraphicsDynamicConstantBuffer( uint32_t rootParameterIndex, size_t sizeInBytes, const void* bufferData )
 {
     // Constant buffers must be 256-byte aligned.
-    auto heapAllococation = m_UploadBuffer->Allocate( sizeInBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT );
-    memcpy( heapAllococation.CPU, bufferData, sizeInBytes );
+    auto heapAllococation = GetUploadBuffer().Allocate( sizeInBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT );
+    StreamingCopy( heapAllococation.CPU, bufferData, sizeInBytes );
 
     m_d3d12CommandList->SetGraphicsRootConstantBufferView( rootParameterIndex, heapAllococation.GPU );
 }
 
+void* CommandList::AllocateGraphicsConstants( uint32_t rootParameterIndex, size_t sizeInBytes )
+{
+    // Constant buffers must be 256-byte aligned.
+    auto heapAllocation = GetUploadBuffer().Allocate( sizeInBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT );
+
+    // The GPU only reads the constants when the command list is executed, so
+    // the root CBV can be bound before the constants are written.
+    m_d3d12CommandList->SetGraphicsRootConstantBufferView( rootParameterIndex, heapAllocation.GPU );
+
+    return heapAllocation.CPU;
+}
+
 void CommandList::SetGraphics32BitConstants( uint32_t rootParameterIndex, uint32_t numConstants, const void* constants )
 {
     m_d3d12CommandList->SetGraphicsRoot32BitConstants( rootParameterIndex, numConstants, constants, 0 );
@@ -813,8 +847,8 @@ void CommandList::SetDynamicVertexBuffer( uint32_t slot, size_t numVertices, siz
 {
     size_t bufferSize = numVertices * vertexSize;
 
-    auto heapAllocation = m_UploadBuffer->Allocate( bufferSize, vertexSize );
-    memcpy( heapAllocation.CPU, vertexBufferData, bufferSize );
+    auto heapAllocation = GetUploadBuffer().Allocate( bufferSize, vertexSize );
+    StreamingCopy( heapAllocation.CPU, vertexBufferData, bufferSize );
 
     D3D12_VERTEX_BUFFER_VIEW vertexBufferView = {};
     vertexBufferView.BufferLocation = heapAllocation.GPU;
@@ -840,8 +874,8 @@ void CommandList::SetDynamicIndexBuffer( size_t numIndicies, DXGI_FORMAT indexFo
     size_t indexSizeInBytes = indexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4;
     size_t bufferSize = numIndicies * indexSizeInBytes;
 
-    auto heapAllocation = m_UploadBuffer->Allocate( bufferSize, indexSizeInBytes );
-    memcpy( heapAllocation.CPU, indexBufferData, bufferSize );
+    auto heapAllocation = GetUploadBuffer().Allocate( bufferSize, indexSizeInBytes );
+    StreamingCopy( heapAllocation.CPU, indexBufferData, bufferSize );
 
     D3D12_INDEX_BUFFER_VIEW indexBufferView = {};
     indexBufferView.BufferLocation = heapAllocation.GPU;
@@ -855,9 +889,9 @@ void CommandList::SetGraphicsDynamicStructuredBuffer( uint32_t slot, size_t numE
 {
     size_t bufferSize = numElements * elementSize;
 
-    auto heapAllocation = m_UploadBuffer->Allocate( bufferSize, elementSize );
+    auto heapAllocation = GetUploadBuffer().Allocate( bufferSize, elementSize );
 
-    memcpy( heapAllocation.CPU, bufferData, bufferSize );
+    StreamingCopy( heapAllocation.CPU, bufferData, bufferSize );
 
     m_d3d12CommandList->SetGraphicsRootShaderResourceView( slot, heapAllocation.GPU );
 }
@@ -899,10 +933,7 @@ void CommandList::SetGraphicsRootSignature( const RootSignature& rootSignature )
     {
         m_RootSignature = d3d12RootSignature;
 
-        for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
-        {
-            m_DynamicDescriptorHeap[i]->ParseRootSignature( rootSignature );
-        }
+        SetDescriptorTableLayouts( rootSignature );
 
         m_d3d12CommandList->SetGraphicsRootSignature(m_RootSignature);
 
@@ -917,10 +948,7 @@ void CommandList::SetComputeRootSignature( const RootSignature& rootSignature )
     {
         m_RootSignature = d3d12RootSignature;
 
-        for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
-        {
-            m_DynamicDescriptorHeap[i]->ParseRootSignature( rootSignature );
-        }
+        SetDescriptorTableLayouts( rootSignature );
 
         m_d3d12CommandList->SetComputeRootSignature(m_RootSignature);
 
@@ -948,7 +976,7 @@ void CommandList::SetShaderResourceView( uint32_t rootParameterIndex,
         TransitionBarrier(resource, stateAfter);
     }
 
-    m_DynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->StageDescriptors( rootParameterIndex, descriptorOffset, 1, resource.GetShaderResourceView( srv ) );
+    GetDynamicDescriptorHeap( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV ).StageDescriptors( rootParameterIndex, descriptorOffset, 1, resource.GetShaderResourceView( srv ) );
 
     TrackResource(resource);
 }
@@ -973,11 +1001,88 @@ void CommandList::SetUnorderedAccessView( uint32_t rootParameterIndex,
         TransitionBarrier( resource, stateAfter );
     }
 
-    m_DynamicDescriptorHeap[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV]->StageDescriptors( rootParameterIndex, descrptorOffset, 1, resource.GetUnorderedAccessView( uav ) );
+    GetDynamicDescriptorHeap( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV ).StageDescriptors( rootParameterIndex, descrptorOffset, 1, resource.GetUnorderedAccessView( uav ) );
 
     TrackResource(resource);
 }
 
+void CommandList::SetGraphicsBindlessDescriptorTable( uint32_t rootParameterIndex )
+{
+    GetDynamicDescriptorHeap( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV ).SetGraphicsBindlessDescriptorTable( *this, rootParameterIndex );
+}
+
+void CommandList::SetComputeBindlessDescriptorTable( uint32_t rootParameterIndex )
+{
+    GetDynamicDescriptorHeap( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV ).SetComputeBindlessDescriptorTable( *this, rootParameterIndex );
+}
+
+void CommandList::SetGraphicsBindlessShaderResourceView( uint32_t rootParameterIndex,
+                                                         uint32_t destOffsetIn32BitValues,
+                                                         const Resource& resource,
+                                                         D3D12_RESOURCE_STATES stateAfter )
+{
+    TransitionBarrier( resource, stateAfter );
+
+    m_d3d12CommandList->SetGraphicsRoot32BitConstant( rootParameterIndex, resource.GetBindlessShaderResourceIndex(), destOffsetIn32BitValues );
+
+    TrackResource( resource );
+}
+
+void CommandList::SetComputeBindlessShaderResourceView( uint32_t rootParameterIndex,
+                                                        uint32_t destOffsetIn32BitValues,
+                                                        const Resource& resource,
+                                                        D3D12_RESOURCE_STATES stateAfter )
+{
+    TransitionBarrier( resource, stateAfter );
+
+    m_d3d12CommandList->SetComputeRoot32BitConstant( rootParameterIndex, resource.GetBindlessShaderResourceIndex(), destOffsetIn32BitValues );
+
+    TrackResource( resource );
+}
+
+void CommandList::SetGraphicsBindlessUnorderedAccessView( uint32_t rootParameterIndex,
+                                                          uint32_t destOffsetIn32BitValues,
+                                                          const Resource& resource,
+                                                          D3D12_RESOURCE_STATES stateAfter )
+{
+    TransitionBarrier( resource, stateAfter );
+
+    m_d3d12CommandList->SetGraphicsRoot32BitConstant( rootParameterIndex, resource.GetBindlessUnorderedAccessIndex(), destOffsetIn32BitValues );
+
+    TrackResource( resource );
+}
+
+void CommandList::SetComputeBindlessUnorderedAccessView( uint32_t rootParameterIndex,
+                                                         uint32_t destOffsetIn32BitValues,
+                                                         const Resource& resource,
+                                                         D3D12_RESOURCE_STATES stateAfter )
+{
+    TransitionBarrier( resource, stateAfter );
+
+    m_d3d12CommandList->SetComputeRoot32BitConstant( rootParameterIndex, resource.GetBindlessUnorderedAccessIndex(), destOffsetIn32BitValues );
+
+    TrackResource( resource );
+}
+
+void CommandList::SetGraphicsSamplers( uint32_t rootParameterIndex, const D3D12_SAMPLER_DESC* samplerDescs, uint32_t numSamplers )
+{
+    auto& samplerHeap = Application::Get().GetSamplerHeap();
+
+    uint32_t samplerIndex = samplerHeap.GetSamplerTable( samplerDescs, numSamplers );
+
+    SetDescriptorHeap( D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, samplerHeap.GetDescriptorHeap().Get() );
+    m_d3d12CommandList->SetGraphicsRootDescriptorTable( rootParameterIndex, samplerHeap.GetGPUDescriptorHandle( samplerIndex ) );
+}
+
+void CommandList::SetComputeSamplers( uint32_t rootParameterIndex, const D3D12_SAMPLER_DESC* samplerDescs, uint32_t numSamplers )
+{
+    auto& samplerHeap = Application::Get().GetSamplerHeap();
+
+    uint32_t samplerIndex = samplerHeap.GetSamplerTable( samplerDescs, numSamplers );
+
+    SetDescriptorHeap( D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, samplerHeap.GetDescriptorHeap().Get() );
+    m_d3d12CommandList->SetComputeRootDescriptorTable( rootParameterIndex, samplerHeap.GetGPUDescriptorHandle( samplerIndex ) );
+}
 
 void CommandList::SetRenderTarget(const RenderTarget& renderTarget )
 {
@@ -1023,7 +1128,10 @@ void CommandList::Draw( uint32_t vertexCount, uint32_t instanceCount, uint32_t s
 
     for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
     {
-        m_DynamicDescriptorHeap[i]->CommitStagedDescriptorsForDraw( *this );
+        if ( m_DynamicDescriptorHeap[i] )
+        {
+            m_DynamicDescriptorHeap[i]->CommitStagedDescriptorsForDraw( *this );
+        }
     }
 
     m_d3d12CommandList->DrawInstanced( vertexCount, instanceCount, startVertex, startInstance );
@@ -1035,7 +1143,10 @@ void CommandList::DrawIndexed( uint32_t indexCount, uint32_t instanceCount, uint
 
     for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
     {
-        m_DynamicDescriptorHeap[i]->CommitStagedDescriptorsForDraw( *this );
+        if ( m_DynamicDescriptorHeap[i] )
+        {
+            m_DynamicDescriptorHeap[i]->CommitStagedDescriptorsForDraw( *this );
+        }
     }
 
     m_d3d12CommandList->DrawIndexedInstanced( indexCount, instanceCount, startIndex, baseVertex, startInstance );
@@ -1047,7 +1158,10 @@ void CommandList::Dispatch( uint32_t numGroupsX, uint32_t numGroupsY, uint32_t n
 
     for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
     {
-        m_DynamicDescriptorHeap[i]->CommitStagedDescriptorsForDispatch( *this );
+        if ( m_DynamicDescriptorHeap[i] )
+        {
+            m_DynamicDescriptorHeap[i]->CommitStagedDescriptorsForDispatch( *this );
+        }
     }
 
     m_d3d12CommandList->Dispatch( numGroupsX, numGroupsY, numGroupsZ );
@@ -1060,6 +1174,10 @@ bool CommandList::Close( CommandList& pendingCommandList )
 
     m_d3d12CommandList->Close();
 
+    // A command list without a resource state tracker didn't transition any resources.
+    if ( !m_ResourceStateTracker )
+        return false;
+
     // Flush pending resource barriers.
     uint32_t numPendingBarriers = m_ResourceStateTracker->FlushPendingResourceBarriers( pendingCommandList );
     // Commit the final resource state to the global state.
@@ -1080,14 +1198,24 @@ void CommandList::Reset()
     ThrowIfFailed( m_d3d12CommandAllocator->Reset() );
     ThrowIfFailed( m_d3d12CommandList->Reset( m_d3d12CommandAllocator.Get(), nullptr ) );
 
-    m_ResourceStateTracker->Reset();
-    m_UploadBuffer->Reset();
+    if ( m_ResourceStateTracker )
+    {
+        m_ResourceStateTracker->Reset();
+    }
+
+    if ( m_UploadBuffer )
+    {
+        m_UploadBuffer->Reset();
+    }
 
     ReleaseTrackedObjects();
 
     for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
     {
-        m_DynamicDescriptorHeap[i]->Reset();
+        if ( m_DynamicDescriptorHeap[i] )
+        {
+            m_DynamicDescriptorHeap[i]->Reset();
+        }
         m_DescriptorHeaps[i] = nullptr;
     }
 
@@ -1110,6 +1238,96 @@ void CommandList::ReleaseTrackedObjects()
     m_TrackedObjects.clear();
 }
 
+CommandList::MemoryUsage CommandList::GetMemoryUsage() const
+{
+    MemoryUsage memoryUsage = {};
+
+    if ( m_UploadBuffer )
+    {
+        memoryUsage.UploadBufferBytes = m_UploadBuffer->GetMemoryUsage();
+    }
+
+    if ( m_ResourceStateTracker )
+    {
+        memoryUsage.ResourceStateTrackerBytes = m_ResourceStateTracker->GetMemoryUsage();
+    }
+
+    for ( int i = 0; i < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++i )
+    {
+        if ( m_DynamicDescriptorHeap[i] )
+        {
+            memoryUsage.DynamicDescriptorHeapBytes += m_DynamicDescriptorHeap[i]->GetMemoryUsage();
+            memoryUsage.ShaderVisibleDescriptorBytes += m_DynamicDescriptorHeap[i]->GetShaderVisibleMemoryUsage();
+        }
+    }
+
+    memoryUsage.TrackedObjectsBytes = m_TrackedObjects.capacity() * sizeof( TrackedObjects::value_type );
+
+    return memoryUsage;
+}
+
+UploadBufferStats CommandList::GetUploadBufferStats() const
+{
+    if ( m_UploadBuffer )
+    {
+        return m_UploadBuffer->GetStats();
+    }
+
+    return UploadBufferStats {};
+}
+
+UploadBuffer& CommandList::GetUploadBuffer()
+{
+    if ( !m_UploadBuffer )
+    {
+        // Take the pages from the upload ring of the command queue that
+        // executes this command list.
+        UploadRing* uploadRing = Application::Get().GetCommandQueue( m_d3d12CommandListType )->GetUploadRing();
+        size_t pageSize = uploadRing ? uploadRing->GetBlockSize() : _2MB;
+
+        m_UploadBuffer = std::make_unique<UploadBuffer>( pageSize, uploadRing );
+    }
+
+    return *m_UploadBuffer;
+}
+
+ResourceStateTracker& CommandList::GetResourceStateTracker()
+{
+    if ( !m_ResourceStateTracker )
+    {
+        m_ResourceStateTracker = std::make_unique<ResourceStateTracker>();
+    }
+
+    return *m_ResourceStateTracker;
+}
+
+DynamicDescriptorHeap& CommandList::GetDynamicDescriptorHeap( D3D12_DESCRIPTOR_HEAP_TYPE heapType )
+{
+    // RTV and DSV descriptors are never shader visible and sampler tables are
+    // bound directly from the global sampler heap (see SetGraphicsSamplers).
+    assert( heapType == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV && "Only CBV, SRV, and UAV descriptors are staged." );
+
+    auto& dynamicDescriptorHeap = m_DynamicDescriptorHeap[heapType];
+    if ( !dynamicDescriptorHeap )
+    {
+        dynamicDescriptorHeap = std::make_unique<DynamicDescriptorHeap>( heapType );
+    }
+
+    return *dynamicDescriptorHeap;
+}
+
+void CommandList::SetDescriptorTableLayouts( const RootSignature& rootSignature )
+{
+    const D3D12_DESCRIPTOR_HEAP_TYPE heapType = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+
+    // The dynamic descriptor heap is only created for root signatures that
+    // have CBV, SRV, or UAV descriptor tables.
+    if ( m_DynamicDescriptorHeap[heapType] || rootSignature.GetDescriptorTableBitMask( heapType ) != 0 )
+    {
+        GetDynamicDescriptorHeap( heapType ).SetRootSignature( rootSignature );
+    }
+}
+
 void CommandList::SetDescriptorHeap( D3D12_DESCRIPTOR_HEAP_TYPE heapType, ID3D12DescriptorHeap* heap )
 {
     if ( m_DescriptorHeaps[heapType] != heap )
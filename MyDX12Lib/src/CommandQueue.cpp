@@ -2,10 +2,16 @@
 
 #include <CommandQueue.h>
 
+#include <Application.h>
+#include <UploadRing.h>
+#include <Window.h>
+
 CommandQueue::CommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type)
     : m_CommandListType(type)
     , m_d3d12Device(device)
     , m_FenceValue(0)
+    , m_CompletedFenceValue(0)
+    , m_NumOpenCommandLists(0)
 {
     D3D12_COMMAND_QUEUE_DESC desc = {};
     desc.Type = type;
@@ -18,6 +24,12 @@ CommandQueue::CommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE
 
     m_FenceEvent = ::CreateEvent(nullptr, FALSE, FALSE, nullptr);
     assert(m_FenceEvent && "Failed to create fence event handle.");
+
+    // Copy command lists don't use dynamic buffers.
+    if (m_CommandListType != D3D12_COMMAND_LIST_TYPE_COPY)
+    {
+        m_UploadRing = std::make_unique<UploadRing>(*this, m_d3d12Device, Window::BufferCount * _8MB);
+    }
 }
 
 CommandQueue::~CommandQueue()
@@ -33,7 +45,7 @@ uint64_t CommandQueue::Signal()
 
 bool CommandQueue::IsFenceComplete(uint64_t fenceValue)
 {
-    return m_d3d12Fence->GetCompletedValue() >= fenceValue;
+    return m_CompletedFenceValue >= fenceValue || UpdateCompletedFenceValue() >= fenceValue;
 }
 
 void CommandQueue::WaitForFenceValue(uint64_t fenceValue)
@@ -42,9 +54,50 @@ void CommandQueue::WaitForFenceValue(uint64_t fenceValue)
     {
         m_d3d12Fence->SetEventOnCompletion(fenceValue, m_FenceEvent);
         ::WaitForSingleObject(m_FenceEvent, DWORD_MAX);
+
+        UpdateCompletedFenceValue();
     }
 }
 
+uint64_t CommandQueue::GetNextFenceValue() const
+{
+    return m_FenceValue + 1;
+}
+
+uint64_t CommandQueue::GetCompletedFenceValue() const
+{
+    return m_CompletedFenceValue;
+}
+
+uint32_t CommandQueue::GetNumOpenCommandLists() const
+{
+    return m_NumOpenCommandLists;
+}
+
+uint64_t CommandQueue::UpdateCompletedFenceValue()
+{
+    uint64_t completedFenceValue = m_d3d12Fence->GetCompletedValue();
+    uint64_t previousFenceValue = m_CompletedFenceValue;
+
+    while (completedFenceValue > previousFenceValue)
+    {
+        if (m_CompletedFenceValue.compare_exchange_weak(previousFenceValue, completedFenceValue))
+        {
+            // Descriptors and upload memory that were waiting for this fence
+            // value can be reused.
+            Application::Get().ReleaseStaleDescriptors();
+
+            if (m_UploadRing)
+            {
+                m_UploadRing->ReleaseStaleBlocks(completedFenceValue);
+            }
+            break;
+        }
+    }
+
+    return completedFenceValue;
+}
+
 void CommandQueue::Flush()
 {
     WaitForFenceValue(Signal());
@@ -100,6 +153,8 @@ ComPtr<ID3D12GraphicsCommandList2> CommandQueue::GetCommandList()
     // retrieved when the command list is executed.
     ThrowIfFailed(commandList->SetPrivateDataInterface(__uuidof(ID3D12CommandAllocator), commandAllocator.Get()));
 
+    ++m_NumOpenCommandLists;
+
     return commandList;
 }
 
@@ -120,6 +175,13 @@ uint64_t CommandQueue::ExecuteCommandList(ComPtr<ID3D12GraphicsCommandList2> com
     m_d3d12CommandQueue->ExecuteCommandLists(1, ppCommandLists);
     uint64_t fenceValue = Signal();
 
+    assert(m_NumOpenCommandLists > 0);
+    --m_NumOpenCommandLists;
+
+    // Poll the fence so that resources are released as soon as previously
+    // executed command lists have completed.
+    UpdateCompletedFenceValue();
+
     m_CommandAllocatorQueue.emplace(CommandAllocatorEntry{ fenceValue, commandAllocator });
     m_CommandListQueue.push(commandList);
 
@@ -135,3 +197,8 @@ Microsoft::WRL::ComPtr<ID3D12CommandQueue> CommandQueue::GetD3D12CommandQueue()
 {
     return m_d3d12CommandQueue;
 }
+
+UploadRing* CommandQueue::GetUploadRing() const
+{
+    return m_UploadRing.get();
+}
@@ -3,20 +3,16 @@
 #include <DescriptorAllocation.h>
 
 #include <Application.h>
-#include <DescriptorAllocatorPage.h>
+#include <DescriptorAllocator.h>
 
 DescriptorAllocation::DescriptorAllocation()
-    : m_Descriptor{ 0 }
-    , m_NumHandles( 0 )
-    , m_DescriptorSize( 0 )
-    , m_Page( nullptr )
+    : m_Handle{ 0, 0, 0 }
+    , m_Allocator( nullptr )
 {}
 
-DescriptorAllocation::DescriptorAllocation( D3D12_CPU_DESCRIPTOR_HANDLE descriptor, uint32_t numHandles, uint32_t descriptorSize, std::shared_ptr<DescriptorAllocatorPage> page )
-    : m_Descriptor( descriptor )
-    , m_NumHandles( numHandles )
-    , m_DescriptorSize( descriptorSize )
-    , m_Page( page )
+DescriptorAllocation::DescriptorAllocation( DescriptorHandle handle, DescriptorAllocator* allocator )
+    : m_Handle( handle )
+    , m_Allocator( allocator )
 {}
 
 
@@ -26,14 +22,11 @@ DescriptorAllocation::~DescriptorAllocation()
 }
 
 DescriptorAllocation::DescriptorAllocation( DescriptorAllocation&& allocation )
-    : m_Descriptor(allocation.m_Descriptor)
-    , m_NumHandles(allocation.m_NumHandles)
-    , m_DescriptorSize(allocation.m_DescriptorSize)
-    , m_Page(std::move(allocation.m_Page))
+    : m_Handle(allocation.m_Handle)
+    , m_Allocator(allocation.m_Allocator)
 {
-    allocation.m_Descriptor.ptr = 0;
-    allocation.m_NumHandles = 0;
-    allocation.m_DescriptorSize = 0;
+    allocation.m_Handle = { 0, 0, 0 };
+    allocation.m_Allocator = nullptr;
 }
 
 DescriptorAllocation& DescriptorAllocation::operator=( DescriptorAllocation&& other )
@@ -41,50 +34,47 @@ DescriptorAllocation& DescriptorAllocation::operator=( DescriptorAllocation&& ot
     // Free this descriptor if it points to anything.
     Free();
 
-    m_Descriptor = other.m_Descriptor;
-    m_NumHandles = other.m_NumHandles;
-    m_DescriptorSize = other.m_DescriptorSize;
-    m_Page = std::move( other.m_Page );
+    m_Handle = other.m_Handle;
+    m_Allocator = other.m_Allocator;
 
-    other.m_Descriptor.ptr = 0;
-    other.m_NumHandles = 0;
-    other.m_DescriptorSize = 0;
+    other.m_Handle = { 0, 0, 0 };
+    other.m_Allocator = nullptr;
 
     return *this;
 }
 
 void DescriptorAllocation::Free()
 {
-    if ( !IsNull() && m_Page )
+    if ( !IsNull() && m_Allocator )
     {
-        m_Page->Free( std::move( *this ), Application::GetFrameCount() );
-        
-        m_Descriptor.ptr = 0;
-        m_NumHandles = 0;
-        m_DescriptorSize = 0;
-        m_Page.reset();
+        // The descriptors may still be referenced by commands that are executed
+        // next on any of the command queues.
+        m_Allocator->Free( m_Handle, Application::Get().GetNextFenceTag() );
+
+        m_Handle = { 0, 0, 0 };
+        m_Allocator = nullptr;
     }
 }
 
 // Check if this a valid descriptor.
 bool DescriptorAllocation::IsNull() const
 {
-    return m_Descriptor.ptr == 0;
+    return m_Handle.NumHandles == 0;
 }
 
 // Get a descriptor at a particular offset in the allocation.
 D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocation::GetDescriptorHandle( uint32_t offset ) const
 {
-    assert( offset < m_NumHandles );
-    return { m_Descriptor.ptr + ( m_DescriptorSize * offset ) };
+    assert( offset < m_Handle.NumHandles );
+    return m_Allocator->GetDescriptorHandle( m_Handle, offset );
 }
 
 uint32_t DescriptorAllocation::GetNumHandles() const
 {
-    return m_NumHandles;
+    return m_Handle.NumHandles;
 }
 
-std::shared_ptr<DescriptorAllocatorPage> DescriptorAllocation::GetDescriptorAllocatorPage() const
+DescriptorHandle DescriptorAllocation::GetHandle() const
 {
-    return m_Page;
+    return m_Handle;
 }
\ No newline at end of file
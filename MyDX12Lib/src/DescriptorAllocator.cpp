@@ -3,72 +3,781 @@
 #include <DescriptorAllocator.h>
 #include <DescriptorAllocatorPage.h>
 
-DescriptorAllocator::DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerHeap)
+#include <Application.h>
+
+#include <bit>
+#include <thread>
+
+struct DescriptorAllocator::Magazine
+{
+    // The maximum number of descriptors that are ready to be allocated.
+    static const uint32_t Capacity = 64;
+    // The number of descriptors to request from the pages when the magazine is empty.
+    static const uint32_t RefillCount = Capacity / 2;
+    // The maximum number of stale descriptors waiting for their fence values to complete.
+    static const uint32_t StaleCapacity = 128;
+
+    struct Entry
+    {
+        DescriptorAllocatorPage::OffsetType Offset;
+        uint16_t PageIndex;
+        // The fence values that must be completed before the descriptor can be reused.
+        FenceTag Fence;
+    };
+
+    Entry Ready[Capacity];
+    uint32_t NumReady = 0;
+
+    // Ring buffer of stale descriptors in the order that they were freed.
+    Entry Stale[StaleCapacity];
+    uint32_t StaleHead = 0;
+    uint32_t NumStale = 0;
+
+    // The slab page that the magazine was last refilled from.
+    uint32_t SlabIndex = 0;
+
+    // Statistics that are written by the owning thread and read by GetStats.
+    std::atomic<uint64_t> NumAllocations = 0;
+    std::atomic<uint32_t> NumCachedDescriptors = 0;
+    std::atomic<uint32_t> NumCachedStaleDescriptors = 0;
+
+    void PublishStats()
+    {
+        NumCachedDescriptors.store( NumReady, std::memory_order_relaxed );
+        NumCachedStaleDescriptors.store( NumStale, std::memory_order_relaxed );
+    }
+
+    // Set when the thread that owns the magazine exits. The descriptors are
+    // then returned to the pages by the allocator.
+    std::atomic<bool> IsOrphaned = false;
+
+    // Set by the owning thread while it uses the magazine and by
+    // TrimIdleMagazines while it trims the magazine. TrimIdleMagazines skips
+    // magazines that are in use, so the owning thread only waits if it starts
+    // to use the magazine during the (once per frame) trim.
+    std::atomic<bool> InUse = false;
+
+    // Lockable interface over the InUse flag (for std::lock_guard and std::unique_lock).
+    void lock()
+    {
+        while ( InUse.exchange( true, std::memory_order_acquire ) )
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    bool try_lock()
+    {
+        return !InUse.load( std::memory_order_relaxed ) && !InUse.exchange( true, std::memory_order_acquire );
+    }
+
+    void unlock()
+    {
+        InUse.store( false, std::memory_order_release );
+    }
+
+    // The number of allocations at the previous call to TrimIdleMagazines.
+    uint64_t LastNumAllocations = 0;
+};
+
+struct DescriptorAllocator::ThreadMagazines
+{
+    ~ThreadMagazines()
+    {
+        for ( auto& magazine : Magazines )
+        {
+            if ( magazine )
+            {
+                magazine->IsOrphaned = true;
+            }
+        }
+    }
+
+    MagazinePool Magazines;
+};
+
+thread_local DescriptorAllocator::ThreadMagazines DescriptorAllocator::ms_ThreadMagazines;
+
+std::atomic<uint64_t> DescriptorAllocator::ms_FreeGenerations[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+
+static std::atomic<uint32_t> gs_NextAllocatorId = 0;
+
+DescriptorAllocator::DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerHeap, uint32_t maxIdleFrames)
     : m_HeapType(type)
     , m_NumDescriptorsPerHeap(numDescriptorsPerHeap)
+    , m_NumPages(0)
+    , m_MaxIdleFrames(maxIdleFrames)
+    , m_NumRangeAllocations(0)
+    , m_NumOrphanedAllocations(0)
+    , m_LastNumAllocations(0)
+    , m_NumSlabPages(0)
+    , m_AllocatorId(gs_NextAllocatorId++)
 {
+    for ( auto& completedFenceValue : m_CompletedFenceValues )
+    {
+        completedFenceValue.store( 0, std::memory_order_relaxed );
+    }
+
+    for ( auto& page : m_PageTable )
+    {
+        page.store( nullptr, std::memory_order_relaxed );
+    }
+
+    for ( auto& stalePages : m_StalePages )
+    {
+        stalePages.store( 0, std::memory_order_relaxed );
+    }
 }
 
 DescriptorAllocator::~DescriptorAllocator()
 {}
 
-std::shared_ptr<DescriptorAllocatorPage> DescriptorAllocator::CreateAllocatorPage()
+uint16_t DescriptorAllocator::CreateAllocatorPage( bool isSlab )
 {
-    auto newPage = std::make_shared<DescriptorAllocatorPage>( m_HeapType, m_NumDescriptorsPerHeap );
+    uint16_t pageIndex;
+    if ( !m_FreePageIndices.empty() )
+    {
+        pageIndex = m_FreePageIndices.back();
+        m_FreePageIndices.pop_back();
+    }
+    else if ( m_NumPages < MaxPages )
+    {
+        pageIndex = static_cast<uint16_t>( m_NumPages++ );
+    }
+    else
+    {
+        throw std::bad_alloc();
+    }
+
+    uint32_t numDescriptors = isSlab ? NumDescriptorsPerSlab : m_NumDescriptorsPerHeap;
+    m_Pages[pageIndex] = std::make_unique<DescriptorAllocatorPage>( m_HeapType, numDescriptors, isSlab );
+    m_PageInfos[pageIndex] = { 0, 0, 0 };
 
-    m_HeapPool.emplace_back( newPage );
-    m_AvailableHeaps.insert( m_HeapPool.size() - 1 );
+    // Publish the page to the threads that resolve descriptor handles without a lock.
+    m_PageTable[pageIndex].store( m_Pages[pageIndex].get(), std::memory_order_release );
+
+    // Slab pages are not added to the available heaps.
+    if ( !isSlab )
+    {
+        UpdateAvailableHeap( pageIndex );
+    }
 
-    return newPage;
+    return pageIndex;
+}
+
+void DescriptorAllocator::DestroyAllocatorPage( uint16_t pageIndex, const FenceTag& fenceTag )
+{
+    auto& pageInfo = m_PageInfos[pageIndex];
+    if ( pageInfo.LargestFreeBlock > 0 )
+    {
+        m_AvailableHeaps.erase( { pageInfo.LargestFreeBlock, pageIndex } );
+        pageInfo.LargestFreeBlock = 0;
+    }
+
+    // The page has no allocated descriptors, so no live handle refers to it.
+    // The page is kept alive and its index is not reused until the fence tag
+    // has completed, in case a handle that was just freed is still being resolved.
+    m_PageTable[pageIndex].store( nullptr, std::memory_order_release );
+    m_RetiredPages.push( { pageIndex, fenceTag } );
+}
+
+void DescriptorAllocator::ReleaseRetiredPages( const FenceTag& completedFenceValues )
+{
+    while ( !m_RetiredPages.empty() && m_RetiredPages.front().Fence.IsComplete( completedFenceValues ) )
+    {
+        uint16_t pageIndex = m_RetiredPages.front().PageIndex;
+
+        m_Pages[pageIndex].reset();
+        m_FreePageIndices.push_back( pageIndex );
+
+        m_RetiredPages.pop();
+    }
+}
+
+void DescriptorAllocator::MarkStalePage( uint16_t pageIndex )
+{
+    // Set after the stale descriptors were queued on the page, so
+    // ReleaseStaleDescriptors either sees the descriptors or the bit.
+    m_StalePages[pageIndex / 64].fetch_or( 1ull << ( pageIndex % 64 ), std::memory_order_release );
+}
+
+DescriptorAllocatorPage* DescriptorAllocator::GetPage( uint16_t pageIndex ) const
+{
+    return m_PageTable[pageIndex].load( std::memory_order_acquire );
+}
+
+void DescriptorAllocator::UpdateAvailableHeap( uint16_t pageIndex )
+{
+    auto& pageInfo = m_PageInfos[pageIndex];
+    if ( pageInfo.LargestFreeBlock > 0 )
+    {
+        m_AvailableHeaps.erase( { pageInfo.LargestFreeBlock, pageIndex } );
+    }
+
+    pageInfo.LargestFreeBlock = m_Pages[pageIndex]->GetLargestFreeBlock();
+    if ( pageInfo.LargestFreeBlock > 0 )
+    {
+        m_AvailableHeaps.insert( { pageInfo.LargestFreeBlock, pageIndex } );
+    }
+}
+
+uint32_t DescriptorAllocator::AcquireSlabPage()
+{
+    uint32_t numSlabPages = m_NumSlabPages.load( std::memory_order_relaxed );
+
+    for ( uint32_t i = 0; i < numSlabPages; ++i )
+    {
+        auto& slabPage = m_Pages[m_SlabPages[i]];
+        if ( !slabPage->IsRetired() && slabPage->NumFreeHandles() > 0 )
+        {
+            return i;
+        }
+    }
+
+    for ( uint32_t i = 0; i < numSlabPages; ++i )
+    {
+        auto& slabPage = m_Pages[m_SlabPages[i]];
+        if ( slabPage->IsRetired() )
+        {
+            slabPage->ReviveSlab();
+            m_PageInfos[m_SlabPages[i]].NumIdleFrames = 0;
+            return i;
+        }
+    }
+
+    if ( numSlabPages == MaxSlabPages )
+    {
+        return MaxSlabPages;
+    }
+
+    // Publish the page to the threads that refill their magazines without a lock.
+    m_SlabPages[numSlabPages] = CreateAllocatorPage( true );
+    m_NumSlabPages.store( numSlabPages + 1, std::memory_order_release );
+
+    return numSlabPages;
 }
 
 DescriptorAllocation DescriptorAllocator::Allocate(uint32_t numDescriptors)
 {
+    if ( numDescriptors == 1 )
+    {
+        Magazine& magazine = GetThreadMagazine();
+        std::lock_guard magazineLock( magazine );
+
+        // Stale descriptors can be reused once their fence values have completed.
+        PromoteStaleDescriptors( magazine );
+
+        if ( magazine.NumReady == 0 )
+        {
+            RefillMagazine( magazine );
+        }
+
+        const Magazine::Entry& entry = magazine.Ready[--magazine.NumReady];
+
+        // Only the owning thread writes the counter, so no atomic read-modify-write is needed.
+        magazine.NumAllocations.store( magazine.NumAllocations.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+        magazine.PublishStats();
+
+        return DescriptorAllocation( { entry.Offset, entry.PageIndex, 1 }, this );
+    }
+
+    // The number of descriptors must fit in a DescriptorHandle.
+    if ( numDescriptors > UINT16_MAX )
+    {
+        throw std::bad_alloc();
+    }
+
     std::lock_guard lock( m_AllocationMutex );
 
-    DescriptorAllocation allocation;
+    auto offset = DescriptorAllocatorPage::InvalidOffset;
+    uint16_t pageIndex = 0;
 
-    for ( auto iter = m_AvailableHeaps.begin(); iter != m_AvailableHeaps.end(); ++iter )
+    // Find the page with the smallest largest free block that can satisfy the request.
+    auto iter = m_AvailableHeaps.lower_bound( { numDescriptors, 0 } );
+    if ( iter != m_AvailableHeaps.end() )
     {
-        auto allocatorPage = m_HeapPool[*iter];
+        pageIndex = iter->second;
+        offset = m_Pages[pageIndex]->Allocate( numDescriptors );
 
-        allocation = allocatorPage->Allocate( numDescriptors );
+        UpdateAvailableHeap( pageIndex );
+    }
 
-        if ( allocatorPage->NumFreeHandles() == 0 )
+    // No available heap could satisfy the requested number of descriptors.
+    if ( offset == DescriptorAllocatorPage::InvalidOffset )
+    {
+        m_NumDescriptorsPerHeap = std::max( m_NumDescriptorsPerHeap, numDescriptors );
+        pageIndex = CreateAllocatorPage();
+
+        offset = m_Pages[pageIndex]->Allocate( numDescriptors );
+
+        UpdateAvailableHeap( pageIndex );
+    }
+
+    m_PageInfos[pageIndex].NumIdleFrames = 0;
+    ++m_NumRangeAllocations;
+
+    DescriptorHandle handle = { offset, pageIndex, static_cast<uint16_t>( numDescriptors ) };
+
+    return DescriptorAllocation( handle, this );
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocator::GetDescriptorHandle( DescriptorHandle handle, uint32_t offset ) const
+{
+    auto page = GetPage( handle.PageIndex );
+
+    // Ranges are referenced by their slot in the indirection table of the page
+    // since they can be relocated by Compact.
+    auto baseOffset = handle.NumHandles > 1 ? page->GetSlotOffset( handle.Offset ) : handle.Offset;
+
+    return page->GetDescriptorHandle( baseOffset + offset );
+}
+
+void DescriptorAllocator::Free( DescriptorHandle handle, const FenceTag& fenceTag )
+{
+    AdvanceFreeGeneration( m_HeapType );
+
+    // Single descriptors go back to the magazine of the calling thread first.
+    if ( handle.NumHandles == 1 )
+    {
+        FreeToMagazine( handle, fenceTag );
+        return;
+    }
+
+    GetPage( handle.PageIndex )->FreeSlot( handle.Offset, fenceTag );
+    MarkStalePage( handle.PageIndex );
+}
+
+uint32_t DescriptorAllocator::Compact( uint32_t maxDescriptorsToMove, const FenceTag& fenceTag )
+{
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    // Compact the most fragmented pages first. A page is fragmented if its free
+    // descriptors are not in a single block.
+    std::vector< std::pair<uint32_t, uint16_t> > fragmentedPages;
+    for ( uint32_t i = 0; i < m_NumPages; ++i )
+    {
+        auto& page = m_Pages[i];
+        if ( page && !page->IsSlab() )
         {
-            iter = m_AvailableHeaps.erase( iter );
+            uint32_t numFragmentedDescriptors = page->GetNumFragmentedDescriptors();
+            if ( numFragmentedDescriptors > 0 )
+            {
+                fragmentedPages.emplace_back( numFragmentedDescriptors, static_cast<uint16_t>( i ) );
+            }
         }
+    }
+
+    std::sort( fragmentedPages.begin(), fragmentedPages.end(), std::greater<>() );
 
-        // A valid allocation has been found.
-        if ( !allocation.IsNull() )
+    uint32_t numMovedDescriptors = 0;
+    for ( auto& fragmentedPage : fragmentedPages )
+    {
+        if ( numMovedDescriptors >= maxDescriptorsToMove )
+        {
             break;
+        }
+
+        uint16_t pageIndex = fragmentedPage.second;
+        numMovedDescriptors += m_Pages[pageIndex]->Compact( maxDescriptorsToMove - numMovedDescriptors, fenceTag );
+
+        UpdateAvailableHeap( pageIndex );
+        MarkStalePage( pageIndex );
     }
 
-    // No available heap could satisfy the requested number of descriptors.
-    if ( allocation.IsNull() )
+    // The old locations of the relocated descriptors are freed.
+    if ( numMovedDescriptors > 0 )
     {
-        m_NumDescriptorsPerHeap = std::max( m_NumDescriptorsPerHeap, numDescriptors );
-        auto newPage = CreateAllocatorPage();
+        AdvanceFreeGeneration( m_HeapType );
+    }
 
-        allocation = newPage->Allocate( numDescriptors );
+    return numMovedDescriptors;
+}
+
+DescriptorAllocator::Magazine& DescriptorAllocator::GetThreadMagazine()
+{
+    auto& magazines = ms_ThreadMagazines.Magazines;
+    if ( m_AllocatorId >= magazines.size() )
+    {
+        magazines.resize( m_AllocatorId + 1 );
     }
 
-    return allocation;
+    auto& magazine = magazines[m_AllocatorId];
+    if ( !magazine )
+    {
+        magazine = std::make_shared<Magazine>();
+
+        std::lock_guard lock( m_MagazineMutex );
+        m_Magazines.push_back( magazine );
+    }
+
+    return *magazine;
+}
+
+void DescriptorAllocator::RefillMagazine( Magazine& magazine )
+{
+    DescriptorAllocatorPage::OffsetType offsets[Magazine::RefillCount];
+
+    auto takeDescriptors = [&]( uint16_t pageIndex, uint32_t numAllocated )
+    {
+        for ( uint32_t i = 0; i < numAllocated; ++i )
+        {
+            magazine.Ready[magazine.NumReady++] = { offsets[i], pageIndex, {} };
+        }
+    };
+
+    // First try to claim descriptors from the existing slab pages (lock-free).
+    // Start at the slab page that the magazine was last refilled from.
+    uint32_t numSlabPages = m_NumSlabPages.load( std::memory_order_acquire );
+    for ( uint32_t i = 0; i < numSlabPages && magazine.NumReady < Magazine::RefillCount; ++i )
+    {
+        uint32_t slabIndex = ( magazine.SlabIndex + i ) % numSlabPages;
+        uint16_t pageIndex = m_SlabPages[slabIndex];
+
+        uint32_t numAllocated = GetPage( pageIndex )->AllocateSlabDescriptors( Magazine::RefillCount - magazine.NumReady, offsets );
+        if ( numAllocated > 0 )
+        {
+            takeDescriptors( pageIndex, numAllocated );
+            magazine.SlabIndex = slabIndex;
+        }
+    }
+
+    if ( magazine.NumReady > 0 )
+    {
+        return;
+    }
+
+    std::lock_guard lock( m_AllocationMutex );
+
+    // All slab pages are full. Another thread may have released descriptors or
+    // added a new slab page while waiting for the lock.
+    uint32_t slabIndex = AcquireSlabPage();
+    if ( slabIndex < MaxSlabPages )
+    {
+        uint16_t pageIndex = m_SlabPages[slabIndex];
+
+        takeDescriptors( pageIndex, m_Pages[pageIndex]->AllocateSlabDescriptors( Magazine::RefillCount, offsets ) );
+        magazine.SlabIndex = slabIndex;
+    }
+
+    if ( magazine.NumReady > 0 )
+    {
+        return;
+    }
+
+    // The maximum number of slab pages has been reached. Fall back to the regular pages.
+    while ( magazine.NumReady < Magazine::RefillCount && !m_AvailableHeaps.empty() )
+    {
+        uint16_t pageIndex = m_AvailableHeaps.begin()->second;
+
+        takeDescriptors( pageIndex, m_Pages[pageIndex]->AllocateSingleDescriptors( Magazine::RefillCount - magazine.NumReady, offsets ) );
+        m_PageInfos[pageIndex].NumIdleFrames = 0;
+
+        UpdateAvailableHeap( pageIndex );
+    }
+
+    // No available heap has any descriptors left.
+    if ( magazine.NumReady == 0 )
+    {
+        uint16_t pageIndex = CreateAllocatorPage();
+
+        takeDescriptors( pageIndex, m_Pages[pageIndex]->AllocateSingleDescriptors( Magazine::RefillCount, offsets ) );
+
+        UpdateAvailableHeap( pageIndex );
+    }
+}
+
+void DescriptorAllocator::PromoteStaleDescriptors( Magazine& magazine )
+{
+    if ( magazine.NumStale == 0 )
+    {
+        return;
+    }
+
+    // The completed fence values only increase, so reading them one at a time
+    // at worst results in an older (more conservative) set of fence values.
+    FenceTag completedFenceValues;
+    for ( uint32_t i = 0; i < FenceTag::NumQueues; ++i )
+    {
+        completedFenceValues.FenceValues[i] = m_CompletedFenceValues[i].load( std::memory_order_acquire );
+    }
+
+    while ( magazine.NumStale > 0 && magazine.Stale[magazine.StaleHead].Fence.IsComplete( completedFenceValues ) )
+    {
+        if ( magazine.NumReady == Magazine::Capacity )
+        {
+            // The magazine is full. Return half of the ready descriptors to their pages.
+            ReleaseReadyDescriptors( magazine, Magazine::Capacity / 2 );
+        }
+
+        magazine.Ready[magazine.NumReady++] = magazine.Stale[magazine.StaleHead];
+        magazine.StaleHead = ( magazine.StaleHead + 1 ) % Magazine::StaleCapacity;
+        --magazine.NumStale;
+    }
+}
+
+void DescriptorAllocator::ReleaseReadyDescriptors( Magazine& magazine, uint32_t numDescriptors )
+{
+    std::unique_lock<std::mutex> lock( m_AllocationMutex, std::defer_lock );
+
+    for ( uint32_t i = 0; i < numDescriptors; ++i )
+    {
+        const Magazine::Entry& entry = magazine.Ready[--magazine.NumReady];
+        auto page = GetPage( entry.PageIndex );
+
+        if ( page->IsSlab() )
+        {
+            page->ReleaseDescriptor( entry.Offset );
+            continue;
+        }
+
+        // Regular pages are indexed by their largest free block in the
+        // available heaps, which is only updated under the allocation mutex.
+        if ( !lock.owns_lock() )
+        {
+            lock.lock();
+        }
+
+        page->ReleaseDescriptor( entry.Offset );
+        UpdateAvailableHeap( entry.PageIndex );
+    }
+}
+
+void DescriptorAllocator::FlushMagazine( Magazine& magazine )
+{
+    // The ready descriptors are no longer in use by the GPU.
+    ReleaseReadyDescriptors( magazine, magazine.NumReady );
+
+    for ( ; magazine.NumStale > 0; --magazine.NumStale )
+    {
+        const Magazine::Entry& entry = magazine.Stale[magazine.StaleHead];
+        GetPage( entry.PageIndex )->Free( entry.Offset, 1, entry.Fence );
+        MarkStalePage( entry.PageIndex );
+
+        magazine.StaleHead = ( magazine.StaleHead + 1 ) % Magazine::StaleCapacity;
+    }
+}
+
+void DescriptorAllocator::FreeToMagazine( DescriptorHandle handle, const FenceTag& fenceTag )
+{
+    Magazine& magazine = GetThreadMagazine();
+    std::lock_guard magazineLock( magazine );
+
+    if ( magazine.NumStale == Magazine::StaleCapacity )
+    {
+        PromoteStaleDescriptors( magazine );
+    }
+
+    if ( magazine.NumStale == Magazine::StaleCapacity )
+    {
+        // None of the stale descriptors can be reused yet.
+        // Return the oldest stale descriptor to the stale queue of its page.
+        const Magazine::Entry& oldest = magazine.Stale[magazine.StaleHead];
+        GetPage( oldest.PageIndex )->Free( oldest.Offset, 1, oldest.Fence );
+        MarkStalePage( oldest.PageIndex );
+
+        magazine.StaleHead = ( magazine.StaleHead + 1 ) % Magazine::StaleCapacity;
+        --magazine.NumStale;
+    }
+
+    uint32_t index = ( magazine.StaleHead + magazine.NumStale ) % Magazine::StaleCapacity;
+    magazine.Stale[index] = { handle.Offset, handle.PageIndex, fenceTag };
+    ++magazine.NumStale;
+
+    magazine.PublishStats();
 }
 
-void DescriptorAllocator::ReleaseStaleDescriptors( uint64_t frameNumber )
+void DescriptorAllocator::ReleaseStaleDescriptors( const FenceTag& completedFenceValues )
 {
+    for ( uint32_t i = 0; i < FenceTag::NumQueues; ++i )
+    {
+        m_CompletedFenceValues[i].store( completedFenceValues.FenceValues[i], std::memory_order_release );
+    }
+
+    // Return the descriptors of magazines whose thread has exited.
+    {
+        std::lock_guard lock( m_MagazineMutex );
+
+        for ( auto iter = m_Magazines.begin(); iter != m_Magazines.end(); )
+        {
+            if ( ( *iter )->IsOrphaned )
+            {
+                m_NumOrphanedAllocations += ( *iter )->NumAllocations.load( std::memory_order_relaxed );
+                FlushMagazine( **iter );
+                iter = m_Magazines.erase( iter );
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
     std::lock_guard<std::mutex> lock( m_AllocationMutex );
 
-    for ( size_t i = 0; i < m_HeapPool.size(); ++i )
+    ReleaseRetiredPages( completedFenceValues );
+
+    // Only visit the pages that have stale descriptors. The bits are cleared
+    // before the pages are visited, so a descriptor that is freed concurrently
+    // sets the bit of its page again.
+    for ( uint32_t word = 0; word < MaxPages / 64; ++word )
     {
-        auto page = m_HeapPool[i];
+        uint64_t stalePages = m_StalePages[word].exchange( 0, std::memory_order_acquire );
+
+        while ( stalePages != 0 )
+        {
+            uint16_t pageIndex = static_cast<uint16_t>( word * 64 + std::countr_zero( stalePages ) );
+            stalePages &= stalePages - 1;
 
-        page->ReleaseStaleDescriptors( frameNumber );
+            auto& page = m_Pages[pageIndex];
 
-        if ( page->NumFreeHandles() > 0 )
+            // Skip destroyed pages and retired slab pages.
+            if ( !page || page->IsRetired() )
+            {
+                continue;
+            }
+
+            if ( page->ReleaseStaleDescriptors( completedFenceValues ) )
+            {
+                MarkStalePage( pageIndex );
+            }
+
+            if ( !page->IsSlab() )
+            {
+                UpdateAvailableHeap( pageIndex );
+            }
+        }
+    }
+}
+
+void DescriptorAllocator::TrimIdleMagazines()
+{
+    std::lock_guard lock( m_MagazineMutex );
+
+    for ( auto& magazine : m_Magazines )
+    {
+        // Skip magazines that are in use by their thread.
+        std::unique_lock magazineLock( *magazine, std::try_to_lock );
+        if ( !magazineLock.owns_lock() )
         {
-            m_AvailableHeaps.insert( i );
+            continue;
         }
+
+        uint64_t numAllocations = magazine->NumAllocations.load( std::memory_order_relaxed );
+        if ( numAllocations == magazine->LastNumAllocations )
+        {
+            // The thread did not allocate since the previous frame. Return the
+            // ready descriptors and the stale descriptors whose fence values have
+            // completed to the pages, so that other threads can allocate them.
+            PromoteStaleDescriptors( *magazine );
+            ReleaseReadyDescriptors( *magazine, magazine->NumReady );
+            magazine->PublishStats();
+        }
+
+        magazine->LastNumAllocations = numAllocations;
     }
+}
+
+void DescriptorAllocator::TrimIdlePages()
+{
+    TrimIdleMagazines();
+
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    for ( uint32_t i = 0; i < m_NumPages; ++i )
+    {
+        auto& page = m_Pages[i];
+        auto& pageInfo = m_PageInfos[i];
+        uint16_t pageIndex = static_cast<uint16_t>( i );
+
+        // Skip destroyed pages and retired slab pages.
+        if ( !page || page->IsRetired() )
+        {
+            continue;
+        }
+
+        if ( page->NumFreeHandles() < page->GetNumDescriptors() )
+        {
+            pageInfo.NumIdleFrames = 0;
+        }
+        else if ( ++pageInfo.NumIdleFrames >= m_MaxIdleFrames )
+        {
+            // The page has not been used for a while. Slab pages are scanned by
+            // other threads without a lock, so only the descriptor heap of a
+            // slab page is released.
+            if ( page->IsSlab() )
+            {
+                page->RetireSlab();
+            }
+            else
+            {
+                DestroyAllocatorPage( pageIndex, Application::Get().GetNextFenceTag() );
+            }
+
+            pageInfo.NumIdleFrames = 0;
+        }
+    }
+}
+
+DescriptorAllocatorStats DescriptorAllocator::GetStats()
+{
+    DescriptorAllocatorStats stats = {};
+    stats.HeapType = m_HeapType;
+
+    uint64_t numMagazineAllocations = 0;
+    {
+        std::lock_guard lock( m_MagazineMutex );
+
+        for ( auto& magazine : m_Magazines )
+        {
+            numMagazineAllocations += magazine->NumAllocations.load( std::memory_order_relaxed );
+            stats.NumMagazineDescriptors += magazine->NumCachedDescriptors.load( std::memory_order_relaxed );
+            stats.NumMagazineStaleDescriptors += magazine->NumCachedStaleDescriptors.load( std::memory_order_relaxed );
+        }
+
+        numMagazineAllocations += m_NumOrphanedAllocations;
+    }
+
+    std::lock_guard lock( m_AllocationMutex );
+
+    m_StatsClock.Tick();
+    double elapsedSeconds = m_StatsClock.GetDeltaSeconds();
+
+    stats.NumDescriptorsPerHeap = m_NumDescriptorsPerHeap;
+    stats.NumAllocations = numMagazineAllocations + m_NumRangeAllocations;
+    stats.AllocationRate = elapsedSeconds > 0.0 ? ( stats.NumAllocations - m_LastNumAllocations ) / elapsedSeconds : 0.0;
+    m_LastNumAllocations = stats.NumAllocations;
+
+    for ( uint32_t i = 0; i < m_NumPages; ++i )
+    {
+        auto& page = m_Pages[i];
+        auto& pageInfo = m_PageInfos[i];
+
+        if ( !page )
+        {
+            continue;
+        }
+
+        DescriptorPageStats pageStats = page->GetStats();
+        pageStats.PageIndex = i;
+        pageStats.AllocationRate = elapsedSeconds > 0.0 ? ( pageStats.NumAllocatedDescriptors - pageInfo.LastNumAllocatedDescriptors ) / elapsedSeconds : 0.0;
+        pageInfo.LastNumAllocatedDescriptors = pageStats.NumAllocatedDescriptors;
+
+        if ( !pageStats.IsRetired )
+        {
+            ++stats.NumPages;
+            stats.NumDescriptors += pageStats.NumDescriptors;
+            stats.NumFreeHandles += pageStats.NumFreeHandles;
+            stats.LargestFreeBlock = std::max( stats.LargestFreeBlock, pageStats.LargestFreeBlock );
+            stats.NumStaleDescriptors += pageStats.NumStaleDescriptors;
+
+            for ( uint32_t bucket = 0; bucket < NumFreeBlockHistogramBuckets; ++bucket )
+            {
+                stats.FreeBlockHistogram[bucket] += pageStats.FreeBlockHistogram[bucket];
+            }
+        }
+
+        stats.Pages.push_back( pageStats );
+    }
+
+    return stats;
 }
\ No newline at end of file
@@ -3,9 +3,46 @@
 #include <DescriptorAllocatorPage.h>
 #include <Application.h>
 
-DescriptorAllocatorPage::DescriptorAllocatorPage( D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors )
-    : m_HeapType( type )
+#include <bit>
+
+DescriptorAllocatorPage::DescriptorAllocatorPage( D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors, bool isSlab )
+    : m_FreeList( isSlab ? 0 : numDescriptors )
+    , m_NumStaleDescriptors( 0 )
+    , m_NumSlabWords( 0 )
+    , m_SlabHint( 0 )
+    , m_IsSlab( isSlab )
+    , m_NumAllocatedDescriptors( 0 )
+    , m_HeapType( type )
     , m_NumDescriptorsInHeap( numDescriptors )
+{
+    if ( m_IsSlab )
+    {
+        m_NumSlabWords = ( numDescriptors + 63 ) / 64;
+        m_SlabBitmap = std::make_unique<std::atomic<uint64_t>[]>( m_NumSlabWords );
+
+        ResetSlabBitmap();
+    }
+    else
+    {
+        m_SlotOffsets = std::make_unique<std::atomic<OffsetType>[]>( numDescriptors );
+        m_SlotSizes = std::make_unique<SizeType[]>( numDescriptors );
+        m_OffsetSlots = std::make_unique<OffsetType[]>( numDescriptors );
+        m_MovedBitmap = std::make_unique<uint64_t[]>( ( numDescriptors + 63 ) / 64 );
+
+        std::fill_n( m_OffsetSlots.get(), numDescriptors, InvalidOffset );
+
+        // Hand out the lowest slots first.
+        m_FreeSlots.reserve( numDescriptors );
+        for ( OffsetType slot = numDescriptors; slot-- > 0; )
+        {
+            m_FreeSlots.push_back( slot );
+        }
+    }
+
+    CreateDescriptorHeap();
+}
+
+void DescriptorAllocatorPage::CreateDescriptorHeap()
 {
     auto device = Application::Get().GetDevice();
 
@@ -17,10 +54,6 @@ DescriptorAllocatorPage::DescriptorAllocatorPage( D3D12_DESCRIPTOR_HEAP_TYPE typ
 
     m_BaseDescriptor = m_d3d12DescriptorHeap->GetCPUDescriptorHandleForHeapStart();
     m_DescriptorHandleIncrementSize = device->GetDescriptorHandleIncrementSize( m_HeapType );
-    m_NumFreeHandles = m_NumDescriptorsInHeap;
-
-    // Initialize the free lists
-    AddNewBlock( 0, m_NumFreeHandles );
 }
 
 D3D12_DESCRIPTOR_HEAP_TYPE DescriptorAllocatorPage::GetHeapType() const
@@ -28,161 +61,376 @@ D3D12_DESCRIPTOR_HEAP_TYPE DescriptorAllocatorPage::GetHeapType() const
     return m_HeapType;
 }
 
-uint32_t DescriptorAllocatorPage::NumFreeHandles() const
+bool DescriptorAllocatorPage::IsSlab() const
 {
-    return m_NumFreeHandles;
+    return m_IsSlab;
 }
 
-bool DescriptorAllocatorPage::HasSpace( uint32_t numDescriptors ) const
+bool DescriptorAllocatorPage::IsRetired() const
+{
+    return !m_d3d12DescriptorHeap;
+}
+
+uint32_t DescriptorAllocatorPage::GetNumDescriptors() const
 {
-    return m_FreeListBySize.lower_bound(numDescriptors) != m_FreeListBySize.end();
+    return m_NumDescriptorsInHeap;
 }
 
-void DescriptorAllocatorPage::AddNewBlock( uint32_t offset, uint32_t numDescriptors )
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorAllocatorPage::GetDescriptorHandle( OffsetType offset ) const
 {
-    auto offsetIt = m_FreeListByOffset.emplace( offset, numDescriptors );
-    auto sizeIt = m_FreeListBySize.emplace( numDescriptors, offsetIt.first );
-    offsetIt.first->second.FreeListBySizeIt = sizeIt;
+    return CD3DX12_CPU_DESCRIPTOR_HANDLE( m_BaseDescriptor, offset, m_DescriptorHandleIncrementSize );
 }
 
-DescriptorAllocation DescriptorAllocatorPage::Allocate( uint32_t numDescriptors )
+uint32_t DescriptorAllocatorPage::NumFreeHandles() const
 {
+    if ( m_IsSlab )
+    {
+        uint32_t numAllocated = 0;
+        for ( uint32_t i = 0; i < m_NumSlabWords; ++i )
+        {
+            numAllocated += std::popcount( m_SlabBitmap[i].load( std::memory_order_relaxed ) );
+        }
+
+        return m_NumSlabWords * 64 - numAllocated;
+    }
+
     std::lock_guard<std::mutex> lock( m_AllocationMutex );
 
-    // There are less than the requested number of descriptors left in the heap.
-    // Return a NULL descriptor and try another heap.
-    if ( numDescriptors > m_NumFreeHandles )
+    return m_FreeList.GetFreeSize();
+}
+
+uint32_t DescriptorAllocatorPage::GetLargestFreeBlock() const
+{
+    if ( m_IsSlab )
     {
-        return DescriptorAllocation();
+        return NumFreeHandles() > 0 ? 1 : 0;
     }
 
-    // Get the first block that is large enough to satisfy the request.
-    auto smallestBlockIt = m_FreeListBySize.lower_bound( numDescriptors );
-    if ( smallestBlockIt == m_FreeListBySize.end() )
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    return m_FreeList.GetLargestFreeBlock();
+}
+
+uint32_t DescriptorAllocatorPage::GetNumFragmentedDescriptors() const
+{
+    if ( m_IsSlab )
     {
-        // There was no free block that could satisfy the request.
-        return DescriptorAllocation();
+        // Slab pages only allocate single descriptors and are never compacted.
+        return 0;
     }
 
-    // The size of the smallest block that satisfies the request.
-    auto blockSize = smallestBlockIt->first;
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
 
-    // The pointer to the same entry in the FreeListByOffset map.
-    auto offsetIt = smallestBlockIt->second;
+    return m_FreeList.GetFreeSize() - m_FreeList.GetLargestFreeBlock();
+}
 
-    // The offset in the descriptor heap.
-    auto offset = offsetIt->first;
+bool DescriptorAllocatorPage::HasSpace( uint32_t numDescriptors ) const
+{
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
 
-    // Remove the existing free block from the free list.
-    m_FreeListBySize.erase( smallestBlockIt );
-    m_FreeListByOffset.erase( offsetIt );
+    return m_FreeList.HasSpace( numDescriptors );
+}
 
-    // Compute the new free block that results from splitting this block.
-    auto newOffset = offset + numDescriptors;
-    auto newSize = blockSize - numDescriptors;
+DescriptorAllocatorPage::OffsetType DescriptorAllocatorPage::Allocate( uint32_t numDescriptors )
+{
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
 
-    if ( newSize > 0 )
+    // Get the first block that is large enough to satisfy the request.
+    // If there was no free block that could satisfy the request,
+    // InvalidOffset is returned and the allocator tries another heap.
+    auto offset = m_FreeList.Allocate( numDescriptors );
+    if ( offset == InvalidOffset )
     {
-        // If the allocation didn't exactly match the requested size,
-        // return the left-over to the free list.
-        AddNewBlock( newOffset, newSize );
+        return InvalidOffset;
     }
 
-    // Decrement free handles.
-    m_NumFreeHandles -= numDescriptors;
+    m_NumAllocatedDescriptors.fetch_add( numDescriptors, std::memory_order_relaxed );
+
+    // There is at least one free descriptor per slot.
+    OffsetType slot = m_FreeSlots.back();
+    m_FreeSlots.pop_back();
+
+    m_SlotOffsets[slot].store( offset, std::memory_order_release );
+    m_SlotSizes[slot] = numDescriptors;
+    m_OffsetSlots[offset] = slot;
+
+    return slot;
+}
 
-    return DescriptorAllocation(
-        CD3DX12_CPU_DESCRIPTOR_HANDLE( m_BaseDescriptor, offset, m_DescriptorHandleIncrementSize ),
-        numDescriptors, m_DescriptorHandleIncrementSize, shared_from_this() );
+DescriptorAllocatorPage::OffsetType DescriptorAllocatorPage::GetSlotOffset( OffsetType slot ) const
+{
+    return m_SlotOffsets[slot].load( std::memory_order_acquire );
 }
 
-uint32_t DescriptorAllocatorPage::ComputeOffset( D3D12_CPU_DESCRIPTOR_HANDLE handle )
+void DescriptorAllocatorPage::FreeSlot( OffsetType slot, const FenceTag& fenceTag )
 {
-    return static_cast<uint32_t>( handle.ptr - m_BaseDescriptor.ptr ) / m_DescriptorHandleIncrementSize;
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    OffsetType offset = m_SlotOffsets[slot].load( std::memory_order_relaxed );
+    SizeType numDescriptors = m_SlotSizes[slot];
+
+    m_OffsetSlots[offset] = InvalidOffset;
+    m_FreeSlots.push_back( slot );
+
+    // Don't add the block directly to the free list until the GPU is done with it.
+    m_StaleDescriptors.emplace( offset, numDescriptors, fenceTag );
+    m_NumStaleDescriptors += numDescriptors;
 }
 
-void DescriptorAllocatorPage::Free( DescriptorAllocation&& descriptor, uint64_t frameNumber )
+uint32_t DescriptorAllocatorPage::Compact( uint32_t maxDescriptorsToMove, const FenceTag& fenceTag )
 {
-    // Compute the offset of the descriptor within the descriptor heap.
-    auto offset = ComputeOffset( descriptor.GetDescriptorHandle() );
+    assert( !m_IsSlab );
+
+    auto device = Application::Get().GetDevice();
+
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    uint32_t numMovedDescriptors = 0;
+
+    // The offsets that ranges were moved to in this pass. These ranges are
+    // not moved again in the same pass.
+    std::fill_n( m_MovedBitmap.get(), ( m_NumDescriptorsInHeap + 63 ) / 64, 0 );
+
+    // Move the ranges with the highest offsets first so that the free
+    // descriptors gather at the end of the page.
+    for ( OffsetType offset = m_NumDescriptorsInHeap; offset-- > 0; )
+    {
+        OffsetType slot = m_OffsetSlots[offset];
+        if ( slot == InvalidOffset || ( m_MovedBitmap[offset / 64] & ( 1ull << ( offset % 64 ) ) ) )
+        {
+            continue;
+        }
+
+        SizeType numDescriptors = m_SlotSizes[slot];
+        if ( numMovedDescriptors + numDescriptors > maxDescriptorsToMove )
+        {
+            break;
+        }
+
+        // Only move the range if a free block is found at a lower offset.
+        // The old and new location can't overlap since the old location
+        // is still allocated.
+        OffsetType newOffset = m_FreeList.Allocate( numDescriptors );
+        if ( newOffset == InvalidOffset )
+        {
+            continue;
+        }
+        if ( newOffset > offset )
+        {
+            m_FreeList.Free( newOffset, numDescriptors );
+            continue;
+        }
+
+        device->CopyDescriptorsSimple( numDescriptors, GetDescriptorHandle( newOffset ), GetDescriptorHandle( offset ), m_HeapType );
+
+        // Publish the new offset to the owner of the range. Threads that have
+        // read the old offset can still use the descriptors until the stale
+        // descriptors are released.
+        m_SlotOffsets[slot].store( newOffset, std::memory_order_release );
+        m_OffsetSlots[newOffset] = slot;
+        m_OffsetSlots[offset] = InvalidOffset;
+        m_MovedBitmap[newOffset / 64] |= 1ull << ( newOffset % 64 );
+
+        m_StaleDescriptors.emplace( offset, numDescriptors, fenceTag );
+        m_NumStaleDescriptors += numDescriptors;
+
+        numMovedDescriptors += numDescriptors;
+    }
+
+    return numMovedDescriptors;
+}
 
+uint32_t DescriptorAllocatorPage::AllocateSingleDescriptors( uint32_t numDescriptors, OffsetType* offsets )
+{
     std::lock_guard<std::mutex> lock( m_AllocationMutex );
 
-    // Don't add the block directly to the free list until the frame has completed.
-    m_StaleDescriptors.emplace( offset, descriptor.GetNumHandles(), frameNumber );
+    uint32_t numAllocated = 0;
+    while ( numAllocated < numDescriptors )
+    {
+        auto offset = m_FreeList.Allocate( 1 );
+        if ( offset == TLSFAllocator::InvalidOffset )
+        {
+            break;
+        }
+
+        offsets[numAllocated++] = offset;
+    }
+
+    m_NumAllocatedDescriptors.fetch_add( numAllocated, std::memory_order_relaxed );
+
+    return numAllocated;
 }
 
-void DescriptorAllocatorPage::FreeBlock( uint32_t offset, uint32_t numDescriptors )
+uint32_t DescriptorAllocatorPage::AllocateSlabDescriptors( uint32_t numDescriptors, OffsetType* offsets )
 {
-    // Find the first element whose offset is greater than the specified offset.
-    // This is the block that should appear after the block that is being freed.
-    auto nextBlockIt = m_FreeListByOffset.upper_bound( offset );
+    assert( m_IsSlab );
 
-    // Find the block that appears before the block being freed.
-    auto prevBlockIt = nextBlockIt;
-    // If it's not the first block in the list.
-    if ( prevBlockIt != m_FreeListByOffset.begin() )
+    uint32_t numAllocated = 0;
+    uint32_t startWord = m_SlabHint.load( std::memory_order_relaxed );
+
+    for ( uint32_t i = 0; i < m_NumSlabWords && numAllocated < numDescriptors; ++i )
     {
-        // Go to the previous block in the list.
-        --prevBlockIt;
+        uint32_t wordIndex = ( startWord + i ) % m_NumSlabWords;
+        auto& word = m_SlabBitmap[wordIndex];
+
+        uint64_t freeBits = ~word.load( std::memory_order_relaxed );
+        while ( freeBits != 0 && numAllocated < numDescriptors )
+        {
+            // Claim as many of the free descriptors in the word as needed with
+            // a single atomic operation.
+            uint64_t claimBits = freeBits;
+            for ( uint32_t n = std::popcount( claimBits ); n > numDescriptors - numAllocated; --n )
+            {
+                // Drop the highest bit.
+                claimBits &= ~( 1ull << ( 63 - std::countl_zero( claimBits ) ) );
+            }
+
+            uint64_t previousBits = word.fetch_or( claimBits, std::memory_order_acquire );
+
+            // Another thread may have claimed some of the bits in the meantime.
+            uint64_t claimedBits = claimBits & ~previousBits;
+            while ( claimedBits != 0 )
+            {
+                offsets[numAllocated++] = wordIndex * 64 + std::countr_zero( claimedBits );
+
+                claimedBits &= claimedBits - 1;
+            }
+
+            freeBits = ~( previousBits | claimBits );
+        }
+
+        if ( numAllocated > 0 )
+        {
+            m_SlabHint.store( wordIndex, std::memory_order_relaxed );
+        }
     }
-    else
+
+    if ( numAllocated > 0 )
+    {
+        m_NumAllocatedDescriptors.fetch_add( numAllocated, std::memory_order_relaxed );
+    }
+
+    return numAllocated;
+}
+
+DescriptorPageStats DescriptorAllocatorPage::GetStats() const
+{
+    DescriptorPageStats stats = {};
+    stats.IsSlab = m_IsSlab;
+    stats.IsRetired = IsRetired();
+    stats.NumDescriptors = m_NumDescriptorsInHeap;
+    stats.NumAllocatedDescriptors = m_NumAllocatedDescriptors.load( std::memory_order_relaxed );
+
+    if ( m_IsSlab )
     {
-        // Otherwise, just set it to the end of the list to indicate that no
-        // block comes before the one being freed.
-        prevBlockIt = m_FreeListByOffset.end();
+        // Every free descriptor in a slab page is a block of a single descriptor.
+        stats.NumFreeHandles = stats.IsRetired ? 0 : NumFreeHandles();
+        stats.LargestFreeBlock = stats.NumFreeHandles > 0 ? 1 : 0;
+        stats.FreeBlockHistogram[0] = stats.NumFreeHandles;
     }
 
-    // Add the number of free handles back to the heap.
-    // This needs to be done before merging any blocks since merging
-    // blocks modifies the numDescriptors variable.
-    m_NumFreeHandles += numDescriptors;
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
 
-    if ( prevBlockIt != m_FreeListByOffset.end() &&
-         offset == prevBlockIt->first + prevBlockIt->second.Size )
+    if ( !m_IsSlab )
     {
-        // The previous block is exactly behind the block that is to be freed.
-        //
-        // PrevBlock.Offset           Offset
-        // |                          |
-        // |<-----PrevBlock.Size----->|<------Size-------->|
-        //
+        stats.NumFreeHandles = m_FreeList.GetFreeSize();
+        stats.LargestFreeBlock = m_FreeList.GetLargestFreeBlock();
+        m_FreeList.GetFreeBlockHistogram( stats.FreeBlockHistogram, NumFreeBlockHistogramBuckets );
+    }
 
-        // Increase the block size by the size of merging with the previous block.
-        offset = prevBlockIt->first;
-        numDescriptors += prevBlockIt->second.Size;
+    stats.StaleQueueDepth = static_cast<uint32_t>( m_StaleDescriptors.size() );
+    stats.NumStaleDescriptors = m_NumStaleDescriptors;
 
-        // Remove the previous block from the free list.
-        m_FreeListBySize.erase( prevBlockIt->second.FreeListBySizeIt );
-        m_FreeListByOffset.erase( prevBlockIt );
+    return stats;
+}
+
+void DescriptorAllocatorPage::ResetSlabBitmap()
+{
+    for ( uint32_t i = 0; i < m_NumSlabWords; ++i )
+    {
+        m_SlabBitmap[i].store( 0, std::memory_order_release );
+    }
+
+    // Descriptors past the end of the heap are marked as allocated.
+    if ( m_NumDescriptorsInHeap % 64 != 0 )
+    {
+        m_SlabBitmap[m_NumSlabWords - 1].store( ~0ull << ( m_NumDescriptorsInHeap % 64 ), std::memory_order_release );
     }
+}
+
+bool DescriptorAllocatorPage::RetireSlab()
+{
+    assert( m_IsSlab && !IsRetired() );
+
+    uint64_t paddingBits = m_NumDescriptorsInHeap % 64 != 0 ? ~0ull << ( m_NumDescriptorsInHeap % 64 ) : 0;
 
-    if ( nextBlockIt != m_FreeListByOffset.end() &&
-         offset + numDescriptors == nextBlockIt->first )
+    // Claim all of the descriptors in the page. This fails if another thread
+    // has allocated a descriptor in the meantime.
+    for ( uint32_t i = 0; i < m_NumSlabWords; ++i )
     {
-        // The next block is exactly in front of the block that is to be freed.
-        //
-        // Offset               NextBlock.Offset 
-        // |                    |
-        // |<------Size-------->|<-----NextBlock.Size----->|
+        uint64_t expectedBits = i == m_NumSlabWords - 1 ? paddingBits : 0;
+        if ( !m_SlabBitmap[i].compare_exchange_strong( expectedBits, ~0ull, std::memory_order_acquire ) )
+        {
+            // Give back the words that were already claimed.
+            for ( uint32_t j = 0; j < i; ++j )
+            {
+                m_SlabBitmap[j].store( 0, std::memory_order_release );
+            }
+
+            return false;
+        }
+    }
+
+    m_d3d12DescriptorHeap.Reset();
+
+    return true;
+}
+
+void DescriptorAllocatorPage::ReviveSlab()
+{
+    assert( m_IsSlab && IsRetired() );
+
+    CreateDescriptorHeap();
+
+    // Publish the new descriptor heap to the threads that allocate from the page.
+    ResetSlabBitmap();
+}
+
+void DescriptorAllocatorPage::FreeSlabDescriptor( OffsetType offset )
+{
+    uint64_t bit = 1ull << ( offset % 64 );
+
+    assert( m_SlabBitmap[offset / 64].load( std::memory_order_relaxed ) & bit );
+    m_SlabBitmap[offset / 64].fetch_and( ~bit, std::memory_order_release );
+}
 
-        // Increase the block size by the size of merging with the next block.
-        numDescriptors += nextBlockIt->second.Size;
+void DescriptorAllocatorPage::Free( OffsetType offset, uint32_t numDescriptors, const FenceTag& fenceTag )
+{
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    // Don't add the block directly to the free list until the GPU is done with it.
+    m_StaleDescriptors.emplace( offset, numDescriptors, fenceTag );
+    m_NumStaleDescriptors += numDescriptors;
+}
 
-        // Remove the next block from the free list.
-        m_FreeListBySize.erase( nextBlockIt->second.FreeListBySizeIt );
-        m_FreeListByOffset.erase( nextBlockIt );
+void DescriptorAllocatorPage::ReleaseDescriptor( OffsetType offset )
+{
+    if ( m_IsSlab )
+    {
+        FreeSlabDescriptor( offset );
+        return;
     }
 
-    // Add the freed block to the free list.
-    AddNewBlock( offset, numDescriptors );
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    m_FreeList.Free( offset, 1 );
 }
 
-void DescriptorAllocatorPage::ReleaseStaleDescriptors( uint64_t frameNumber )
+bool DescriptorAllocatorPage::ReleaseStaleDescriptors( const FenceTag& completedFenceValues )
 {
     std::lock_guard<std::mutex> lock( m_AllocationMutex );
 
-    while ( !m_StaleDescriptors.empty() && m_StaleDescriptors.front().FrameNumber <= frameNumber )
+    while ( !m_StaleDescriptors.empty() && m_StaleDescriptors.front().Fence.IsComplete( completedFenceValues ) )
     {
         auto& staleDescriptor = m_StaleDescriptors.front();
 
@@ -191,8 +439,20 @@ void DescriptorAllocatorPage::ReleaseStaleDescriptors( uint64_t frameNumber )
         // The number of descriptors that were allocated.
         auto numDescriptors = staleDescriptor.Size;
 
-        FreeBlock( offset, numDescriptors );
-
+        if ( m_IsSlab )
+        {
+            FreeSlabDescriptor( offset );
+        }
+        else
+        {
+            // Return the block to the free list. This will also merge free blocks
+            // to form larger blocks that can be reused.
+            m_FreeList.Free( offset, numDescriptors );
+        }
+
+        m_NumStaleDescriptors -= numDescriptors;
         m_StaleDescriptors.pop();
     }
-}
\ No newline at end of file
+
+    return !m_StaleDescriptors.empty();
+}
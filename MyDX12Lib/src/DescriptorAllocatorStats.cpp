@@ -0,0 +1,79 @@
+#include <DX12LibPCH.h>
+
+#include <DescriptorAllocatorStats.h>
+
+#include <sstream>
+
+static const char* GetHeapTypeName( D3D12_DESCRIPTOR_HEAP_TYPE type )
+{
+    switch ( type )
+    {
+        case D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV:
+            return "CBV_SRV_UAV";
+        case D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER:
+            return "SAMPLER";
+        case D3D12_DESCRIPTOR_HEAP_TYPE_RTV:
+            return "RTV";
+        case D3D12_DESCRIPTOR_HEAP_TYPE_DSV:
+            return "DSV";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+static void WriteHistogram( std::ostream& stream, const uint32_t ( &histogram )[NumFreeBlockHistogramBuckets] )
+{
+    stream << "[";
+    for ( uint32_t i = 0; i < NumFreeBlockHistogramBuckets; ++i )
+    {
+        stream << ( i > 0 ? ", " : "" ) << histogram[i];
+    }
+    stream << "]";
+}
+
+std::string DescriptorAllocatorStats::ToJSON() const
+{
+    std::ostringstream stream;
+
+    stream << "{\n"
+           << "  \"HeapType\": \"" << GetHeapTypeName( HeapType ) << "\",\n"
+           << "  \"NumDescriptorsPerHeap\": " << NumDescriptorsPerHeap << ",\n"
+           << "  \"NumPages\": " << NumPages << ",\n"
+           << "  \"NumDescriptors\": " << NumDescriptors << ",\n"
+           << "  \"NumFreeHandles\": " << NumFreeHandles << ",\n"
+           << "  \"LargestFreeBlock\": " << LargestFreeBlock << ",\n"
+           << "  \"FreeBlockHistogram\": ";
+    WriteHistogram( stream, FreeBlockHistogram );
+    stream << ",\n"
+           << "  \"NumStaleDescriptors\": " << NumStaleDescriptors << ",\n"
+           << "  \"NumMagazineDescriptors\": " << NumMagazineDescriptors << ",\n"
+           << "  \"NumMagazineStaleDescriptors\": " << NumMagazineStaleDescriptors << ",\n"
+           << "  \"NumAllocations\": " << NumAllocations << ",\n"
+           << "  \"AllocationRate\": " << AllocationRate << ",\n"
+           << "  \"Pages\": [";
+
+    for ( size_t i = 0; i < Pages.size(); ++i )
+    {
+        const DescriptorPageStats& page = Pages[i];
+
+        stream << ( i > 0 ? "," : "" ) << "\n    {\n"
+               << "      \"PageIndex\": " << page.PageIndex << ",\n"
+               << "      \"IsSlab\": " << ( page.IsSlab ? "true" : "false" ) << ",\n"
+               << "      \"IsRetired\": " << ( page.IsRetired ? "true" : "false" ) << ",\n"
+               << "      \"NumDescriptors\": " << page.NumDescriptors << ",\n"
+               << "      \"NumFreeHandles\": " << page.NumFreeHandles << ",\n"
+               << "      \"LargestFreeBlock\": " << page.LargestFreeBlock << ",\n"
+               << "      \"FreeBlockHistogram\": ";
+        WriteHistogram( stream, page.FreeBlockHistogram );
+        stream << ",\n"
+               << "      \"StaleQueueDepth\": " << page.StaleQueueDepth << ",\n"
+               << "      \"NumStaleDescriptors\": " << page.NumStaleDescriptors << ",\n"
+               << "      \"NumAllocatedDescriptors\": " << page.NumAllocatedDescriptors << ",\n"
+               << "      \"AllocationRate\": " << page.AllocationRate << "\n"
+               << "    }";
+    }
+
+    stream << ( Pages.empty() ? "]\n" : "\n  ]\n" ) << "}";
+
+    return stream.str();
+}
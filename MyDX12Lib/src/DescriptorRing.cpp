@@ -0,0 +1,124 @@
+#include <DX12LibPCH.h>
+
+#include <DescriptorRing.h>
+
+#include <Application.h>
+
+DescriptorRing::DescriptorRing( D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerHeap, uint32_t numReservedDescriptors )
+    : m_HeapType( type )
+    , m_NumChunksPerHeap( std::max( numDescriptorsPerHeap / NumDescriptorsPerChunk, 1u ) )
+    , m_NumReservedDescriptors( numReservedDescriptors )
+{
+    auto& application = Application::Get();
+
+    m_DescriptorHandleIncrementSize = application.GetDescriptorHandleIncrementSize( m_HeapType );
+
+    if ( m_NumReservedDescriptors > 0 )
+    {
+        m_ReservedDescriptorHeap = application.CreateDescriptorHeap( m_NumReservedDescriptors, m_HeapType );
+        m_BaseReservedDescriptor = m_ReservedDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    }
+
+    CreateDescriptorHeap();
+}
+
+void DescriptorRing::CreateDescriptorHeap()
+{
+    auto device = Application::Get().GetDevice();
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.Type = m_HeapType;
+    heapDesc.NumDescriptors = m_NumReservedDescriptors + m_NumChunksPerHeap * NumDescriptorsPerChunk;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+    ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+    ThrowIfFailed( device->CreateDescriptorHeap( &heapDesc, IID_PPV_ARGS( &descriptorHeap ) ) );
+
+    // The new descriptor heap starts with the reserved descriptors that were
+    // committed to the other descriptor heaps.
+    if ( m_NumReservedDescriptors > 0 )
+    {
+        device->CopyDescriptorsSimple( m_NumReservedDescriptors, descriptorHeap->GetCPUDescriptorHandleForHeapStart(), m_BaseReservedDescriptor, m_HeapType );
+    }
+
+    uint32_t firstChunk = static_cast<uint32_t>( m_DescriptorHeaps.size() ) * m_NumChunksPerHeap;
+    m_DescriptorHeaps.push_back( descriptorHeap );
+
+    for ( uint32_t i = 0; i < m_NumChunksPerHeap; ++i )
+    {
+        m_AvailableChunks.push( firstChunk + i );
+    }
+}
+
+uint32_t DescriptorRing::GetNumDescriptorHeaps() const
+{
+    std::lock_guard<std::mutex> lock( m_ChunkMutex );
+
+    return static_cast<uint32_t>( m_DescriptorHeaps.size() );
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorRing::GetReservedCPUDescriptorHandle( uint32_t index ) const
+{
+    assert( index < m_NumReservedDescriptors );
+
+    return CD3DX12_CPU_DESCRIPTOR_HANDLE( m_BaseReservedDescriptor, index, m_DescriptorHandleIncrementSize );
+}
+
+void DescriptorRing::CommitReservedDescriptors( uint32_t index, uint32_t numDescriptors )
+{
+    assert( index + numDescriptors <= m_NumReservedDescriptors );
+
+    auto device = Application::Get().GetDevice();
+
+    std::lock_guard<std::mutex> lock( m_ChunkMutex );
+
+    for ( auto& descriptorHeap : m_DescriptorHeaps )
+    {
+        CD3DX12_CPU_DESCRIPTOR_HANDLE destDescriptor( descriptorHeap->GetCPUDescriptorHandleForHeapStart(), index, m_DescriptorHandleIncrementSize );
+        device->CopyDescriptorsSimple( numDescriptors, destDescriptor, GetReservedCPUDescriptorHandle( index ), m_HeapType );
+    }
+}
+
+DescriptorRing::Chunk DescriptorRing::AllocateChunk()
+{
+    std::lock_guard<std::mutex> lock( m_ChunkMutex );
+
+    if ( m_AvailableChunks.empty() )
+    {
+        // All of the chunks are still in use by the GPU (or by command lists
+        // that are being recorded).
+        CreateDescriptorHeap();
+    }
+
+    uint32_t chunkIndex = m_AvailableChunks.front();
+    m_AvailableChunks.pop();
+
+    ID3D12DescriptorHeap* descriptorHeap = m_DescriptorHeaps[chunkIndex / m_NumChunksPerHeap].Get();
+    uint32_t offset = m_NumReservedDescriptors + ( chunkIndex % m_NumChunksPerHeap ) * NumDescriptorsPerChunk;
+
+    Chunk chunk;
+    chunk.Index = chunkIndex;
+    chunk.DescriptorHeap = descriptorHeap;
+    chunk.BaseCPUDescriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE( descriptorHeap->GetCPUDescriptorHandleForHeapStart(), offset, m_DescriptorHandleIncrementSize );
+    chunk.BaseGPUDescriptor = CD3DX12_GPU_DESCRIPTOR_HANDLE( descriptorHeap->GetGPUDescriptorHandleForHeapStart(), offset, m_DescriptorHandleIncrementSize );
+
+    return chunk;
+}
+
+void DescriptorRing::FreeChunk( uint32_t chunkIndex, const FenceTag& fenceTag )
+{
+    std::lock_guard<std::mutex> lock( m_ChunkMutex );
+
+    m_StaleChunks.emplace( chunkIndex, fenceTag );
+}
+
+void DescriptorRing::ReleaseStaleDescriptors( const FenceTag& completedFenceValues )
+{
+    std::lock_guard<std::mutex> lock( m_ChunkMutex );
+
+    while ( !m_StaleChunks.empty() && m_StaleChunks.front().Fence.IsComplete( completedFenceValues ) )
+    {
+        m_AvailableChunks.push( m_StaleChunks.front().ChunkIndex );
+        m_StaleChunks.pop();
+    }
+}
\ No newline at end of file
@@ -4,67 +4,108 @@
 
 #include <Application.h>
 #include <CommandList.h>
+#include <DescriptorAllocator.h>
+#include <DescriptorRing.h>
 #include <RootSignature.h>
 
-DynamicDescriptorHeap::DynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE heapType, uint32_t numDescriptorsPerHeap)
+namespace
+{
+    // Sets the descriptor tables for draws.
+    struct GraphicsPipeline
+    {
+        static const uint32_t Index = 0;
+
+        static void SetRootDescriptorTable(ID3D12GraphicsCommandList* commandList, UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+        {
+            commandList->SetGraphicsRootDescriptorTable(rootIndex, baseDescriptor);
+        }
+    };
+
+    // Sets the descriptor tables for dispatches.
+    struct ComputePipeline
+    {
+        static const uint32_t Index = 1;
+
+        static void SetRootDescriptorTable(ID3D12GraphicsCommandList* commandList, UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+        {
+            commandList->SetComputeRootDescriptorTable(rootIndex, baseDescriptor);
+        }
+    };
+
+    // The layout that is used until a root signature is set.
+    const RootSignature::DescriptorTableLayout gs_EmptyDescriptorTableLayout = {};
+}
+
+DynamicDescriptorHeap::DynamicDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE heapType)
     : m_DescriptorHeapType(heapType)
-    , m_NumDescriptorsPerHeap(numDescriptorsPerHeap)
-    , m_DescriptorTableBitMask(0)
+    , m_NumDescriptorsPerChunk(DescriptorRing::NumDescriptorsPerChunk)
+    , m_DescriptorTableLayout(&gs_EmptyDescriptorTableLayout)
     , m_StaleDescriptorTableBitMask(0)
+    , m_CurrentDescriptorHeap(nullptr)
     , m_CurrentCPUDescriptorHandle(D3D12_DEFAULT)
     , m_CurrentGPUDescriptorHandle(D3D12_DEFAULT)
+    , m_BaseCPUDescriptorHandle(D3D12_DEFAULT)
+    , m_BaseGPUDescriptorHandle(D3D12_DEFAULT)
     , m_NumFreeHandles(0)
+    , m_NumPersistentDescriptors(0)
+    , m_FreeGeneration(DescriptorAllocator::GetFreeGeneration(heapType))
+    , m_NumCopyDestDescriptorRanges(0)
+    , m_NumCopySrcDescriptors(0)
 {
     m_DescriptorHandleIncrementSize = Application::Get().GetDescriptorHandleIncrementSize(heapType);
 
     // Allocate space for staging CPU visible descriptors.
-    m_DescriptorHandleCache = std::make_unique<D3D12_CPU_DESCRIPTOR_HANDLE[]>(m_NumDescriptorsPerHeap);
+    m_DescriptorHandleCache = std::make_unique<D3D12_CPU_DESCRIPTOR_HANDLE[]>(m_NumDescriptorsPerChunk);
+    m_CopiedDescriptorHandleCache = std::make_unique<D3D12_CPU_DESCRIPTOR_HANDLE[]>(m_NumDescriptorsPerChunk);
+    m_CopySrcDescriptorHandles = std::make_unique<D3D12_CPU_DESCRIPTOR_HANDLE[]>(m_NumDescriptorsPerChunk);
+
+    ResetCommittedDescriptorTables();
+
+    for (auto& bindlessRootParameterIndex : m_BindlessRootParameterIndices)
+    {
+        bindlessRootParameterIndex = InvalidOffset;
+    }
 }
 
 DynamicDescriptorHeap::~DynamicDescriptorHeap()
-{}
+{
+    FreeDescriptorChunks();
+}
 
-void DynamicDescriptorHeap::ParseRootSignature(const RootSignature& rootSignature)
+void DynamicDescriptorHeap::SetRootSignature(const RootSignature& rootSignature)
 {
     // If the root signature changes, all descriptors must be (re)bound to the
     // command list.
     m_StaleDescriptorTableBitMask = 0;
 
-    const auto& rootSignatureDesc = rootSignature.GetRootSignatureDesc();
-
-    // Get a bit mask that represents the root parameter indices that match the 
-    // descriptor heap type for this dynamic descriptor heap.
-    m_DescriptorTableBitMask = rootSignature.GetDescriptorTableBitMask(m_DescriptorHeapType);
-    uint32_t descriptorTableBitMask = m_DescriptorTableBitMask;
-
-    uint32_t currentOffset = 0;
-    DWORD rootIndex;
-    while (_BitScanForward(&rootIndex, descriptorTableBitMask) && rootIndex < rootSignatureDesc.NumParameters)
+    // The bindless descriptor tables must be set again for the new root signature.
+    for (auto& bindlessRootParameterIndex : m_BindlessRootParameterIndices)
     {
-        uint32_t numDescriptors = rootSignature.GetNumDescriptors(rootIndex);
-
-        DescriptorTableCache& descriptorTableCache = m_DescriptorTableCache[rootIndex];
-        descriptorTableCache.NumDescriptors = numDescriptors;
-        descriptorTableCache.BaseDescriptor = m_DescriptorHandleCache.get() + currentOffset;
+        bindlessRootParameterIndex = InvalidOffset;
+    }
 
-        currentOffset += numDescriptors;
+    // The layout of the descriptor tables that match the descriptor heap type
+    // for this dynamic descriptor heap.
+    m_DescriptorTableLayout = &rootSignature.GetDescriptorTableLayout(m_DescriptorHeapType);
 
-        // Flip the descriptor table bit so it's not scanned again for the current index.
-        descriptorTableBitMask ^= (1 << rootIndex);
-    }
+    // Make sure the maximum number of descriptors per chunk has not been exceeded.
+    assert(m_DescriptorTableLayout->NumDescriptors <= m_NumDescriptorsPerChunk && "The root signature requires more than the maximum number of descriptors per chunk. Consider increasing DescriptorRing::NumDescriptorsPerChunk.");
+}
 
-    // Make sure the maximum number of descriptors per descriptor heap has not been exceeded.
-    assert(currentOffset <= m_NumDescriptorsPerHeap && "The root signature requires more than the maximum number of descriptors per descriptor heap. Consider increasing the maximum number of descriptors per descriptor heap.");
+DynamicDescriptorHeap::DescriptorTableCache DynamicDescriptorHeap::GetDescriptorTableCache(uint32_t rootIndex) const
+{
+    return { m_DescriptorTableLayout->NumDescriptorsPerTable[rootIndex],
+             m_DescriptorHandleCache.get() + m_DescriptorTableLayout->DescriptorTableOffsets[rootIndex] };
 }
 
 void DynamicDescriptorHeap::StageDescriptors(uint32_t rootParameterIndex, uint32_t offset, uint32_t numDescriptors, const D3D12_CPU_DESCRIPTOR_HANDLE srcDescriptor)
 {
-    // Cannot stage more than the maximum number of descriptors per heap.
+    // Cannot stage more than the maximum number of descriptors per chunk.
     // Cannot stage more than MaxDescriptorTables root parameters.
-    if (numDescriptors > m_NumDescriptorsPerHeap || rootParameterIndex >= MaxDescriptorTables )
+    if (numDescriptors > m_NumDescriptorsPerChunk || rootParameterIndex >= MaxDescriptorTables )
         throw std::bad_alloc();
 
-    DescriptorTableCache& descriptorTableCache = m_DescriptorTableCache[rootParameterIndex];
+    DescriptorTableCache descriptorTableCache = GetDescriptorTableCache(rootParameterIndex);
 
     // Check that the number of descriptors to copy does not exceed the number
     // of descriptors expected in the descriptor table.
@@ -88,93 +129,284 @@ uint32_t DynamicDescriptorHeap::ComputeStaleDescriptorCount() const
 
     while ( _BitScanForward( &i, staleDescriptorsBitMask ) )
     {
-        numStaleDescriptors += m_DescriptorTableCache[i].NumDescriptors;
+        numStaleDescriptors += m_DescriptorTableLayout->NumDescriptorsPerTable[i];
         staleDescriptorsBitMask ^= ( 1 << i );
     }
 
     return numStaleDescriptors;
 }
 
-ComPtr<ID3D12DescriptorHeap> DynamicDescriptorHeap::RequestDescriptorHeap()
+std::size_t DynamicDescriptorHeap::HashDescriptorTable(const DescriptorTableCache& descriptorTableCache)
+{
+    std::size_t seed = descriptorTableCache.NumDescriptors;
+    for (uint32_t i = 0; i < descriptorTableCache.NumDescriptors; ++i)
+    {
+        std::hash_combine(seed, descriptorTableCache.BaseDescriptor[i].ptr);
+    }
+
+    return seed;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::FindPersistentDescriptorTable(std::size_t hash, const DescriptorTableCache& descriptorTableCache) const
+{
+    auto range = m_PersistentDescriptorTables.equal_range(hash);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+        const PersistentDescriptorTable& persistentDescriptorTable = iter->second;
+
+        if (persistentDescriptorTable.NumDescriptors == descriptorTableCache.NumDescriptors &&
+            memcmp(m_PersistentDescriptorHandleCache.data() + persistentDescriptorTable.HandleOffset, descriptorTableCache.BaseDescriptor,
+                   descriptorTableCache.NumDescriptors * sizeof(D3D12_CPU_DESCRIPTOR_HANDLE)) == 0)
+        {
+            return persistentDescriptorTable.BaseDescriptor;
+        }
+    }
+
+    return D3D12_GPU_DESCRIPTOR_HANDLE{ 0 };
+}
+
+void DynamicDescriptorHeap::ResetPersistentDescriptorTables()
+{
+    m_PersistentDescriptorTables.clear();
+    m_PersistentDescriptorHandleCache.clear();
+}
+
+bool DynamicDescriptorHeap::IsCopiedDescriptorTable(uint32_t offset, const DescriptorTableCache& descriptorTableCache) const
+{
+    uint32_t numDescriptors = descriptorTableCache.NumDescriptors;
+
+    return offset != InvalidOffset && offset + numDescriptors <= m_NumDescriptorsPerChunk &&
+        memcmp(m_CopiedDescriptorHandleCache.get() + offset, descriptorTableCache.BaseDescriptor,
+               numDescriptors * sizeof(D3D12_CPU_DESCRIPTOR_HANDLE)) == 0;
+}
+
+void DynamicDescriptorHeap::ResetCommittedDescriptorTables()
+{
+    for (auto& committedDescriptorTable : m_CommittedDescriptorTables)
+    {
+        committedDescriptorTable = { 0, InvalidOffset };
+    }
+}
+
+void DynamicDescriptorHeap::ValidateDescriptorTableCaches()
+{
+    uint64_t freeGeneration = DescriptorAllocator::GetFreeGeneration(m_DescriptorHeapType);
+    if (freeGeneration != m_FreeGeneration)
+    {
+        // A staged descriptor handle may now refer to a different view than
+        // the one that was copied to the heap. This also applies to the static
+        // tables, so they are copied to the persistent region again.
+        ResetCommittedDescriptorTables();
+        ResetPersistentDescriptorTables();
+        m_FreeGeneration = freeGeneration;
+    }
+}
+
+void DynamicDescriptorHeap::RequestDescriptorChunk(CommandList& commandList)
+{
+    // Tables that were already bound from the previous chunk stay valid as long
+    // as the descriptor heap doesn't change, so their queued copies are flushed.
+    FlushDescriptorCopies();
+
+    DescriptorRing::Chunk chunk = Application::Get().GetDescriptorRing(m_DescriptorHeapType).AllocateChunk();
+    m_DescriptorChunks.push_back(chunk.Index);
+
+    m_BaseCPUDescriptorHandle = chunk.BaseCPUDescriptor;
+    m_BaseGPUDescriptorHandle = chunk.BaseGPUDescriptor;
+    m_CurrentCPUDescriptorHandle = m_BaseCPUDescriptorHandle;
+    m_CurrentGPUDescriptorHandle = m_BaseGPUDescriptorHandle;
+    m_NumFreeHandles = m_NumDescriptorsPerChunk;
+
+    // The persistent region of the new chunk is empty. The persistent tables
+    // of the previous chunks stay valid while the descriptor heap is the same.
+    // Dynamic tables are only reused from the current chunk.
+    m_NumPersistentDescriptors = 0;
+    ResetCommittedDescriptorTables();
+
+    if (m_CurrentDescriptorHeap != chunk.DescriptorHeap)
+    {
+        ResetPersistentDescriptorTables();
+
+        m_CurrentDescriptorHeap = chunk.DescriptorHeap;
+        commandList.SetDescriptorHeap(m_DescriptorHeapType, m_CurrentDescriptorHeap);
+
+        // When updating the descriptor heap on the command list, all descriptor
+        // tables must be (re)recopied to the new descriptor heap (not just
+        // the stale descriptor tables).
+        m_StaleDescriptorTableBitMask = m_DescriptorTableLayout->DescriptorTableBitMask;
+
+        // The bindless descriptors are at the start of every descriptor heap of the ring.
+        BindBindlessDescriptorTables(commandList.GetGraphicsCommandList().Get());
+    }
+}
+
+void DynamicDescriptorHeap::BindBindlessDescriptorTables(ID3D12GraphicsCommandList* d3d12GraphicsCommandList)
 {
-    ComPtr<ID3D12DescriptorHeap> descriptorHeap;
-    if (!m_AvailableDescriptorHeaps.empty())
+    D3D12_GPU_DESCRIPTOR_HANDLE bindlessDescriptors = m_CurrentDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
+
+    if (m_BindlessRootParameterIndices[GraphicsPipeline::Index] != InvalidOffset)
     {
-        descriptorHeap = m_AvailableDescriptorHeaps.front();
-        m_AvailableDescriptorHeaps.pop();
+        GraphicsPipeline::SetRootDescriptorTable(d3d12GraphicsCommandList, m_BindlessRootParameterIndices[GraphicsPipeline::Index], bindlessDescriptors);
+    }
+
+    if (m_BindlessRootParameterIndices[ComputePipeline::Index] != InvalidOffset)
+    {
+        ComputePipeline::SetRootDescriptorTable(d3d12GraphicsCommandList, m_BindlessRootParameterIndices[ComputePipeline::Index], bindlessDescriptors);
+    }
+}
+
+template<typename Pipeline>
+void DynamicDescriptorHeap::SetBindlessDescriptorTable(CommandList& commandList, uint32_t rootParameterIndex)
+{
+    m_BindlessRootParameterIndices[Pipeline::Index] = rootParameterIndex;
+
+    // Requesting the first chunk binds the descriptor heap and the bindless table.
+    if (!m_CurrentDescriptorHeap)
+    {
+        RequestDescriptorChunk(commandList);
     }
     else
     {
-        descriptorHeap = CreateDescriptorHeap();
-        m_DescriptorHeapPool.push(descriptorHeap);
+        Pipeline::SetRootDescriptorTable(commandList.GetGraphicsCommandList().Get(), rootParameterIndex,
+            m_CurrentDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
     }
+}
 
-    return descriptorHeap;
+void DynamicDescriptorHeap::SetGraphicsBindlessDescriptorTable(CommandList& commandList, uint32_t rootParameterIndex)
+{
+    SetBindlessDescriptorTable<GraphicsPipeline>(commandList, rootParameterIndex);
 }
 
-ComPtr<ID3D12DescriptorHeap> DynamicDescriptorHeap::CreateDescriptorHeap()
+void DynamicDescriptorHeap::SetComputeBindlessDescriptorTable(CommandList& commandList, uint32_t rootParameterIndex)
 {
-    auto device = Application::Get().GetDevice();
+    SetBindlessDescriptorTable<ComputePipeline>(commandList, rootParameterIndex);
+}
+
+void DynamicDescriptorHeap::FreeDescriptorChunks()
+{
+    if (m_DescriptorChunks.empty())
+        return;
+
+    auto& application = Application::Get();
+    auto& descriptorRing = application.GetDescriptorRing(m_DescriptorHeapType);
+    FenceTag fenceTag = application.GetNextFenceTag();
+
+    for (uint32_t chunkIndex : m_DescriptorChunks)
+    {
+        descriptorRing.FreeChunk(chunkIndex, fenceTag);
+    }
+
+    m_DescriptorChunks.clear();
+}
+
+void DynamicDescriptorHeap::QueueDescriptorCopy(uint32_t offset, const DescriptorTableCache& descriptorTableCache)
+{
+    UINT numSrcDescriptors = descriptorTableCache.NumDescriptors;
+    if (numSrcDescriptors == 0)
+        return;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_BaseCPUDescriptorHandle, offset, m_DescriptorHandleIncrementSize);
+
+    // Tables that are copied next to each other share a destination range.
+    if (m_NumCopyDestDescriptorRanges > 0)
+    {
+        uint32_t i = m_NumCopyDestDescriptorRanges - 1;
+        D3D12_CPU_DESCRIPTOR_HANDLE rangeEnd = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_CopyDestDescriptorRangeStarts[i],
+            m_CopyDestDescriptorRangeSizes[i], m_DescriptorHandleIncrementSize);
+
+        if (rangeEnd.ptr == destDescriptor.ptr)
+        {
+            m_CopyDestDescriptorRangeSizes[i] += numSrcDescriptors;
+        }
+        else
+        {
+            m_CopyDestDescriptorRangeStarts[m_NumCopyDestDescriptorRanges] = destDescriptor;
+            m_CopyDestDescriptorRangeSizes[m_NumCopyDestDescriptorRanges++] = numSrcDescriptors;
+        }
+    }
+    else
+    {
+        m_CopyDestDescriptorRangeStarts[0] = destDescriptor;
+        m_CopyDestDescriptorRangeSizes[0] = numSrcDescriptors;
+        m_NumCopyDestDescriptorRanges = 1;
+    }
 
-    D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc = {};
-    descriptorHeapDesc.Type = m_DescriptorHeapType;
-    descriptorHeapDesc.NumDescriptors = m_NumDescriptorsPerHeap;
-    descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    // Gather the staged descriptors so they can be copied with a single call.
+    std::copy(descriptorTableCache.BaseDescriptor, descriptorTableCache.BaseDescriptor + numSrcDescriptors,
+        m_CopySrcDescriptorHandles.get() + m_NumCopySrcDescriptors);
+    m_NumCopySrcDescriptors += numSrcDescriptors;
 
-    ComPtr<ID3D12DescriptorHeap> descriptorHeap;
-    ThrowIfFailed(device->CreateDescriptorHeap(&descriptorHeapDesc, IID_PPV_ARGS(&descriptorHeap)));
+    // Remember which descriptors are copied to the heap so that the table can be reused.
+    std::copy(descriptorTableCache.BaseDescriptor, descriptorTableCache.BaseDescriptor + numSrcDescriptors,
+        m_CopiedDescriptorHandleCache.get() + offset);
+}
 
-    return descriptorHeap;
+void DynamicDescriptorHeap::FlushDescriptorCopies()
+{
+    if (m_NumCopySrcDescriptors > 0)
+    {
+        auto device = Application::Get().GetDevice();
+
+        // Copy the staged CPU visible descriptors to the GPU visible descriptor heap.
+        device->CopyDescriptors(m_NumCopyDestDescriptorRanges, m_CopyDestDescriptorRangeStarts, m_CopyDestDescriptorRangeSizes,
+            m_NumCopySrcDescriptors, m_CopySrcDescriptorHandles.get(), nullptr, m_DescriptorHeapType);
+    }
+
+    m_NumCopyDestDescriptorRanges = 0;
+    m_NumCopySrcDescriptors = 0;
 }
 
-void DynamicDescriptorHeap::CommitStagedDescriptors(CommandList& commandList, std::function<void(ID3D12GraphicsCommandList*, UINT, D3D12_GPU_DESCRIPTOR_HANDLE)> setFunc)
+template<typename Pipeline>
+void DynamicDescriptorHeap::CommitStagedDescriptors(CommandList& commandList)
 {
     // Compute the number of descriptors that need to be copied 
     uint32_t numDescriptorsToCommit = ComputeStaleDescriptorCount();
 
     if ( numDescriptorsToCommit > 0 )
     {
-        auto device = Application::Get().GetDevice();
         auto d3d12GraphicsCommandList = commandList.GetGraphicsCommandList().Get();
         assert(d3d12GraphicsCommandList != nullptr);
 
-        if ( !m_CurrentDescriptorHeap || m_NumFreeHandles < numDescriptorsToCommit )
+        if ( !m_CurrentDescriptorHeap )
         {
-            m_CurrentDescriptorHeap = RequestDescriptorHeap();
-            m_CurrentCPUDescriptorHandle = m_CurrentDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-            m_CurrentGPUDescriptorHandle = m_CurrentDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
-            m_NumFreeHandles = m_NumDescriptorsPerHeap;
+            RequestDescriptorChunk(commandList);
+        }
 
-            commandList.SetDescriptorHeap(m_DescriptorHeapType, m_CurrentDescriptorHeap.Get());
+        ValidateDescriptorTableCaches();
 
-            // When updating the descriptor heap on the command list, all descriptor
-            // tables must be (re)recopied to the new descriptor heap (not just
-            // the stale descriptor tables).
-            m_StaleDescriptorTableBitMask = m_DescriptorTableBitMask;
+        // Static descriptor tables are bound from the persistent region and
+        // tables that were already copied to the heap are reused first, so
+        // that only the remaining tables need to fit in the chunk.
+        CommitStaticDescriptorTables<Pipeline>(d3d12GraphicsCommandList);
+        CommitCachedDescriptorTables<Pipeline>(d3d12GraphicsCommandList);
+
+        if ( m_NumFreeHandles < ComputeStaleDescriptorCount() )
+        {
+            RequestDescriptorChunk(commandList);
+            CommitStaticDescriptorTables<Pipeline>(d3d12GraphicsCommandList);
         }
 
         DWORD rootIndex;
         // Scan from LSB to MSB for a bit set in staleDescriptorsBitMask
         while ( _BitScanForward( &rootIndex, m_StaleDescriptorTableBitMask ) )
         {
-            UINT numSrcDescriptors = m_DescriptorTableCache[rootIndex].NumDescriptors;
-            D3D12_CPU_DESCRIPTOR_HANDLE* pSrcDescriptorHandles = m_DescriptorTableCache[rootIndex].BaseDescriptor;
+            DescriptorTableCache descriptorTableCache = GetDescriptorTableCache(rootIndex);
+            UINT numSrcDescriptors = descriptorTableCache.NumDescriptors;
 
-            D3D12_CPU_DESCRIPTOR_HANDLE pDestDescriptorRangeStarts[] =
-            {
-                m_CurrentCPUDescriptorHandle
-            };
-            UINT pDestDescriptorRangeSizes[] =
-            {
-                numSrcDescriptors
-            };
+            // The dynamic descriptors grow up from the start of the chunk.
+            uint32_t offset = m_NumDescriptorsPerChunk - m_NumPersistentDescriptors - m_NumFreeHandles;
+            QueueDescriptorCopy(offset, descriptorTableCache);
 
-            // Copy the staged CPU visible descriptors to the GPU visible descriptor heap.
-            device->CopyDescriptors(1, pDestDescriptorRangeStarts, pDestDescriptorRangeSizes,
-                numSrcDescriptors, pSrcDescriptorHandles, nullptr, m_DescriptorHeapType);
+            // Volatile descriptors can change after they are staged, so those
+            // tables are never reused.
+            if ( ( m_DescriptorTableLayout->VolatileDescriptorTableBitMask & (1 << rootIndex) ) == 0 )
+            {
+                std::size_t hash = HashDescriptorTable(descriptorTableCache);
+                m_CommittedDescriptorTables[hash % NumCommittedDescriptorTables] = { hash, offset };
+            }
 
-            // Set the descriptors on the command list using the passed-in setter function.
-            setFunc(d3d12GraphicsCommandList, rootIndex, m_CurrentGPUDescriptorHandle);
+            // Set the descriptors on the command list.
+            Pipeline::SetRootDescriptorTable(d3d12GraphicsCommandList, rootIndex, m_CurrentGPUDescriptorHandle);
 
             // Offset current CPU and GPU descriptor handles.
             m_CurrentCPUDescriptorHandle.Offset(numSrcDescriptors, m_DescriptorHandleIncrementSize);
@@ -184,34 +416,94 @@ void DynamicDescriptorHeap::CommitStagedDescriptors(CommandList& commandList, st
             // Flip the stale bit so the descriptor table is not recopied again unless it is updated with a new descriptor.
             m_StaleDescriptorTableBitMask ^= (1 << rootIndex);
         }
+
+        // Copy the descriptors of all of the committed tables at once.
+        FlushDescriptorCopies();
+    }
+}
+
+template<typename Pipeline>
+void DynamicDescriptorHeap::CommitCachedDescriptorTables(ID3D12GraphicsCommandList* d3d12GraphicsCommandList)
+{
+    DWORD rootIndex;
+    DWORD descriptorTableBitMask = m_StaleDescriptorTableBitMask & ~m_DescriptorTableLayout->VolatileDescriptorTableBitMask;
+
+    while ( _BitScanForward( &rootIndex, descriptorTableBitMask ) )
+    {
+        descriptorTableBitMask ^= (1 << rootIndex);
+
+        DescriptorTableCache descriptorTableCache = GetDescriptorTableCache(rootIndex);
+
+        std::size_t hash = HashDescriptorTable(descriptorTableCache);
+        const CommittedDescriptorTable& committedDescriptorTable = m_CommittedDescriptorTables[hash % NumCommittedDescriptorTables];
+
+        if ( committedDescriptorTable.Hash == hash &&
+             IsCopiedDescriptorTable(committedDescriptorTable.Offset, descriptorTableCache) )
+        {
+            Pipeline::SetRootDescriptorTable(d3d12GraphicsCommandList, rootIndex,
+                CD3DX12_GPU_DESCRIPTOR_HANDLE(m_BaseGPUDescriptorHandle, committedDescriptorTable.Offset, m_DescriptorHandleIncrementSize));
+
+            m_StaleDescriptorTableBitMask ^= (1 << rootIndex);
+        }
+    }
+}
+
+template<typename Pipeline>
+void DynamicDescriptorHeap::CommitStaticDescriptorTables(ID3D12GraphicsCommandList* d3d12GraphicsCommandList)
+{
+    DWORD rootIndex;
+    DWORD staticDescriptorTableBitMask = m_StaleDescriptorTableBitMask & m_DescriptorTableLayout->StaticDescriptorTableBitMask;
+
+    while ( _BitScanForward( &rootIndex, staticDescriptorTableBitMask ) )
+    {
+        staticDescriptorTableBitMask ^= (1 << rootIndex);
+
+        DescriptorTableCache descriptorTableCache = GetDescriptorTableCache(rootIndex);
+        UINT numSrcDescriptors = descriptorTableCache.NumDescriptors;
+
+        std::size_t hash = HashDescriptorTable(descriptorTableCache);
+        D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor = FindPersistentDescriptorTable(hash, descriptorTableCache);
+
+        if ( baseDescriptor.ptr == 0 )
+        {
+            // Leave the table stale if it doesn't fit in the current chunk.
+            if ( m_NumFreeHandles < numSrcDescriptors )
+                continue;
+
+            // The persistent region grows down from the end of the chunk.
+            m_NumPersistentDescriptors += numSrcDescriptors;
+            m_NumFreeHandles -= numSrcDescriptors;
+            uint32_t offset = m_NumDescriptorsPerChunk - m_NumPersistentDescriptors;
+
+            QueueDescriptorCopy(offset, descriptorTableCache);
+
+            baseDescriptor = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_BaseGPUDescriptorHandle, offset, m_DescriptorHandleIncrementSize);
+            m_PersistentDescriptorTables.emplace(hash, PersistentDescriptorTable{ baseDescriptor, static_cast<uint32_t>(m_PersistentDescriptorHandleCache.size()), numSrcDescriptors });
+            m_PersistentDescriptorHandleCache.insert(m_PersistentDescriptorHandleCache.end(),
+                descriptorTableCache.BaseDescriptor, descriptorTableCache.BaseDescriptor + numSrcDescriptors);
+        }
+
+        Pipeline::SetRootDescriptorTable(d3d12GraphicsCommandList, rootIndex, baseDescriptor);
+
+        m_StaleDescriptorTableBitMask ^= (1 << rootIndex);
     }
 }
 
 void DynamicDescriptorHeap::CommitStagedDescriptorsForDraw(CommandList& commandList)
 {
-    CommitStagedDescriptors(commandList, &ID3D12GraphicsCommandList::SetGraphicsRootDescriptorTable);
+    CommitStagedDescriptors<GraphicsPipeline>(commandList);
 }
 
 void DynamicDescriptorHeap::CommitStagedDescriptorsForDispatch(CommandList& commandList)
 {
-    CommitStagedDescriptors(commandList, &ID3D12GraphicsCommandList::SetComputeRootDescriptorTable);
+    CommitStagedDescriptors<ComputePipeline>(commandList);
 }
 
 D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::CopyDescriptor(CommandList& comandList, D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptor)
 {
     if (!m_CurrentDescriptorHeap || m_NumFreeHandles < 1)
     {
-        m_CurrentDescriptorHeap = RequestDescriptorHeap();
-        m_CurrentCPUDescriptorHandle = m_CurrentDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-        m_CurrentGPUDescriptorHandle = m_CurrentDescriptorHeap->GetGPUDescriptorHandleForHeapStart();
-        m_NumFreeHandles = m_NumDescriptorsPerHeap;
-
-        comandList.SetDescriptorHeap(m_DescriptorHeapType, m_CurrentDescriptorHeap.Get());
-
-        // When updating the descriptor heap on the command list, all descriptor
-        // tables must be (re)recopied to the new descriptor heap (not just
-        // the stale descriptor tables).
-        m_StaleDescriptorTableBitMask = m_DescriptorTableBitMask;
+        RequestDescriptorChunk(comandList);
     }
 
     auto device = Application::Get().GetDevice();
@@ -219,6 +511,9 @@ D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::CopyDescriptor(CommandList& c
     D3D12_GPU_DESCRIPTOR_HANDLE hGPU = m_CurrentGPUDescriptorHandle;
     device->CopyDescriptorsSimple(1, m_CurrentCPUDescriptorHandle, cpuDescriptor, m_DescriptorHeapType);
 
+    uint32_t offset = m_NumDescriptorsPerChunk - m_NumPersistentDescriptors - m_NumFreeHandles;
+    m_CopiedDescriptorHandleCache[offset] = cpuDescriptor;
+
     m_CurrentCPUDescriptorHandle.Offset(1, m_DescriptorHandleIncrementSize);
     m_CurrentGPUDescriptorHandle.Offset(1, m_DescriptorHandleIncrementSize);
     m_NumFreeHandles -= 1;
@@ -226,19 +521,37 @@ D3D12_GPU_DESCRIPTOR_HANDLE DynamicDescriptorHeap::CopyDescriptor(CommandList& c
     return hGPU;
 }
 
+size_t DynamicDescriptorHeap::GetMemoryUsage() const
+{
+    // The staging, copied, and copy source descriptor handle caches.
+    return 3 * m_NumDescriptorsPerChunk * sizeof(D3D12_CPU_DESCRIPTOR_HANDLE) +
+        m_DescriptorChunks.capacity() * sizeof(uint32_t) +
+        m_PersistentDescriptorTables.size() * sizeof(std::pair<const std::size_t, PersistentDescriptorTable>) +
+        m_PersistentDescriptorHandleCache.capacity() * sizeof(D3D12_CPU_DESCRIPTOR_HANDLE);
+}
+
+size_t DynamicDescriptorHeap::GetShaderVisibleMemoryUsage() const
+{
+    return m_DescriptorChunks.size() * m_NumDescriptorsPerChunk * m_DescriptorHandleIncrementSize;
+}
+
 void DynamicDescriptorHeap::Reset()
 {
-    m_AvailableDescriptorHeaps = m_DescriptorHeapPool;
-    m_CurrentDescriptorHeap.Reset();
+    FreeDescriptorChunks();
+    m_CurrentDescriptorHeap = nullptr;
     m_CurrentCPUDescriptorHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(D3D12_DEFAULT);
     m_CurrentGPUDescriptorHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(D3D12_DEFAULT);
+    m_BaseCPUDescriptorHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(D3D12_DEFAULT);
+    m_BaseGPUDescriptorHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(D3D12_DEFAULT);
     m_NumFreeHandles = 0;
-    m_DescriptorTableBitMask = 0;
+    m_NumPersistentDescriptors = 0;
+    ResetPersistentDescriptorTables();
+    ResetCommittedDescriptorTables();
+    m_DescriptorTableLayout = &gs_EmptyDescriptorTableLayout;
     m_StaleDescriptorTableBitMask = 0;
 
-    // Reset the table cache
-    for (int i = 0; i < MaxDescriptorTables; ++i)
+    for (auto& bindlessRootParameterIndex : m_BindlessRootParameterIndices)
     {
-        m_DescriptorTableCache[i].Reset();
+        bindlessRootParameterIndex = InvalidOffset;
     }
 }
\ No newline at end of file
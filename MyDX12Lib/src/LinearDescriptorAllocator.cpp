@@ -0,0 +1,96 @@
+#include <DX12LibPCH.h>
+
+#include <LinearDescriptorAllocator.h>
+
+#include <Application.h>
+#include <DescriptorAllocator.h>
+
+LinearDescriptorAllocator::LinearDescriptorAllocator( D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptorsPerPage )
+    : m_HeapType( type )
+    , m_NumDescriptorsPerPage( numDescriptorsPerPage )
+    , m_CurrentDescriptor( D3D12_DEFAULT )
+    , m_NumFreeHandles( 0 )
+{
+    m_DescriptorHandleIncrementSize = Application::Get().GetDescriptorHandleIncrementSize( m_HeapType );
+}
+
+ComPtr<ID3D12DescriptorHeap> LinearDescriptorAllocator::RequestPage()
+{
+    ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+    if ( !m_AvailablePages.empty() )
+    {
+        descriptorHeap = m_AvailablePages.front();
+        m_AvailablePages.pop();
+    }
+    else
+    {
+        descriptorHeap = Application::Get().CreateDescriptorHeap( m_NumDescriptorsPerPage, m_HeapType );
+    }
+
+    return descriptorHeap;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE LinearDescriptorAllocator::Allocate( uint32_t numDescriptors )
+{
+    if ( numDescriptors > m_NumDescriptorsPerPage )
+    {
+        throw std::bad_alloc();
+    }
+
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    if ( !m_CurrentPage || m_NumFreeHandles < numDescriptors )
+    {
+        if ( m_CurrentPage )
+        {
+            RetirePage();
+        }
+
+        m_CurrentPage = RequestPage();
+        m_CurrentDescriptor = m_CurrentPage->GetCPUDescriptorHandleForHeapStart();
+        m_NumFreeHandles = m_NumDescriptorsPerPage;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE descriptor = m_CurrentDescriptor;
+
+    m_CurrentDescriptor.Offset( numDescriptors, m_DescriptorHandleIncrementSize );
+    m_NumFreeHandles -= numDescriptors;
+
+    return descriptor;
+}
+
+void LinearDescriptorAllocator::RetirePage()
+{
+    // The descriptors in the page may still be referenced by commands
+    // that have not been executed yet.
+    m_RetiredPages.push( { m_CurrentPage, Application::Get().GetNextFenceTag() } );
+    DescriptorAllocator::AdvanceFreeGeneration( m_HeapType );
+
+    m_CurrentPage.Reset();
+    m_NumFreeHandles = 0;
+}
+
+void LinearDescriptorAllocator::RetireCurrentPage()
+{
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    // An unused page stays the current page.
+    if ( m_CurrentPage && m_NumFreeHandles < m_NumDescriptorsPerPage )
+    {
+        RetirePage();
+    }
+}
+
+void LinearDescriptorAllocator::ReleaseStaleDescriptors( const FenceTag& completedFenceValues )
+{
+    std::lock_guard<std::mutex> lock( m_AllocationMutex );
+
+    // Retired pages are reset in bulk. Resetting a page only requires moving
+    // it back to the available pages since the offset is reset when the page
+    // becomes the current page.
+    while ( !m_RetiredPages.empty() && m_RetiredPages.front().Fence.IsComplete( completedFenceValues ) )
+    {
+        m_AvailablePages.push( m_RetiredPages.front().DescriptorHeap );
+        m_RetiredPages.pop();
+    }
+}
\ No newline at end of file
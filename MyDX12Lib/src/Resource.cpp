@@ -3,13 +3,20 @@
 #include <Resource.h>
 
 #include <Application.h>
+#include <BindlessDescriptorHeap.h>
 #include <ResourceStateTracker.h>
 
 Resource::Resource(const std::wstring& name)
     : m_ResourceName(name)
+    , m_IsTransient(false)
+    , m_BindlessSRVIndex(BindlessDescriptorHeap::InvalidIndex)
+    , m_BindlessUAVIndex(BindlessDescriptorHeap::InvalidIndex)
 {}
 
 Resource::Resource(const D3D12_RESOURCE_DESC& resourceDesc, const D3D12_CLEAR_VALUE* clearValue, const std::wstring& name)
+    : m_IsTransient(false)
+    , m_BindlessSRVIndex(BindlessDescriptorHeap::InvalidIndex)
+    , m_BindlessUAVIndex(BindlessDescriptorHeap::InvalidIndex)
 {
     auto device = Application::Get().GetDevice();
 
@@ -35,35 +42,54 @@ Resource::Resource(const D3D12_RESOURCE_DESC& resourceDesc, const D3D12_CLEAR_VA
 
 Resource::Resource(ComPtr<ID3D12Resource> resource, const std::wstring& name)
     : m_d3d12Resource(resource)
+    , m_IsTransient(false)
+    , m_BindlessSRVIndex(BindlessDescriptorHeap::InvalidIndex)
+    , m_BindlessUAVIndex(BindlessDescriptorHeap::InvalidIndex)
 {
     SetName(name);
 }
 
 Resource::Resource(const Resource& copy)
     : m_d3d12Resource(copy.m_d3d12Resource)
+    , m_d3d12ClearValue(copy.m_d3d12ClearValue ? std::make_unique<D3D12_CLEAR_VALUE>(*copy.m_d3d12ClearValue) : nullptr)
     , m_ResourceName(copy.m_ResourceName)
-    , m_d3d12ClearValue(std::make_unique<D3D12_CLEAR_VALUE>(*copy.m_d3d12ClearValue))
-{
-    int i = 3;
-}
+    , m_IsTransient(copy.m_IsTransient)
+    , m_BindlessSRVIndex(BindlessDescriptorHeap::InvalidIndex)
+    , m_BindlessUAVIndex(BindlessDescriptorHeap::InvalidIndex)
+{}
 
 Resource::Resource(Resource&& copy)
     : m_d3d12Resource(std::move(copy.m_d3d12Resource))
-    , m_ResourceName(std::move(copy.m_ResourceName))
     , m_d3d12ClearValue(std::move(copy.m_d3d12ClearValue))
+    , m_ResourceName(std::move(copy.m_ResourceName))
+    , m_ShaderResourceViews(std::move(copy.m_ShaderResourceViews))
+    , m_UnorderedAccessViews(std::move(copy.m_UnorderedAccessViews))
+    , m_IsTransient(copy.m_IsTransient)
+    , m_BindlessSRVIndex(copy.m_BindlessSRVIndex)
+    , m_BindlessUAVIndex(copy.m_BindlessUAVIndex)
 {
+    copy.m_BindlessSRVIndex = BindlessDescriptorHeap::InvalidIndex;
+    copy.m_BindlessUAVIndex = BindlessDescriptorHeap::InvalidIndex;
 }
 
 Resource& Resource::operator=(const Resource& other)
 {
     if ( this != &other )
     {
+        ReleaseBindlessIndices();
+        ReleaseViews();
+
         m_d3d12Resource = other.m_d3d12Resource;
         m_ResourceName = other.m_ResourceName;
+        m_IsTransient = other.m_IsTransient;
         if ( other.m_d3d12ClearValue )
         {
             m_d3d12ClearValue = std::make_unique<D3D12_CLEAR_VALUE>( *other.m_d3d12ClearValue );
         }
+        else
+        {
+            m_d3d12ClearValue.reset();
+        }
     }
 
     return *this;
@@ -73,9 +99,19 @@ Resource& Resource::operator=(Resource&& other)
 {
     if (this != &other)
     {
+        ReleaseBindlessIndices();
+
         m_d3d12Resource = other.m_d3d12Resource;
         m_ResourceName = other.m_ResourceName;
         m_d3d12ClearValue = std::move( other.m_d3d12ClearValue );
+        m_BindlessSRVIndex = other.m_BindlessSRVIndex;
+        m_BindlessUAVIndex = other.m_BindlessUAVIndex;
+        m_ShaderResourceViews = std::move( other.m_ShaderResourceViews );
+        m_UnorderedAccessViews = std::move( other.m_UnorderedAccessViews );
+        m_IsTransient = other.m_IsTransient;
+
+        other.m_BindlessSRVIndex = BindlessDescriptorHeap::InvalidIndex;
+        other.m_BindlessUAVIndex = BindlessDescriptorHeap::InvalidIndex;
 
         other.m_d3d12Resource.Reset();
         other.m_ResourceName.clear();
@@ -87,12 +123,17 @@ Resource& Resource::operator=(Resource&& other)
 
 Resource::~Resource()
 {
+    ReleaseBindlessIndices();
 }
 
 void Resource::SetD3D12Resource(ComPtr<ID3D12Resource> d3d12Resource, const D3D12_CLEAR_VALUE* clearValue )
 {
+    // The cached and bindless views refer to the previous resource.
+    ReleaseBindlessIndices();
+    ReleaseViews();
+
     m_d3d12Resource = d3d12Resource;
-    if ( m_d3d12ClearValue )
+    if ( clearValue )
     {
         m_d3d12ClearValue = std::make_unique<D3D12_CLEAR_VALUE>( *clearValue );
     }
@@ -114,6 +155,173 @@ void Resource::SetName(const std::wstring& name)
 
 void Resource::Reset()
 {
+    ReleaseBindlessIndices();
+    ReleaseViews();
+
     m_d3d12Resource.Reset();
     m_d3d12ClearValue.reset();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE Resource::GetShaderResourceView( const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc ) const
+{
+    std::lock_guard<std::mutex> lock( m_ViewMutex );
+
+    return GetCachedShaderResourceView( srvDesc );
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE Resource::GetUnorderedAccessView( const D3D12_UNORDERED_ACCESS_VIEW_DESC* uavDesc ) const
+{
+    std::lock_guard<std::mutex> lock( m_ViewMutex );
+
+    return GetCachedUnorderedAccessView( uavDesc );
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE Resource::GetCachedShaderResourceView( const D3D12_SHADER_RESOURCE_VIEW_DESC* srvDesc ) const
+{
+    auto& application = Application::Get();
+
+    if ( m_IsTransient )
+    {
+        // Transient views are released in bulk by the linear allocator at the end of the frame.
+        auto descriptor = application.AllocateTransientDescriptors( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
+        application.GetDevice()->CreateShaderResourceView( m_d3d12Resource.Get(), srvDesc, descriptor );
+
+        return descriptor;
+    }
+
+    ViewKey<D3D12_SHADER_RESOURCE_VIEW_DESC> key;
+    if ( srvDesc )
+    {
+        key = *srvDesc;
+    }
+
+    auto iter = m_ShaderResourceViews.find( key );
+    if ( iter == m_ShaderResourceViews.end() )
+    {
+        auto srv = application.AllocateDescriptors( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
+        application.GetDevice()->CreateShaderResourceView( m_d3d12Resource.Get(), srvDesc, srv.GetDescriptorHandle() );
+
+        iter = m_ShaderResourceViews.emplace( key, std::move( srv ) ).first;
+    }
+
+    return iter->second.GetDescriptorHandle();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE Resource::GetCachedUnorderedAccessView( const D3D12_UNORDERED_ACCESS_VIEW_DESC* uavDesc ) const
+{
+    auto& application = Application::Get();
+
+    if ( m_IsTransient )
+    {
+        auto descriptor = application.AllocateTransientDescriptors( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
+        application.GetDevice()->CreateUnorderedAccessView( m_d3d12Resource.Get(), nullptr, uavDesc, descriptor );
+
+        return descriptor;
+    }
+
+    ViewKey<D3D12_UNORDERED_ACCESS_VIEW_DESC> key;
+    if ( uavDesc )
+    {
+        key = *uavDesc;
+    }
+
+    auto iter = m_UnorderedAccessViews.find( key );
+    if ( iter == m_UnorderedAccessViews.end() )
+    {
+        auto uav = application.AllocateDescriptors( D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV );
+        application.GetDevice()->CreateUnorderedAccessView( m_d3d12Resource.Get(), nullptr, uavDesc, uav.GetDescriptorHandle() );
+
+        iter = m_UnorderedAccessViews.emplace( key, std::move( uav ) ).first;
+    }
+
+    return iter->second.GetDescriptorHandle();
+}
+
+void Resource::SetTransient( bool isTransient )
+{
+    if ( m_IsTransient != isTransient )
+    {
+        ReleaseViews();
+        m_IsTransient = isTransient;
+    }
+}
+
+void Resource::ReleaseViews()
+{
+    std::lock_guard<std::mutex> lock( m_ViewMutex );
+
+    // The descriptors are retired until the command queues are done with them.
+    m_ShaderResourceViews.clear();
+    m_UnorderedAccessViews.clear();
+}
+
+uint32_t Resource::GetBindlessShaderResourceIndex() const
+{
+    // The index is assigned on first use, possibly by multiple threads at the same time.
+    std::lock_guard<std::mutex> lock( m_ViewMutex );
+
+    if ( m_BindlessSRVIndex == BindlessDescriptorHeap::InvalidIndex && m_d3d12Resource )
+    {
+        auto& bindlessHeap = Application::Get().GetBindlessDescriptorHeap();
+
+        uint32_t index = bindlessHeap.Allocate();
+        bindlessHeap.CopyDescriptor( index, GetCachedShaderResourceView( nullptr ) );
+        m_BindlessSRVIndex = index;
+    }
+
+    return m_BindlessSRVIndex;
+}
+
+uint32_t Resource::GetBindlessUnorderedAccessIndex() const
+{
+    std::lock_guard<std::mutex> lock( m_ViewMutex );
+
+    if ( m_BindlessUAVIndex == BindlessDescriptorHeap::InvalidIndex && m_d3d12Resource )
+    {
+        auto& bindlessHeap = Application::Get().GetBindlessDescriptorHeap();
+
+        uint32_t index = bindlessHeap.Allocate();
+        bindlessHeap.CopyDescriptor( index, GetCachedUnorderedAccessView( nullptr ) );
+        m_BindlessUAVIndex = index;
+    }
+
+    return m_BindlessUAVIndex;
+}
+
+void Resource::ReleaseBindlessIndices()
+{
+    std::lock_guard<std::mutex> lock( m_ViewMutex );
+
+    if ( m_BindlessSRVIndex == BindlessDescriptorHeap::InvalidIndex && m_BindlessUAVIndex == BindlessDescriptorHeap::InvalidIndex )
+    {
+        return;
+    }
+
+    auto& application = Application::Get();
+    auto& bindlessHeap = application.GetBindlessDescriptorHeap();
+
+    // A command list that is still being recorded may reference the bindless
+    // indices and will signal a later fence value than the next fence values
+    // (see GetNextFenceTag). The indices are then tagged at the end of the frame.
+    bool isDeferred = application.HasOpenCommandLists();
+    auto fenceTag = application.GetNextFenceTag();
+
+    for ( uint32_t* bindlessIndex : { &m_BindlessSRVIndex, &m_BindlessUAVIndex } )
+    {
+        if ( *bindlessIndex == BindlessDescriptorHeap::InvalidIndex )
+        {
+            continue;
+        }
+
+        if ( isDeferred )
+        {
+            bindlessHeap.FreeDeferred( *bindlessIndex, 1 );
+        }
+        else
+        {
+            bindlessHeap.Free( *bindlessIndex, 1, fenceTag );
+        }
+
+        *bindlessIndex = BindlessDescriptorHeap::InvalidIndex;
+    }
 }
\ No newline at end of file
@@ -199,6 +199,21 @@ void ResourceStateTracker::Reset()
     m_FinalResourceState.clear();
 }
 
+size_t ResourceStateTracker::GetMemoryUsage() const
+{
+    size_t memoryUsage = ( m_PendingResourceBarriers.capacity() + m_ResourceBarriers.capacity() ) * sizeof( D3D12_RESOURCE_BARRIER );
+
+    // The nodes of the maps also store the pointers that link them.
+    memoryUsage += m_FinalResourceState.bucket_count() * sizeof( void* );
+    for ( const auto& resourceState : m_FinalResourceState )
+    {
+        memoryUsage += sizeof( ResourceStateMap::value_type ) + sizeof( void* );
+        memoryUsage += resourceState.second.SubresourceState.size() * ( sizeof( std::pair<const UINT, D3D12_RESOURCE_STATES> ) + 3 * sizeof( void* ) );
+    }
+
+    return memoryUsage;
+}
+
 void ResourceStateTracker::Lock()
 {
     ms_GlobalMutex.lock();
@@ -7,16 +7,14 @@
 RootSignature::RootSignature()
     : m_RootSignatureDesc{}
     , m_NumDescriptorsPerTable{ 0 }
-    , m_SamplerTableBitMask(0)
-    , m_DescriptorTableBitMask(0)
+    , m_DescriptorTableLayouts{}
 {}
 
 RootSignature::RootSignature(
     const D3D12_ROOT_SIGNATURE_DESC1& rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION rootSignatureVersion )
     : m_RootSignatureDesc{}
     , m_NumDescriptorsPerTable{ 0 }
-    , m_SamplerTableBitMask(0)
-    , m_DescriptorTableBitMask(0)
+    , m_DescriptorTableLayouts{}
 {
     SetRootSignatureDesc(rootSignatureDesc, rootSignatureVersion);
 }
@@ -45,10 +43,8 @@ void RootSignature::Destroy()
     m_RootSignatureDesc.pStaticSamplers = nullptr;
     m_RootSignatureDesc.NumStaticSamplers = 0;
 
-    m_DescriptorTableBitMask = 0;
-    m_SamplerTableBitMask = 0;
-
     memset(m_NumDescriptorsPerTable, 0, sizeof(m_NumDescriptorsPerTable));
+    memset(m_DescriptorTableLayouts, 0, sizeof(m_DescriptorTableLayouts));
 }
 
 void RootSignature::SetRootSignatureDesc(
@@ -81,27 +77,57 @@ void RootSignature::SetRootSignatureDesc(
             pParameters[i].DescriptorTable.NumDescriptorRanges = numDescriptorRanges;
             pParameters[i].DescriptorTable.pDescriptorRanges = pDescriptorRanges;
 
-            // Set the bit mask depending on the type of descriptor table.
-            if (numDescriptorRanges > 0)
+            // Tables with an unbounded range index into the bindless descriptor
+            // heap and are bound by the command list directly, so they are not
+            // managed by the DynamicDescriptorHeap.
+            bool isUnbounded = false;
+            for (UINT j = 0; j < numDescriptorRanges; ++j)
             {
-                switch (pDescriptorRanges[0].RangeType)
-                {
-                case D3D12_DESCRIPTOR_RANGE_TYPE_CBV:
-                case D3D12_DESCRIPTOR_RANGE_TYPE_SRV:
-                case D3D12_DESCRIPTOR_RANGE_TYPE_UAV:
-                    m_DescriptorTableBitMask |= (1 << i);
-                    break;
-                case D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER:
-                    m_SamplerTableBitMask |= (1 << i);
-                    break;
-                }
+                isUnbounded |= pDescriptorRanges[j].NumDescriptors == UINT_MAX;
             }
 
             // Count the number of descriptors in the descriptor table.
-            for (UINT j = 0; j < numDescriptorRanges; ++j)
+            for (UINT j = 0; j < numDescriptorRanges && !isUnbounded; ++j)
             {
                 m_NumDescriptorsPerTable[i] += pDescriptorRanges[j].NumDescriptors;
             }
+
+            // Add the descriptor table to the layout of its descriptor heap type.
+            if (numDescriptorRanges == 0 || isUnbounded)
+                continue;
+
+            DescriptorTableLayout& layout = pDescriptorRanges[0].RangeType == D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER ?
+                m_DescriptorTableLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER] :
+                m_DescriptorTableLayouts[D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV];
+
+            // The tables are packed in root parameter order.
+            layout.DescriptorTableBitMask |= (1 << i);
+            layout.NumDescriptorsPerTable[i] = m_NumDescriptorsPerTable[i];
+            layout.DescriptorTableOffsets[i] = layout.NumDescriptors;
+            layout.NumDescriptors += m_NumDescriptorsPerTable[i];
+
+            // The descriptors of static tables can't change while the command
+            // list is recorded and executed, so the DynamicDescriptorHeap only
+            // needs to copy them once per descriptor heap.
+            bool isStatic = numDescriptorRanges > 0;
+            bool isVolatile = false;
+            for (UINT j = 0; j < numDescriptorRanges; ++j)
+            {
+                isStatic &= (pDescriptorRanges[j].Flags & D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC) != 0;
+                isVolatile |= (pDescriptorRanges[j].Flags & D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE) != 0;
+            }
+
+            if (isStatic && !isVolatile)
+            {
+                layout.StaticDescriptorTableBitMask |= (1 << i);
+            }
+
+            // The descriptors of volatile tables can change after they are
+            // staged, so the DynamicDescriptorHeap must always copy them.
+            if (isVolatile)
+            {
+                layout.VolatileDescriptorTableBitMask |= (1 << i);
+            }
         }
     }
 
@@ -139,22 +165,21 @@ void RootSignature::SetRootSignatureDesc(
 
 uint32_t RootSignature::GetDescriptorTableBitMask(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) const
 {
-    uint32_t descriptorTableBitMask = 0;
-    switch (descriptorHeapType)
-    {
-    case D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV:
-        descriptorTableBitMask = m_DescriptorTableBitMask;
-        break;
-    case D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER:
-        descriptorTableBitMask = m_SamplerTableBitMask;
-        break;
-    }
+    return m_DescriptorTableLayouts[descriptorHeapType].DescriptorTableBitMask;
+}
 
-    return descriptorTableBitMask;
+uint32_t RootSignature::GetStaticDescriptorTableBitMask(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) const
+{
+    return m_DescriptorTableLayouts[descriptorHeapType].StaticDescriptorTableBitMask;
+}
+
+uint32_t RootSignature::GetVolatileDescriptorTableBitMask(D3D12_DESCRIPTOR_HEAP_TYPE descriptorHeapType) const
+{
+    return m_DescriptorTableLayouts[descriptorHeapType].VolatileDescriptorTableBitMask;
 }
 
 uint32_t RootSignature::GetNumDescriptors(uint32_t rootIndex) const
 {
-    assert(rootIndex < 32);
+    assert(rootIndex < MaxDescriptorTables);
     return m_NumDescriptorsPerTable[rootIndex];
 }
@@ -0,0 +1,123 @@
+#include <DX12LibPCH.h>
+
+#include <SamplerHeap.h>
+
+#include <Application.h>
+
+SamplerHeap::SamplerHeap( uint32_t numSamplers )
+    : m_NumSamplersInHeap( numSamplers )
+{
+    assert( numSamplers <= D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE && "Shader visible sampler heaps are limited to 2048 samplers." );
+
+    auto device = Application::Get().GetDevice();
+
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
+    heapDesc.NumDescriptors = m_NumSamplersInHeap;
+    heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+    ThrowIfFailed( device->CreateDescriptorHeap( &heapDesc, IID_PPV_ARGS( &m_d3d12DescriptorHeap ) ) );
+
+    m_BaseCPUDescriptor = m_d3d12DescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+    m_BaseGPUDescriptor = m_d3d12DescriptorHeap->GetGPUDescriptorHandleForHeapStart();
+    m_DescriptorHandleIncrementSize = device->GetDescriptorHandleIncrementSize( heapDesc.Type );
+
+    m_SamplerDescs.reserve( m_NumSamplersInHeap );
+}
+
+uint32_t SamplerHeap::GetNumAllocatedSamplers() const
+{
+    std::lock_guard<std::mutex> lock( m_SamplerMutex );
+
+    return static_cast<uint32_t>( m_SamplerDescs.size() );
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE SamplerHeap::GetGPUDescriptorHandle( uint32_t index ) const
+{
+    return CD3DX12_GPU_DESCRIPTOR_HANDLE( m_BaseGPUDescriptor, index, m_DescriptorHandleIncrementSize );
+}
+
+uint32_t SamplerHeap::GetSamplerIndex( const D3D12_SAMPLER_DESC& samplerDesc )
+{
+    return GetSamplerTable( &samplerDesc, 1 );
+}
+
+std::size_t SamplerHeap::HashSamplerTable( const D3D12_SAMPLER_DESC* samplerDescs, uint32_t numSamplers )
+{
+    std::size_t seed = numSamplers;
+    for ( uint32_t i = 0; i < numSamplers; ++i )
+    {
+        std::hash_combine( seed, samplerDescs[i] );
+    }
+
+    return seed;
+}
+
+uint32_t SamplerHeap::FindSamplerTable( std::size_t hash, const D3D12_SAMPLER_DESC* samplerDescs, uint32_t numSamplers ) const
+{
+    auto range = m_SamplerTables.equal_range( hash );
+    for ( auto iter = range.first; iter != range.second; ++iter )
+    {
+        if ( IsSamplerTable( iter->second, samplerDescs, numSamplers ) )
+        {
+            return iter->second;
+        }
+    }
+
+    return InvalidIndex;
+}
+
+bool SamplerHeap::IsSamplerTable( uint32_t index, const D3D12_SAMPLER_DESC* samplerDescs, uint32_t numSamplers ) const
+{
+    if ( index + numSamplers > m_SamplerDescs.size() )
+        return false;
+
+    return memcmp( &m_SamplerDescs[index], samplerDescs, numSamplers * sizeof( D3D12_SAMPLER_DESC ) ) == 0;
+}
+
+uint32_t SamplerHeap::GetSamplerTable( const D3D12_SAMPLER_DESC* samplerDescs, uint32_t numSamplers )
+{
+    assert( numSamplers > 0 );
+
+    std::size_t hash = HashSamplerTable( samplerDescs, numSamplers );
+
+    std::lock_guard<std::mutex> lock( m_SamplerMutex );
+
+    uint32_t index = FindSamplerTable( hash, samplerDescs, numSamplers );
+    if ( index != InvalidIndex )
+    {
+        return index;
+    }
+
+    index = static_cast<uint32_t>( m_SamplerDescs.size() );
+    if ( index + numSamplers > m_NumSamplersInHeap )
+    {
+        // Sampler slots are permanent and are never reused.
+        throw std::bad_alloc();
+    }
+
+    auto device = Application::Get().GetDevice();
+
+    for ( uint32_t i = 0; i < numSamplers; ++i )
+    {
+        device->CreateSampler( &samplerDescs[i], CD3DX12_CPU_DESCRIPTOR_HANDLE( m_BaseCPUDescriptor, index + i, m_DescriptorHandleIncrementSize ) );
+        m_SamplerDescs.push_back( samplerDescs[i] );
+    }
+
+    m_SamplerTables.emplace( hash, index );
+
+    // The samplers in a table can also be used on their own.
+    if ( numSamplers > 1 )
+    {
+        for ( uint32_t i = 0; i < numSamplers; ++i )
+        {
+            std::size_t samplerHash = HashSamplerTable( &samplerDescs[i], 1 );
+            if ( FindSamplerTable( samplerHash, &samplerDescs[i], 1 ) == InvalidIndex )
+            {
+                m_SamplerTables.emplace( samplerHash, index + i );
+            }
+        }
+    }
+
+    return index;
+}
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include <DX12LibPCH.h>
+
+#include <StreamingCopy.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC allows the AVX2 intrinsics in any function.
+#define STREAMING_COPY_AVX2
+#else
+#include <cpuid.h>
+#define STREAMING_COPY_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Copies that are smaller than this are done with memcpy. The streaming
+// stores only pay off if at least a few full cache lines are written.
+static const size_t MinStreamingCopySize = 256;
+
+using StreamingCopyFunction = void (*)(void* dst, const void* src, size_t sizeInBytes);
+
+static void CopySSE2(void* dst, const void* src, size_t sizeInBytes)
+{
+    uint8_t* d = static_cast<uint8_t*>(dst);
+    const uint8_t* s = static_cast<const uint8_t*>(src);
+
+    // Copy the head to align the destination to 16 bytes.
+    size_t head = (16 - (reinterpret_cast<uintptr_t>(d) & 15)) & 15;
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    sizeInBytes -= head;
+
+    // Copy 64 bytes (a cache line) per iteration.
+    for (; sizeInBytes >= 64; sizeInBytes -= 64, d += 64, s += 64)
+    {
+        __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+        __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16));
+        __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 32));
+        __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d), r0);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d + 16), r1);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d + 32), r2);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d + 48), r3);
+    }
+
+    for (; sizeInBytes >= 16; sizeInBytes -= 16, d += 16, s += 16)
+    {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(d), _mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+    }
+
+    // Make the streaming stores visible before the tail is written.
+    _mm_sfence();
+
+    memcpy(d, s, sizeInBytes);
+}
+
+STREAMING_COPY_AVX2 static void CopyAVX2(void* dst, const void* src, size_t sizeInBytes)
+{
+    uint8_t* d = static_cast<uint8_t*>(dst);
+    const uint8_t* s = static_cast<const uint8_t*>(src);
+
+    // Copy the head to align the destination to 32 bytes.
+    size_t head = (32 - (reinterpret_cast<uintptr_t>(d) & 31)) & 31;
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    sizeInBytes -= head;
+
+    // Copy 128 bytes (two cache lines) per iteration.
+    for (; sizeInBytes >= 128; sizeInBytes -= 128, d += 128, s += 128)
+    {
+        __m256i r0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+        __m256i r1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 32));
+        __m256i r2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 64));
+        __m256i r3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + 96));
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(d), r0);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(d + 32), r1);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(d + 64), r2);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(d + 96), r3);
+    }
+
+    for (; sizeInBytes >= 32; sizeInBytes -= 32, d += 32, s += 32)
+    {
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(d), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s)));
+    }
+
+    // Make the streaming stores visible before the tail is written.
+    _mm_sfence();
+
+    // Avoid the penalty of mixing AVX and SSE code in the memcpy of the tail.
+    _mm256_zeroupper();
+
+    memcpy(d, s, sizeInBytes);
+}
+
+static void CPUID(int leaf, int subLeaf, int info[4])
+{
+#if defined(_MSC_VER)
+    __cpuidex(info, leaf, subLeaf);
+#else
+    __cpuid_count(leaf, subLeaf, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+static bool IsAVX2Supported()
+{
+    int info[4];
+
+    CPUID(0, 0, info);
+    if (info[0] < 7)
+        return false;
+
+    // The CPU supports AVX and the OS uses XSAVE to save the AVX registers.
+    CPUID(1, 0, info);
+    const int OSXSAVE = 1 << 27;
+    const int AVX = 1 << 28;
+    if ((info[2] & (OSXSAVE | AVX)) != (OSXSAVE | AVX))
+        return false;
+
+    // The OS saves the XMM and YMM state on a context switch.
+#if defined(_MSC_VER)
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    unsigned long long xcr0 = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+    if ((xcr0 & 0x6) != 0x6)
+        return false;
+
+    CPUID(7, 0, info);
+    const int AVX2 = 1 << 5;
+
+    return (info[1] & AVX2) != 0;
+}
+
+static bool IsSSE2Supported()
+{
+    int info[4];
+    CPUID(1, 0, info);
+
+    const int SSE2 = 1 << 26;
+
+    return (info[3] & SSE2) != 0;
+}
+
+static StreamingCopyKernel SelectStreamingCopyKernel()
+{
+    if (IsAVX2Supported())
+        return StreamingCopyKernel::AVX2;
+
+    if (IsSSE2Supported())
+        return StreamingCopyKernel::SSE2;
+
+    return StreamingCopyKernel::Memcpy;
+}
+
+static void CopyMemcpy(void* dst, const void* src, size_t sizeInBytes)
+{
+    memcpy(dst, src, sizeInBytes);
+}
+
+static StreamingCopyFunction GetStreamingCopyFunction(StreamingCopyKernel kernel)
+{
+    switch (kernel)
+    {
+    case StreamingCopyKernel::AVX2:
+        return &CopyAVX2;
+    case StreamingCopyKernel::SSE2:
+        return &CopySSE2;
+    default:
+        return &CopyMemcpy;
+    }
+}
+
+// The kernel is selected once, when the library is loaded.
+static const StreamingCopyKernel gs_StreamingCopyKernel = SelectStreamingCopyKernel();
+static const StreamingCopyFunction gs_StreamingCopy = GetStreamingCopyFunction(gs_StreamingCopyKernel);
+
+void StreamingCopy(void* dst, const void* src, size_t sizeInBytes)
+{
+    if (sizeInBytes < MinStreamingCopySize)
+    {
+        memcpy(dst, src, sizeInBytes);
+        return;
+    }
+
+    gs_StreamingCopy(dst, src, sizeInBytes);
+}
+
+StreamingCopyKernel GetStreamingCopyKernel()
+{
+    return gs_StreamingCopyKernel;
+}
\ No newline at end of file
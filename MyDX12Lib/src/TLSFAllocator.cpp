@@ -0,0 +1,293 @@
+// This file does not include the precompiled header on purpose. The TLSF
+// allocator does not depend on Direct3D and can be compiled on any platform.
+#include <TLSFAllocator.h>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+TLSFAllocator::TLSFAllocator( SizeType capacity )
+    : m_Blocks( capacity )
+    , m_FirstLevelBitmap( 0 )
+    , m_SecondLevelBitmap{ 0 }
+    , m_Capacity( capacity )
+    , m_FreeSize( 0 )
+{
+    for ( auto& firstLevel : m_FreeLists )
+    {
+        for ( auto& head : firstLevel )
+        {
+            head = InvalidOffset;
+        }
+    }
+
+    if ( m_Capacity > 0 )
+    {
+        // The whole range starts as a single free block.
+        m_Blocks[0] = { m_Capacity, InvalidOffset, InvalidOffset, InvalidOffset, false };
+        InsertFreeBlock( 0 );
+        m_FreeSize = m_Capacity;
+    }
+}
+
+void TLSFAllocator::Mapping( SizeType size, uint32_t& fl, uint32_t& sl )
+{
+    if ( size < SecondLevelCount )
+    {
+        // Small blocks are stored linearly in the first first level list.
+        fl = 0;
+        sl = size;
+    }
+    else
+    {
+        uint32_t msb = static_cast<uint32_t>( std::bit_width( size ) ) - 1;
+        sl = ( size >> ( msb - SecondLevelLog2 ) ) ^ SecondLevelCount;
+        fl = msb - SecondLevelLog2 + 1;
+    }
+}
+
+TLSFAllocator::OffsetType TLSFAllocator::FindFreeBlock( SizeType size ) const
+{
+    uint32_t fl, sl;
+
+    // Round the size up to the next list boundary so that any block in the
+    // list that is found is large enough to satisfy the request.
+    uint64_t searchSize = size;
+    if ( size >= SecondLevelCount )
+    {
+        uint32_t msb = static_cast<uint32_t>( std::bit_width( size ) ) - 1;
+        searchSize += ( 1ull << ( msb - SecondLevelLog2 ) ) - 1;
+    }
+
+    if ( searchSize <= std::numeric_limits<SizeType>::max() )
+    {
+        Mapping( static_cast<SizeType>( searchSize ), fl, sl );
+
+        uint32_t secondLevelMap = m_SecondLevelBitmap[fl] & ( ~0u << sl );
+        if ( secondLevelMap == 0 )
+        {
+            // No block in this first level list, try the next larger first level list.
+            uint32_t firstLevelMap = fl + 1 < FirstLevelCount ? m_FirstLevelBitmap & ( ~0u << ( fl + 1 ) ) : 0;
+            if ( firstLevelMap != 0 )
+            {
+                fl = static_cast<uint32_t>( std::countr_zero( firstLevelMap ) );
+                secondLevelMap = m_SecondLevelBitmap[fl];
+            }
+        }
+
+        if ( secondLevelMap != 0 )
+        {
+            sl = static_cast<uint32_t>( std::countr_zero( secondLevelMap ) );
+            return m_FreeLists[fl][sl];
+        }
+    }
+
+    // The rounded search failed, but the first block in the list that the
+    // requested size belongs to may still be large enough. This happens when
+    // the request is (almost) as large as the largest free block (for example
+    // a request for the complete range).
+    Mapping( size, fl, sl );
+    OffsetType head = m_FreeLists[fl][sl];
+    if ( head != InvalidOffset && m_Blocks[head].Size >= size )
+    {
+        return head;
+    }
+
+    return InvalidOffset;
+}
+
+void TLSFAllocator::InsertFreeBlock( OffsetType offset )
+{
+    Block& block = m_Blocks[offset];
+
+    uint32_t fl, sl;
+    Mapping( block.Size, fl, sl );
+
+    OffsetType head = m_FreeLists[fl][sl];
+
+    block.IsFree = true;
+    block.PrevFree = InvalidOffset;
+    block.NextFree = head;
+
+    if ( head != InvalidOffset )
+    {
+        m_Blocks[head].PrevFree = offset;
+    }
+
+    m_FreeLists[fl][sl] = offset;
+    m_FirstLevelBitmap |= ( 1u << fl );
+    m_SecondLevelBitmap[fl] |= ( 1u << sl );
+}
+
+void TLSFAllocator::RemoveFreeBlock( OffsetType offset )
+{
+    Block& block = m_Blocks[offset];
+
+    uint32_t fl, sl;
+    Mapping( block.Size, fl, sl );
+
+    if ( block.PrevFree != InvalidOffset )
+    {
+        m_Blocks[block.PrevFree].NextFree = block.NextFree;
+    }
+    else
+    {
+        m_FreeLists[fl][sl] = block.NextFree;
+    }
+
+    if ( block.NextFree != InvalidOffset )
+    {
+        m_Blocks[block.NextFree].PrevFree = block.PrevFree;
+    }
+
+    // Clear the bits in the bitmaps if the list became empty.
+    if ( m_FreeLists[fl][sl] == InvalidOffset )
+    {
+        m_SecondLevelBitmap[fl] &= ~( 1u << sl );
+        if ( m_SecondLevelBitmap[fl] == 0 )
+        {
+            m_FirstLevelBitmap &= ~( 1u << fl );
+        }
+    }
+
+    block.IsFree = false;
+    block.PrevFree = InvalidOffset;
+    block.NextFree = InvalidOffset;
+}
+
+bool TLSFAllocator::HasSpace( SizeType size ) const
+{
+    return size > 0 && size <= m_FreeSize && FindFreeBlock( size ) != InvalidOffset;
+}
+
+TLSFAllocator::SizeType TLSFAllocator::GetLargestFreeBlock() const
+{
+    if ( m_FirstLevelBitmap == 0 )
+    {
+        return 0;
+    }
+
+    // The largest block is in the highest non-empty list. Every block in that
+    // list is at least as large as the lower bound of the list (the inverse
+    // of Mapping), and FindFreeBlock finds that list for a request of this size.
+    uint32_t fl = static_cast<uint32_t>( std::bit_width( m_FirstLevelBitmap ) ) - 1;
+    uint32_t sl = static_cast<uint32_t>( std::bit_width( m_SecondLevelBitmap[fl] ) ) - 1;
+
+    if ( fl == 0 )
+    {
+        return sl;
+    }
+
+    return ( SecondLevelCount | sl ) << ( fl - 1 );
+}
+
+void TLSFAllocator::GetFreeBlockHistogram( uint32_t* histogram, uint32_t numBuckets ) const
+{
+    for ( uint32_t fl = 0; fl < FirstLevelCount; ++fl )
+    {
+        if ( ( m_FirstLevelBitmap & ( 1u << fl ) ) == 0 )
+        {
+            continue;
+        }
+
+        for ( uint32_t sl = 0; sl < SecondLevelCount; ++sl )
+        {
+            for ( OffsetType offset = m_FreeLists[fl][sl]; offset != InvalidOffset; offset = m_Blocks[offset].NextFree )
+            {
+                uint32_t bucket = static_cast<uint32_t>( std::bit_width( m_Blocks[offset].Size ) ) - 1;
+                ++histogram[std::min( bucket, numBuckets - 1 )];
+            }
+        }
+    }
+}
+
+TLSFAllocator::OffsetType TLSFAllocator::Allocate( SizeType size )
+{
+    // There are less than the requested number of elements left in the range.
+    if ( size == 0 || size > m_FreeSize )
+    {
+        return InvalidOffset;
+    }
+
+    OffsetType offset = FindFreeBlock( size );
+    if ( offset == InvalidOffset )
+    {
+        // There was no free block that could satisfy the request.
+        return InvalidOffset;
+    }
+
+    RemoveFreeBlock( offset );
+
+    Block& block = m_Blocks[offset];
+    SizeType remainingSize = block.Size - size;
+
+    if ( remainingSize > 0 )
+    {
+        // If the allocation didn't exactly match the requested size,
+        // return the left-over to the free list.
+        OffsetType remainingOffset = offset + size;
+        m_Blocks[remainingOffset] = { remainingSize, offset, InvalidOffset, InvalidOffset, false };
+
+        OffsetType nextOffset = remainingOffset + remainingSize;
+        if ( nextOffset < m_Capacity )
+        {
+            m_Blocks[nextOffset].PrevPhysical = remainingOffset;
+        }
+
+        block.Size = size;
+        InsertFreeBlock( remainingOffset );
+    }
+
+    m_FreeSize -= size;
+
+    return offset;
+}
+
+void TLSFAllocator::Free( OffsetType offset, SizeType size )
+{
+    assert( offset < m_Capacity && !m_Blocks[offset].IsFree && m_Blocks[offset].Size == size );
+
+    m_FreeSize += size;
+
+    // Merge with the previous block if it is free.
+    //
+    // PrevBlock.Offset           Offset
+    // |                          |
+    // |<-----PrevBlock.Size----->|<------Size-------->|
+    //
+    OffsetType prevOffset = m_Blocks[offset].PrevPhysical;
+    if ( prevOffset != InvalidOffset && m_Blocks[prevOffset].IsFree )
+    {
+        RemoveFreeBlock( prevOffset );
+
+        m_Blocks[prevOffset].Size += m_Blocks[offset].Size;
+        m_Blocks[offset].Size = 0;
+
+        offset = prevOffset;
+    }
+
+    // Merge with the next block if it is free.
+    //
+    // Offset               NextBlock.Offset
+    // |                    |
+    // |<------Size-------->|<-----NextBlock.Size----->|
+    //
+    OffsetType nextOffset = offset + m_Blocks[offset].Size;
+    if ( nextOffset < m_Capacity && m_Blocks[nextOffset].IsFree )
+    {
+        RemoveFreeBlock( nextOffset );
+
+        m_Blocks[offset].Size += m_Blocks[nextOffset].Size;
+        m_Blocks[nextOffset].Size = 0;
+
+        nextOffset = offset + m_Blocks[offset].Size;
+    }
+
+    // The block after the merged block now starts after this block.
+    if ( nextOffset < m_Capacity )
+    {
+        m_Blocks[nextOffset].PrevPhysical = offset;
+    }
+
+    InsertFreeBlock( offset );
+}
@@ -4,67 +4,380 @@
 
 #include <Application.h>
 #include <Helpers.h>
+#include <UploadRing.h>
 
-UploadBuffer::UploadBuffer(size_t pageSize)
-    : m_PageSize(pageSize)
-{}
+std::atomic_size_t UploadBuffer::ms_TotalMemoryUsage(0);
+std::atomic_size_t UploadBuffer::ms_PeakMemoryUsage(0);
+std::atomic_size_t UploadBuffer::ms_MemoryBudget(0);
+std::atomic_uint32_t UploadBuffer::ms_NumUploadBuffers(0);
+std::atomic_uint64_t UploadBuffer::ms_NumReleasedPages(0);
+
+UploadBuffer::UploadBuffer(size_t pageSize, UploadRing* uploadRing)
+    : m_AvailablePages(nullptr)
+    , m_NewPages(nullptr)
+    , m_NumPages(0)
+    , m_LargePageMemoryUsage(0)
+    , m_UploadRing(uploadRing)
+    , m_RingPages(nullptr)
+    , m_NumRingPages(0)
+    , m_CurrentPage(nullptr)
+    , m_NumSparePages(0)
+    , m_PageSize(pageSize)
+    , m_UsedMemory(0)
+    , m_HighWaterMark(0)
+    , m_PageDecay(DefaultPageDecay)
+    , m_NumReleasedPages(0)
+{
+    assert((!m_UploadRing || m_UploadRing->GetBlockSize() == m_PageSize) && "The block size of the upload ring must match the page size.");
+
+    ++ms_NumUploadBuffers;
+}
 
 UploadBuffer::~UploadBuffer()
-{}
+{
+    FreeRingBlocks();
+    AdoptNewPages();
+
+    SubtractTotalMemoryUsage(m_PagePool.size() * m_PageSize + m_LargePageMemoryUsage);
+    --ms_NumUploadBuffers;
+}
 
 UploadBuffer::Allocation UploadBuffer::Allocate(size_t sizeInBytes, size_t alignment)
 {
     if (sizeInBytes > m_PageSize)
     {
-        throw std::bad_alloc();
+        // The large page is only used for this allocation, so the current
+        // page can still be used for the next allocations.
+        std::lock_guard<std::mutex> lock(m_LargePageMutex);
+
+        return RequestLargePage(sizeInBytes, alignment)->Allocate(sizeInBytes, alignment);
     }
 
+    Allocation allocation;
+    Page* currentPage = m_CurrentPage;
+
     // If there is no current page, or the requested allocation exceeds the
     // remaining space in the current page, request a new page.
-    if (!m_CurrentPage || !m_CurrentPage->HasSpace(sizeInBytes, alignment))
+    while (!currentPage || !currentPage->TryAllocate(sizeInBytes, alignment, allocation))
     {
-        m_CurrentPage = RequestPage();
+        currentPage = RolloverPage(currentPage);
     }
 
-    return m_CurrentPage->Allocate(sizeInBytes, alignment);
+    return allocation;
 }
 
-std::shared_ptr<UploadBuffer::Page> UploadBuffer::RequestPage()
+UploadBuffer::Page* UploadBuffer::RolloverPage(Page* fullPage)
 {
-    std::shared_ptr<Page> page;
+    Page* currentPage = fullPage;
+    if (m_CurrentPage != fullPage)
+    {
+        // Another thread already replaced the full page.
+        return m_CurrentPage;
+    }
 
-    if (!m_AvailablePages.empty())
+    Page* page = RequestSparePage();
+    if (!page)
     {
-        page = m_AvailablePages.front();
-        m_AvailablePages.pop_front();
+        page = RequestPage();
     }
-    else
+
+    if (!m_CurrentPage.compare_exchange_strong(currentPage, page))
     {
-        page = std::make_shared<Page>(m_PageSize);
-        m_PagePool.push_back(page);
+        // Another thread replaced the full page first. Keep the requested page
+        // for a later rollover and continue with the page of the other thread.
+        std::lock_guard<std::mutex> lock(m_SparePageMutex);
+
+        m_SparePages.push_back(page);
+        ++m_NumSparePages;
+
+        return currentPage;
     }
 
+    m_UsedMemory += m_PageSize;
+
     return page;
 }
 
-void UploadBuffer::Reset()
+UploadBuffer::Page* UploadBuffer::RequestSparePage()
 {
-    m_CurrentPage = nullptr;
-    // Reset all available pages.
-    m_AvailablePages = m_PagePool;
+    if (m_NumSparePages == 0)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_SparePageMutex);
+
+    if (m_SparePages.empty())
+    {
+        return nullptr;
+    }
+
+    Page* page = m_SparePages.back();
+    m_SparePages.pop_back();
+    --m_NumSparePages;
+
+    return page;
+}
+
+UploadBuffer::Page* UploadBuffer::RequestPage()
+{
+    Page* page = PopPage(m_AvailablePages);
+
+    if (!page)
+    {
+        page = RequestRingPage();
+    }
+
+    if (!page)
+    {
+        // The upload ring is full (or there is no upload ring).
+        page = new Page(m_PageSize);
+        PushPage(m_NewPages, page);
+
+        ++m_NumPages;
+        AddTotalMemoryUsage(m_PageSize);
+    }
+
+    return page;
+}
+
+UploadBuffer::Page* UploadBuffer::RequestRingPage()
+{
+    UploadRing::Block block;
+
+    if (!m_UploadRing || !m_UploadRing->AllocateBlock(block))
+    {
+        return nullptr;
+    }
+
+    Page* page = new Page(block.CPU, block.GPU, m_PageSize, block.Index);
+    PushPage(m_RingPages, page);
+
+    ++m_NumRingPages;
+
+    return page;
+}
+
+void UploadBuffer::PushPage(std::atomic<Page*>& stack, Page* page)
+{
+    page->NextPage = stack;
+    while (!stack.compare_exchange_weak(page->NextPage, page))
+    {}
+}
+
+UploadBuffer::Page* UploadBuffer::PopPage(std::atomic<Page*>& stack)
+{
+    Page* page = stack;
+    while (page && !stack.compare_exchange_weak(page, page->NextPage))
+    {}
+
+    return page;
+}
+
+void UploadBuffer::FreeRingBlocks()
+{
+    while (Page* page = PopPage(m_RingPages))
+    {
+        m_UploadRing->FreeBlock(page->RingBlockIndex);
+        delete page;
+    }
+
+    m_NumRingPages = 0;
+}
+
+void UploadBuffer::AdoptNewPages()
+{
+    while (Page* page = PopPage(m_NewPages))
+    {
+        m_PagePool.emplace_back(page);
+    }
+}
+
+uint32_t UploadBuffer::GetLargePageSizeClass(size_t sizeInBytes) const
+{
+    uint32_t sizeClass = 0;
+    for (size_t numPages = (sizeInBytes - 1) / m_PageSize; numPages > 1; numPages >>= 1)
+    {
+        ++sizeClass;
+    }
+
+    return sizeClass;
+}
+
+std::shared_ptr<UploadBuffer::Page> UploadBuffer::RequestLargePage(size_t sizeInBytes, size_t alignment)
+{
+    PagePool& availablePages = m_AvailableLargePages[GetLargePageSizeClass(sizeInBytes)];
+
+    for (auto iter = availablePages.begin(); iter != availablePages.end(); ++iter)
+    {
+        if ((*iter)->HasSpace(sizeInBytes, alignment))
+        {
+            std::shared_ptr<Page> page = *iter;
+            availablePages.erase(iter);
+
+            m_UsedMemory += page->GetPageSize();
+
+            return page;
+        }
+    }
 
-    for ( auto page : m_AvailablePages )
+    // Buffers are placed on 64KB boundaries, so round the page up to use the
+    // whole placement.
+    auto page = std::make_shared<Page>(Math::AlignUp(sizeInBytes, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+    m_LargePagePool.push_back(page);
+    m_LargePageMemoryUsage += page->GetPageSize();
+
+    AddTotalMemoryUsage(page->GetPageSize());
+    m_UsedMemory += page->GetPageSize();
+
+    return page;
+}
+
+size_t UploadBuffer::ResetPages(PagePool& pagePool, uint32_t maxIdleResets)
+{
+    size_t releasedMemory = 0;
+    PagePool pages;
+
+    for ( auto page : pagePool )
     {
         // Reset the page for new allocations.
         page->Reset();
+
+        // The page is released by the reset that makes it idle for the
+        // page decay, so a page decay of 1 releases every idle page.
+        if (maxIdleResets > 0 && page->GetNumIdleResets() >= maxIdleResets)
+        {
+            releasedMemory += page->GetPageSize();
+            ++m_NumReleasedPages;
+            ++ms_NumReleasedPages;
+        }
+        else
+        {
+            pages.push_back(page);
+        }
     }
+
+    pagePool.swap(pages);
+
+    return releasedMemory;
+}
+
+void UploadBuffer::Reset()
+{
+    m_CurrentPage = nullptr;
+
+    // The spare pages are owned by the page pool or the upload ring.
+    m_SparePages.clear();
+    m_NumSparePages = 0;
+
+    FreeRingBlocks();
+    AdoptNewPages();
+
+    m_HighWaterMark = std::max<size_t>(m_HighWaterMark, m_UsedMemory);
+    m_UsedMemory = 0;
+
+    // While the budget is exceeded, pages are released after a single idle reset.
+    uint32_t maxIdleResets = IsOverMemoryBudget() ? 1 : m_PageDecay;
+
+    size_t releasedMemory = ResetPages(m_PagePool, maxIdleResets);
+    size_t releasedLargePageMemory = ResetPages(m_LargePagePool, maxIdleResets);
+
+    m_LargePageMemoryUsage -= releasedLargePageMemory;
+    SubtractTotalMemoryUsage(releasedMemory + releasedLargePageMemory);
+
+    m_NumPages = static_cast<uint32_t>(m_PagePool.size());
+
+    // Reset all available pages. The pages are pushed in reverse order so that
+    // they are requested in the order of the page pool.
+    m_AvailablePages = nullptr;
+
+    for (auto iter = m_PagePool.rbegin(); iter != m_PagePool.rend(); ++iter)
+    {
+        PushPage(m_AvailablePages, iter->get());
+    }
+
+    m_AvailableLargePages.clear();
+
+    for ( auto page : m_LargePagePool )
+    {
+        m_AvailableLargePages[GetLargePageSizeClass(page->GetPageSize())].push_back(page);
+    }
+}
+
+UploadBufferStats UploadBuffer::GetStats() const
+{
+    UploadBufferStats stats = {};
+
+    stats.PageSize = m_PageSize;
+    stats.NumPages = m_NumPages;
+    stats.NumRingBlocks = m_NumRingPages;
+    stats.NumLargePages = static_cast<uint32_t>(m_LargePagePool.size());
+    stats.MemoryUsage = GetMemoryUsage();
+    stats.UsedMemory = m_UsedMemory;
+    stats.HighWaterMark = std::max<size_t>(m_HighWaterMark, m_UsedMemory);
+    stats.PageDecay = m_PageDecay;
+    stats.NumReleasedPages = m_NumReleasedPages;
+
+    return stats;
+}
+
+void UploadBuffer::SetMemoryBudget(size_t budgetInBytes)
+{
+    ms_MemoryBudget = budgetInBytes;
+}
+
+size_t UploadBuffer::GetMemoryBudget()
+{
+    return ms_MemoryBudget;
+}
+
+size_t UploadBuffer::GetTotalMemoryUsage()
+{
+    return ms_TotalMemoryUsage;
+}
+
+bool UploadBuffer::IsOverMemoryBudget()
+{
+    size_t budget = ms_MemoryBudget;
+
+    return budget > 0 && ms_TotalMemoryUsage > budget;
+}
+
+UploadMemoryStats UploadBuffer::GetGlobalStats()
+{
+    UploadMemoryStats stats = {};
+
+    stats.NumUploadBuffers = ms_NumUploadBuffers;
+    stats.MemoryUsage = ms_TotalMemoryUsage;
+    stats.PeakMemoryUsage = ms_PeakMemoryUsage;
+    stats.MemoryBudget = ms_MemoryBudget;
+    stats.NumReleasedPages = ms_NumReleasedPages;
+
+    return stats;
+}
+
+void UploadBuffer::AddTotalMemoryUsage(size_t sizeInBytes)
+{
+    size_t totalMemoryUsage = ms_TotalMemoryUsage += sizeInBytes;
+    size_t peakMemoryUsage = ms_PeakMemoryUsage;
+
+    while (totalMemoryUsage > peakMemoryUsage && !ms_PeakMemoryUsage.compare_exchange_weak(peakMemoryUsage, totalMemoryUsage))
+    {}
+}
+
+void UploadBuffer::SubtractTotalMemoryUsage(size_t sizeInBytes)
+{
+    ms_TotalMemoryUsage -= sizeInBytes;
 }
 
 UploadBuffer::Page::Page(size_t sizeInBytes)
-    : m_CPUPtr(nullptr)
+    : NextPage(nullptr)
+    , RingBlockIndex(UINT32_MAX)
+    , m_CPUPtr(nullptr)
     , m_GPUPtr(D3D12_GPU_VIRTUAL_ADDRESS(0))
     , m_PageSize(sizeInBytes)
     , m_Offset(0)
+    , m_NumIdleResets(0)
 {
     auto device = Application::Get().GetDevice();
 
@@ -84,9 +397,22 @@ UploadBuffer::Page::Page(size_t sizeInBytes)
     m_d3d12Resource->Map(0, nullptr, &m_CPUPtr);
 }
 
+UploadBuffer::Page::Page(void* cpuPtr, D3D12_GPU_VIRTUAL_ADDRESS gpuPtr, size_t sizeInBytes, uint32_t ringBlockIndex)
+    : NextPage(nullptr)
+    , RingBlockIndex(ringBlockIndex)
+    , m_CPUPtr(cpuPtr)
+    , m_GPUPtr(gpuPtr)
+    , m_PageSize(sizeInBytes)
+    , m_Offset(0)
+    , m_NumIdleResets(0)
+{}
+
 UploadBuffer::Page::~Page()
 {
-    m_d3d12Resource->Unmap(0, nullptr);
+    if (m_d3d12Resource)
+    {
+        m_d3d12Resource->Unmap(0, nullptr);
+    }
     m_CPUPtr = nullptr;
     m_GPUPtr = D3D12_GPU_VIRTUAL_ADDRESS(0);
 }
@@ -94,32 +420,66 @@ UploadBuffer::Page::~Page()
 bool UploadBuffer::Page::HasSpace(size_t sizeInBytes, size_t alignment) const
 {
     size_t alignedSize = Math::AlignUp(sizeInBytes, alignment);
-    size_t alignedOffset = Math::AlignUp(m_Offset, alignment);
+    size_t alignedOffset = Math::AlignUp(m_Offset.load(), alignment);
 
     return alignedOffset + alignedSize <= m_PageSize;
 }
 
-UploadBuffer::Allocation UploadBuffer::Page::Allocate(size_t sizeInBytes, size_t alignment)
+bool UploadBuffer::Page::TryAllocate(size_t sizeInBytes, size_t alignment, Allocation& allocation)
 {
-    if (!HasSpace(sizeInBytes, alignment))
+    size_t alignedSize = Math::AlignUp(sizeInBytes, alignment);
+    size_t offset = m_Offset.load(std::memory_order_relaxed);
+
+    for (;;)
     {
-        // Can't allocate space from page.
-        throw std::bad_alloc();
-    }
+        // The padding that is needed to align the allocation at the current offset.
+        size_t padding = Math::AlignUp(offset, alignment) - offset;
 
-    size_t alignedSize = Math::AlignUp(sizeInBytes, alignment);
-    m_Offset = Math::AlignUp(m_Offset, alignment);
+        if (offset + padding + alignedSize > m_PageSize)
+        {
+            return false;
+        }
+
+        size_t previousOffset = m_Offset.fetch_add(padding + alignedSize, std::memory_order_relaxed);
+        size_t alignedOffset = Math::AlignUp(previousOffset, alignment);
+
+        // Another thread may have moved the offset before the fetch-add. The
+        // reserved range can still be used if the allocation fits at the
+        // aligned offset in the range.
+        if (alignedOffset - previousOffset <= padding)
+        {
+            if (alignedOffset + alignedSize > m_PageSize)
+            {
+                // The page was filled by the other threads.
+                return false;
+            }
+
+            allocation.CPU = static_cast<uint8_t*>(m_CPUPtr) + alignedOffset;
+            allocation.GPU = m_GPUPtr + alignedOffset;
 
+            return true;
+        }
+
+        // The reserved range is wasted. Try again at the end of the range.
+        offset = previousOffset + padding + alignedSize;
+    }
+}
+
+UploadBuffer::Allocation UploadBuffer::Page::Allocate(size_t sizeInBytes, size_t alignment)
+{
     Allocation allocation;
-    allocation.CPU = static_cast<uint8_t*>(m_CPUPtr) + m_Offset;
-    allocation.GPU = m_GPUPtr + m_Offset;
 
-    m_Offset += alignedSize;
+    if (!TryAllocate(sizeInBytes, alignment, allocation))
+    {
+        // Can't allocate space from page.
+        throw std::bad_alloc();
+    }
 
     return allocation;
 }
 
 void UploadBuffer::Page::Reset()
 {
+    m_NumIdleResets = m_Offset > 0 ? 0 : m_NumIdleResets + 1;
     m_Offset = 0;
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include <DX12LibPCH.h>
+
+#include <UploadBufferStats.h>
+
+#include <sstream>
+
+std::string UploadBufferStats::ToJSON() const
+{
+    std::ostringstream stream;
+
+    stream << "{\n"
+           << "  \"PageSize\": " << PageSize << ",\n"
+           << "  \"NumPages\": " << NumPages << ",\n"
+           << "  \"NumRingBlocks\": " << NumRingBlocks << ",\n"
+           << "  \"NumLargePages\": " << NumLargePages << ",\n"
+           << "  \"MemoryUsage\": " << MemoryUsage << ",\n"
+           << "  \"UsedMemory\": " << UsedMemory << ",\n"
+           << "  \"HighWaterMark\": " << HighWaterMark << ",\n"
+           << "  \"PageDecay\": " << PageDecay << ",\n"
+           << "  \"NumReleasedPages\": " << NumReleasedPages << "\n"
+           << "}";
+
+    return stream.str();
+}
+
+std::string UploadMemoryStats::ToJSON() const
+{
+    std::ostringstream stream;
+
+    stream << "{\n"
+           << "  \"NumUploadBuffers\": " << NumUploadBuffers << ",\n"
+           << "  \"MemoryUsage\": " << MemoryUsage << ",\n"
+           << "  \"PeakMemoryUsage\": " << PeakMemoryUsage << ",\n"
+           << "  \"MemoryBudget\": " << MemoryBudget << ",\n"
+           << "  \"UploadRingMemoryUsage\": " << UploadRingMemoryUsage << ",\n"
+           << "  \"NumReleasedPages\": " << NumReleasedPages << "\n"
+           << "}";
+
+    return stream.str();
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include <DX12LibPCH.h>
+
+#include <UploadRing.h>
+
+#include <CommandQueue.h>
+
+UploadRing::UploadRing(CommandQueue& commandQueue, ComPtr<ID3D12Device2> device, size_t sizeInBytes, size_t blockSize)
+    : m_CommandQueue(commandQueue)
+    , m_d3d12Device(device)
+    , m_CPUPtr(nullptr)
+    , m_GPUPtr(D3D12_GPU_VIRTUAL_ADDRESS(0))
+    , m_BlockSize(blockSize)
+    , m_NumBlocks(static_cast<uint32_t>(std::max<size_t>(sizeInBytes / blockSize, 1)))
+{
+    for (uint32_t i = 0; i < m_NumBlocks; ++i)
+    {
+        m_AvailableBlocks.push(i);
+    }
+}
+
+UploadRing::~UploadRing()
+{
+    if (m_d3d12Resource)
+    {
+        m_d3d12Resource->Unmap(0, nullptr);
+    }
+}
+
+void UploadRing::CreateResource()
+{
+    const CD3DX12_HEAP_PROPERTIES heapProperties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+    const CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(GetSize());
+
+    ThrowIfFailed(m_d3d12Device->CreateCommittedResource(
+        &heapProperties,
+        D3D12_HEAP_FLAG_NONE,
+        &resourceDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&m_d3d12Resource)
+    ));
+
+    // The ring stays mapped for its lifetime.
+    void* cpuPtr = nullptr;
+    ThrowIfFailed(m_d3d12Resource->Map(0, nullptr, &cpuPtr));
+
+    m_CPUPtr = static_cast<uint8_t*>(cpuPtr);
+    m_GPUPtr = m_d3d12Resource->GetGPUVirtualAddress();
+}
+
+size_t UploadRing::GetMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(m_BlockMutex);
+
+    return m_d3d12Resource ? GetSize() : 0;
+}
+
+bool UploadRing::AllocateBlock(Block& block)
+{
+    std::lock_guard<std::mutex> lock(m_BlockMutex);
+
+    if (m_AvailableBlocks.empty())
+    {
+        // Only read the completed fence value that the command queue cached
+        // when it last polled its fence. Polling the fence here would also
+        // release the stale descriptors on every page rollover.
+        MoveCompletedBlocks(m_CommandQueue.GetCompletedFenceValue());
+    }
+
+    if (m_AvailableBlocks.empty())
+    {
+        return false;
+    }
+
+    if (!m_d3d12Resource)
+    {
+        CreateResource();
+    }
+
+    uint32_t blockIndex = m_AvailableBlocks.front();
+    m_AvailableBlocks.pop();
+
+    block.Index = blockIndex;
+    block.CPU = m_CPUPtr + blockIndex * m_BlockSize;
+    block.GPU = m_GPUPtr + blockIndex * m_BlockSize;
+
+    return true;
+}
+
+void UploadRing::FreeBlock(uint32_t blockIndex)
+{
+    std::lock_guard<std::mutex> lock(m_BlockMutex);
+
+    m_StaleBlocks.push(StaleBlockInfo{ blockIndex, m_CommandQueue.GetNextFenceValue() });
+}
+
+void UploadRing::ReleaseStaleBlocks(uint64_t completedFenceValue)
+{
+    std::lock_guard<std::mutex> lock(m_BlockMutex);
+
+    MoveCompletedBlocks(completedFenceValue);
+}
+
+void UploadRing::MoveCompletedBlocks(uint64_t completedFenceValue)
+{
+    while (!m_StaleBlocks.empty() && m_StaleBlocks.front().FenceValue <= completedFenceValue)
+    {
+        m_AvailableBlocks.push(m_StaleBlocks.front().BlockIndex);
+        m_StaleBlocks.pop();
+    }
+}
\ No newline at end of file